@@ -0,0 +1,38 @@
+// Durability waits (getLastError j:true and inserts flagged to wait for the log flush) are
+// served by the shared group commit flusher when the log is not synced on every commit.
+
+var t = db.group_commit;
+t.drop();
+
+var origPeriod = db.adminCommand( { getParameter : 1 , logFlushPeriod : 1 } ).logFlushPeriod;
+assert.commandWorked( db.adminCommand( { setParameter : 1 , logFlushPeriod : 100 } ) );
+
+function groupCommit() {
+    return db.serverStatus().metrics.logFlush.groupCommit;
+}
+
+var before = groupCommit();
+t.insert( { _id : 1 } );
+var res = db.runCommand( { getLastError : 1 , j : true } );
+assert.isnull( res.err , "gle j" );
+var after = groupCommit();
+assert.eq( before.waiters + 1 , after.waiters , "gle j did not wait for a flush" );
+assert.lt( before.flushes , after.flushes , "gle j did not flush" );
+assert.lte( before.commits + 1 , after.commits , "insert not flushed" );
+
+// WriteOption_WaitForLogFlush
+before = after;
+t.insert( { _id : 2 } , 1 << 30 );
+assert.eq( 2 , t.count() );
+after = groupCommit();
+assert.eq( before.waiters + 1 , after.waiters , "flagged insert did not wait for a flush" );
+
+// With a zero flush period every commit syncs and there is nothing to wait for.
+assert.commandWorked( db.adminCommand( { setParameter : 1 , logFlushPeriod : 0 } ) );
+before = groupCommit();
+t.insert( { _id : 3 } );
+assert.isnull( db.runCommand( { getLastError : 1 , j : true } ).err );
+assert.eq( before.waiters , groupCommit().waiters , "waited with a zero flush period" );
+
+assert.commandWorked( db.adminCommand( { setParameter : 1 , logFlushPeriod : origPeriod } ) );
+t.drop();
@@ -0,0 +1,48 @@
+// showLockContention ranks the row lock ranges that writers wait on most.
+
+var t = db.lock_contention;
+t.drop();
+t.insert({_id: 1});
+t.insert({_id: 2});
+assert.eq(null, db.getLastError());
+
+var params = db.adminCommand({getParameter: 1, lockTimeout: 1, lockRetries: 1});
+assert.commandWorked(db.adminCommand({setParameter: 1, lockTimeout: 50}));
+assert.commandWorked(db.adminCommand({setParameter: 1, lockRetries: 0}));
+assert.commandWorked(db.adminCommand({showLockContention: 1, reset: true}));
+
+var other = new Mongo(db.getMongo().host).getDB(db.getName());
+assert.commandWorked(other.beginTransaction());
+other.lock_contention.update({_id: 1}, {$set: {a: 1}});
+other.lock_contention.update({_id: 2}, {$set: {a: 1}});
+assert.eq(null, other.getLastError());
+
+for (var i = 0; i < 3; i++) {
+    t.update({_id: 1}, {$set: {b: i}});
+    assert.neq(null, db.getLastError());
+}
+t.update({_id: 2}, {$set: {b: 1}});
+assert.neq(null, db.getLastError());
+
+assert.commandWorked(other.commitTransaction());
+
+var res = db.adminCommand({showLockContention: 1, limit: 1});
+assert.commandWorked(res);
+assert.lte(4, res.timeouts);
+assert.eq(1, res.top.length);
+var hottest = res.top[0];
+assert.eq(t.getFullName(), hottest.ns);
+assert.lte(3, hottest.timeouts);
+assert.eq(1, hottest.bounds[0]._id);
+
+var ss = db.serverStatus().lockContention;
+assert.lte(4, ss.timeouts);
+assert.gte(5, ss.top.length);
+
+assert.commandFailed(db.adminCommand({showLockContention: 1, limit: 0}));
+assert.commandWorked(db.adminCommand({showLockContention: 1, reset: true}));
+assert.eq(0, db.adminCommand({showLockContention: 1}).events);
+
+assert.commandWorked(db.adminCommand({setParameter: 1, lockTimeout: params.lockTimeout}));
+assert.commandWorked(db.adminCommand({setParameter: 1, lockRetries: params.lockRetries}));
+t.drop();
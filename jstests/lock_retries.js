@@ -0,0 +1,59 @@
+// Single-statement writes that can't get a row lock are retried on the server, with the retries
+// counted by collection in top and by operation in the profiler.
+
+var t = db.lock_retries;
+t.drop();
+t.insert({_id: 1, n: 0});
+assert.eq(null, db.getLastError());
+
+var params = db.adminCommand({getParameter: 1, lockTimeout: 1, lockRetries: 1, lockRetryBackoff: 1});
+assert.commandWorked(db.adminCommand({setParameter: 1, lockTimeout: 100}));
+assert.commandFailed(db.adminCommand({setParameter: 1, lockRetryBackoff: 0}));
+assert.commandFailed(db.adminCommand({setParameter: 1, lockRetryBackoff: -5}));
+assert.commandFailed(db.adminCommand({setParameter: 1, lockRetryBackoff: 100000}));
+assert.commandWorked(db.adminCommand({setParameter: 1, lockRetryBackoff: 1}));
+
+function topStats() {
+    return db.adminCommand('top').totals[t.getFullName()];
+}
+
+// Hold the row lock on {_id: 1} from another connection.
+var other = new Mongo(db.getMongo().host).getDB(db.getName());
+assert.commandWorked(other.beginTransaction());
+other.lock_retries.update({_id: 1}, {$inc: {n: 1}});
+assert.eq(null, other.getLastError());
+
+// Without retries the conflict goes straight back to the client.
+assert.commandWorked(db.adminCommand({setParameter: 1, lockRetries: 0}));
+var before = topStats();
+t.update({_id: 1}, {$inc: {n: 1}});
+assert.neq(null, db.getLastError());
+var after = topStats();
+assert.eq(before.lockNotGranted.count + 1, after.lockNotGranted.count);
+assert.eq(before.lockRetries.count, after.lockRetries.count);
+
+// With retries the write is attempted once more per retry before giving up.
+assert.commandWorked(db.adminCommand({setParameter: 1, lockRetries: 2}));
+db.setProfilingLevel(2);
+before = after;
+t.update({_id: 1}, {$inc: {n: 1}});
+assert.neq(null, db.getLastError());
+after = topStats();
+db.setProfilingLevel(0);
+assert.eq(before.lockNotGranted.count + 3, after.lockNotGranted.count);
+assert.eq(before.lockRetries.count + 2, after.lockRetries.count);
+var prof = db.system.profile.find({op: 'update', ns: t.getFullName()}).sort({$natural: -1}).limit(1).next();
+assert.eq(2, prof.lockRetries);
+assert.neq(undefined, prof.lockNotGranted.bounds);
+
+// Once the other transaction commits, the write goes through.
+assert.commandWorked(other.commitTransaction());
+t.update({_id: 1}, {$inc: {n: 1}});
+assert.eq(null, db.getLastError());
+assert.eq(2, t.findOne().n);
+
+db.system.profile.drop();
+assert.commandWorked(db.adminCommand({setParameter: 1, lockTimeout: params.lockTimeout}));
+assert.commandWorked(db.adminCommand({setParameter: 1, lockRetries: params.lockRetries}));
+assert.commandWorked(db.adminCommand({setParameter: 1, lockRetryBackoff: params.lockRetryBackoff}));
+t.drop();
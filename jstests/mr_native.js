@@ -0,0 +1,87 @@
+// A reduce given as {$native: ...} runs in C++ and matches the same reduce
+// written in javascript.
+t = db.mr_native;
+t.drop();
+
+for (i = 0; i < 20000; i++) {
+    t.insert({_id : i, k : i % 53, v : i % 17, tag : "t" + (i % 5)});
+}
+assert.eq(null, db.getLastError());
+
+m = function() { emit(this.k, {n : this.v, c : 1, lo : this.v, hi : this.v, mean : this.v, tags : [this.tag]}); };
+r = function(k, vals) {
+    var res = {n : 0, c : 0, lo : vals[0].lo, hi : vals[0].hi, tags : []};
+    var sum = 0;
+    vals.forEach(function(x) {
+        res.n += x.n;
+        res.c += x.c;
+        res.lo = Math.min(res.lo, x.lo);
+        res.hi = Math.max(res.hi, x.hi);
+        sum += x.mean * x.c;
+        x.tags.forEach(function(tag) { if (res.tags.indexOf(tag) < 0) res.tags.push(tag); });
+    });
+    res.mean = sum / res.c;
+    return res;
+};
+nativeReduce = {$native : {n : "sum", c : "count", lo : "min", hi : "max", mean : "avg", tags : "addToSet"}};
+
+run = function(reduce, extra) {
+    var cmd = {mapreduce : t.getName(), map : m, reduce : reduce, out : {inline : 1}};
+    for (var key in extra) {
+        cmd[key] = extra[key];
+    }
+    var res = db.runCommand(cmd);
+    assert.commandWorked(res);
+    return res;
+};
+
+normalize = function(results) {
+    return results.map(function(x) {
+        var v = x.value;
+        return {_id : x._id, n : v.n, c : v.c, lo : v.lo, hi : v.hi,
+                mean : Math.round(v.mean * 1000), tags : v.tags.sort()};
+    }).sort(function(a, b) { return a._id - b._id; });
+};
+
+js = run(r, {});
+nat = run(nativeReduce, {});
+assert.eq(53, nat.results.length);
+assert.eq(normalize(js.results), normalize(nat.results));
+assert.eq(js.counts.emit, nat.counts.emit);
+
+// a key with a single value still gets its final form
+one = run(nativeReduce, {query : {_id : 7}}).results;
+assert.eq([{_id : 7, value : {n : 7, c : 1, lo : 7, hi : 7, mean : 7, tags : ["t2"]}}], one);
+
+// output to a collection, which goes through the inc collection, and with a finalize
+out = db.mr_native_out;
+out.drop();
+assert.commandWorked(run(nativeReduce, {out : out.getName(),
+                                        finalize : function(k, v) { v.span = v.hi - v.lo; return v; }}));
+assert.eq(normalize(js.results), normalize(out.find().toArray()));
+assert.eq(16, out.findOne({_id : 1}).value.span);
+
+// scalar values
+m = function() { emit(this.k, this.v); };
+res = run({$native : "sum"}, {out : out.getName()});
+assert.eq(20000, res.counts.input);
+assert.eq(t.find({k : 3}).toArray().reduce(function(a, x) { return a + x.v; }, 0),
+          out.findOne({_id : 3}).value);
+// every emitted value counts once, whatever number it holds
+assert.eq(378, run({$native : "count"}, {query : {k : 3}}).results[0].value);
+// partial counts, reduced by separate threads, are not taken as emitted values
+assert.eq(378, run({$native : "count"}, {query : {k : 3}, parallel : 2}).results[0].value);
+zeros = t.find({k : 0}).toArray();
+assert.close(zeros.reduce(function(a, x) { return a + x.v; }, 0) / zeros.length,
+             run({$native : "avg"}, {query : {k : {$lt : 10}}, parallel : 2}).results[0].value);
+// reducing into the existing counts
+assert.commandWorked(run({$native : "count"}, {out : out.getName()}));
+assert.commandWorked(run({$native : "count"}, {out : {reduce : out.getName()}}));
+assert.eq(756, out.findOne({_id : 3}).value);
+
+assert.commandFailed(db.runCommand({mapreduce : t.getName(), map : m, reduce : {$native : "median"}, out : {inline : 1}}));
+assert.commandFailed(db.runCommand({mapreduce : t.getName(), map : m, reduce : {$native : {"a.b" : "sum"}}, out : {inline : 1}}));
+assert.commandFailed(db.runCommand({mapreduce : t.getName(), map : m, reduce : {$native : "sum"}, jsMode : true, out : {inline : 1}}));
+
+out.drop();
+t.drop();
@@ -0,0 +1,63 @@
+// With the parallel option, the map phase runs over ranges of the primary key
+// on several threads. Results must not change.
+t = db.mr_parallel;
+t.drop();
+
+for (i = 0; i < 30000; i++) {
+    t.insert({_id : i, k : i % 97, v : i % 13, pad : "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"});
+}
+assert.eq(null, db.getLastError());
+
+m = function() { emit(this.k, {n : 1, v : this.v}); };
+r = function(k, vals) {
+    var res = {n : 0, v : 0};
+    vals.forEach(function(x) { res.n += x.n; res.v += x.v; });
+    return res;
+};
+f = function(k, res) { res.avg = res.v / res.n; return res; };
+
+run = function(extra) {
+    var cmd = {mapreduce : t.getName(), map : m, reduce : r, finalize : f, out : {inline : 1}, verbose : true};
+    for (var key in extra) {
+        cmd[key] = extra[key];
+    }
+    var res = db.runCommand(cmd);
+    assert.commandWorked(res);
+    return res;
+};
+
+serial = run({});
+parallel = run({parallel : 4});
+assert.lt(1, parallel.timing.parallelRanges);
+assert.eq(serial.counts.input, parallel.counts.input);
+assert.eq(serial.counts.emit, parallel.counts.emit);
+assert.eq(serial.results, parallel.results);
+
+// filters still apply
+serial = run({query : {v : {$lt : 5}}});
+parallel = run({query : {v : {$lt : 5}}, parallel : 4});
+assert.lt(1, parallel.timing.parallelRanges);
+assert.eq(serial.counts.input, parallel.counts.input);
+assert.eq(serial.results, parallel.results);
+
+// output to a collection, replacing and then reducing into it
+out = db.mr_parallel_out;
+out.drop();
+assert.commandWorked(run({out : out.getName(), parallel : 4}));
+assert.eq(97, out.count());
+assert.eq(30000, out.find().toArray().reduce(function(a, x) { return a + x.value.n; }, 0));
+assert.commandWorked(run({out : {reduce : out.getName()}, parallel : 4}));
+assert.eq(60000, out.find().toArray().reduce(function(a, x) { return a + x.value.n; }, 0));
+
+// a sort or a limit needs the serial map phase
+res = run({sort : {_id : 1}, limit : 100, parallel : 4});
+assert.eq(undefined, res.timing.parallelRanges);
+assert.eq(100, res.counts.input);
+
+// map and reduce functions can't reach the database
+assert.commandFailed(db.runCommand({mapreduce : t.getName(), map : function() { db.foo.findOne(); emit(1, 1); },
+                                    reduce : r, out : {inline : 1}, parallel : 4}));
+assert.commandFailed(db.runCommand({mapreduce : t.getName(), map : m, reduce : r, out : {inline : 1}, parallel : 0}));
+
+out.drop();
+t.drop();
@@ -0,0 +1,46 @@
+// Multikey index scans only dedup when the bounds allow a document to have more than one key in range.
+t = db.multikey_dedup;
+t.drop();
+t.ensureIndex({ a: 1, b: 1 });
+
+function check(query, dedup, n) {
+    e = t.find(query).hint({ a: 1, b: 1 }).explain();
+    assert(e.isMultiKey, tojson(query));
+    assert.eq(dedup, e.dedup, tojson(query));
+    assert.eq(n, e.n, tojson(query));
+    assert.eq(n, t.find(query).hint({ a: 1, b: 1 }).itcount(), tojson(query));
+}
+
+function multiKeyInserts() {
+    return t.stats().indexDetails.filter(function(o) { return o.name == "a_1_b_1"; })[0].multiKeyInserts;
+}
+
+// Only b has held an array.
+t.insert({ a: 1, b: [ 1, 2, 3 ] });
+t.insert({ a: 2, b: 1 });
+assert.eq(1, multiKeyInserts());
+check({ a: 1, b: 2 }, false, 1);
+check({ a: { $gte: 1 }, b: 2 }, false, 1);
+check({ a: 1, b: { $gte: 1 } }, true, 1);
+check({ a: 1, b: { $in: [ 1, 2 ] } }, true, 1);
+check({ a: 1 }, true, 1);
+e = t.find({ a: 1, b: { $gte: 1 } }).hint({ a: 1, b: 1 }).explain();
+assert.eq(2, e.nDups);
+
+// A single element array is not multikey.
+t.insert({ a: [ 3 ], b: 1 });
+assert.eq(1, multiKeyInserts());
+check({ a: { $gte: 1 }, b: 1 }, false, 3);
+
+// Now a has too.
+t.insert({ a: [ 4, 5 ], b: 1 });
+assert.eq(2, multiKeyInserts());
+check({ a: { $gte: 1 }, b: 1 }, true, 4);
+check({ a: 4, b: 1 }, false, 1);
+
+// Paths found while building an index are tracked as well.
+t.dropIndex({ a: 1, b: 1 });
+t.remove({ a: 1 });
+t.ensureIndex({ a: 1, b: 1 });
+check({ a: { $gte: 1 }, b: 1 }, true, 3);
+check({ a: 4, b: { $gte: 0 } }, false, 1);
@@ -0,0 +1,34 @@
+// A multi statement transaction may give an index that is already multikey a new multikey
+// path. Every path is then taken to be multikey, so index scans always dedup.
+t = db.multikey_dedup_mst;
+t.drop();
+t.ensureIndex({ a: 1, b: 1 });
+
+function dedup(query) {
+    return t.find(query).hint({ a: 1, b: 1 }).explain().dedup;
+}
+
+// Only b has held an array.
+t.insert({ a: 1, b: [ 1, 2 ] });
+assert.eq(null, db.getLastError());
+assert.eq(false, dedup({ a: 1, b: 1 }));
+
+db.beginTransaction();
+t.insert({ a: [ 2, 3 ], b: 5 });
+assert.eq(null, db.getLastError());
+assert.eq(true, dedup({ a: 1, b: 1 }));
+assert.eq(1, t.find({ a: 2, b: 5 }).hint({ a: 1, b: 1 }).itcount());
+db.rollbackTransaction();
+
+// Rolled back, but taking every path to be multikey is still right.
+assert.eq(0, t.find({ a: 2 }).itcount());
+assert.eq(true, dedup({ a: 1, b: 1 }));
+
+db.beginTransaction();
+t.insert({ a: [ 4, 5 ], b: 5 });
+assert.eq(null, db.getLastError());
+db.commitTransaction();
+assert.eq(true, dedup({ a: 4, b: 5 }));
+assert.eq(1, t.find({ a: { $gte: 4 }, b: 5 }).hint({ a: 1, b: 1 }).itcount());
+
+t.drop();
@@ -0,0 +1,51 @@
+// With partitionScanParallelism set, partitioned cursors read the partitions
+// they have yet to reach on background threads. Results must not change.
+tn = "partition_parallel_scan";
+t = db[tn];
+t.drop();
+
+assert.commandWorked(db.createCollection(tn, {partitioned:1, primaryKey : {ts:1, _id:1}}));
+t.ensureIndex({a:1});
+for (i = 0; i < 10; i++) {
+    assert.commandWorked(t.addPartition({ts: 100*i}));
+}
+for (i = 0; i < 1100; i++) {
+    t.insert({_id : i, ts : i, a : (i * 7) % 101});
+}
+assert.eq(null, db.getLastError());
+
+prefetched = function() {
+    return db.serverStatus().metrics.partitionScan.prefetched;
+}
+
+results = function() {
+    return {
+        all : t.find().toArray(),
+        reverse : t.find().sort({$natural:-1}).toArray(),
+        count : t.count(),
+        range : t.find({ts : {$gte : 250, $lt : 850}}).toArray(),
+        sorted : t.find({a : {$gte : 10}}).sort({a:1}).hint({a:1}).toArray(),
+        unsorted : t.find({a : {$gte : 10}}).hint({a:1}).toArray()
+    };
+}
+
+assert.commandWorked(db.adminCommand({setParameter : 1, partitionScanParallelism : 0}));
+serial = results();
+
+assert.commandWorked(db.adminCommand({setParameter : 1, partitionScanParallelism : 4}));
+before = prefetched();
+parallel = results();
+assert(friendlyEqual(serial, parallel));
+// prefetch threads finish in the background
+assert.soon(function() { return prefetched() > before; });
+
+// a cursor closed early leaves nothing behind
+for (i = 0; i < 20; i++) {
+    c = t.find().batchSize(2);
+    c.next();
+    c.close();
+}
+assert.eq(1100, t.find().itcount());
+
+assert.commandWorked(db.adminCommand({setParameter : 1, partitionScanParallelism : 0}));
+t.drop();
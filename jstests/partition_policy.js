@@ -0,0 +1,44 @@
+// A partitionPolicy given at creation makes a background job roll the last
+// partition over and drop the oldest ones.
+tn = "partition_policy";
+t = db[tn];
+t.drop();
+
+assert.commandFailed(db.createCollection(tn, {partitioned:1, partitionPolicy:5}));
+assert.commandFailed(db.createCollection(tn, {partitioned:1, partitionPolicy:{maxDocs:0}}));
+assert.commandFailed(db.createCollection(tn, {partitioned:1, partitionPolicy:{maxDcos:10}}));
+assert.commandWorked(db.createCollection(tn, {partitioned:1, partitionPolicy:{maxDocs:100, maxPartitions:3}}));
+
+assert.commandWorked(db.adminCommand({setParameter : 1, partitionPolicyMonitorSleepSecs : 1}));
+
+numPartitions = function() {
+    return t.getPartitionInfo().numPartitions;
+}
+// documents past the last partition's cap
+inLastPartition = function() {
+    var partitions = t.getPartitionInfo().partitions;
+    if (partitions.length == 1) {
+        return t.count();
+    }
+    return t.find({_id : {$gt : partitions[partitions.length - 2].max._id}}).itcount();
+}
+
+// Each batch is more than maxDocs, so it makes the monitor roll the last
+// partition over at least once, and the oldest partitions go once there
+// are more than maxPartitions.
+for (p = 0; p < 4; p++) {
+    for (i = 150*p; i < 150*(p+1); i++) {
+        t.insert({_id : i});
+    }
+    assert.eq(null, db.getLastError());
+    // the monitor may still be in a sleep that began before the parameter was set
+    assert.soon(function() { return inLastPartition() < 100; }, "no rollover", 90 * 1000);
+}
+assert.soon(function() { return numPartitions() <= 3; });
+assert.eq(0, t.find({_id : {$lt : 100}}).itcount());
+assert.eq(150, t.find({_id : {$gte : 450}}).itcount());
+assert.lte(4, db.serverStatus().metrics.partitionPolicy.partitionsAdded);
+assert.lte(1, db.serverStatus().metrics.partitionPolicy.partitionsDropped);
+
+assert.commandWorked(db.adminCommand({setParameter : 1, partitionPolicyMonitorSleepSecs : 60}));
+t.drop();
@@ -0,0 +1,94 @@
+// Partitions whose zone maps (the min and max of the zoneMapFields of
+// their documents) cannot match a query are skipped.
+tn = "partition_zone_maps";
+t = db[tn];
+t2 = db[tn + "_control"];
+t.drop();
+t2.drop();
+
+assert.commandFailed(db.createCollection(tn, {partitioned:1, zoneMapFields:"ts"}));
+assert.commandWorked(db.createCollection(tn, {partitioned:1, zoneMapFields:["ts", "u"]}));
+t.ensureIndex({ts:1});
+t2.ensureIndex({ts:1});
+
+// ten partitions of 100 documents, ts rises with _id
+for (p = 0; p < 10; p++) {
+    for (i = 100*p; i < 100*(p+1); i++) {
+        doc = {_id : i, ts : 1000 + i, u : i % 7};
+        t.insert(doc);
+        t2.insert(doc);
+    }
+    assert.eq(null, db.getLastError());
+    if (p < 9) {
+        assert.commandWorked(t.addPartition({_id : 100*(p+1) - 1}));
+    }
+}
+
+// capped partitions have their zone maps stored
+info = t.getPartitionInfo();
+assert.eq(10, info.numPartitions);
+assert.eq(1000, info.partitions[0].zones.ts.min);
+assert.eq(1099, info.partitions[0].zones.ts.max);
+assert.eq({min : 0, max : 6}, info.partitions[3].zones.u);
+
+byId = function(a) {
+    return a.sort(function(x, y) { return x._id - y._id; });
+}
+
+check = function(query, skipped, sort) {
+    for (hint in {ts : 1, _id : 1}) {
+        idx = {};
+        idx[hint] = 1;
+        c = t.find(query).hint(idx);
+        c2 = t2.find(query).hint(idx);
+        if (sort) {
+            c = c.sort(sort);
+            c2 = c2.sort(sort);
+        }
+        assert.eq(byId(c2.toArray()), byId(c.toArray()), tojson(query));
+        assert.eq(skipped, t.find(query).hint(idx).explain().partitionsSkipped, tojson(query) + " " + hint);
+    }
+}
+
+check({ts : {$gte : 1250, $lt : 1420}}, 7);
+check({ts : 1555}, 9);
+check({ts : {$in : [1005, 1995]}}, 8);
+check({$or : [{ts : {$lt : 1100}}, {ts : {$gt : 1900}}]}, 8);
+check({ts : {$gte : 1250, $lt : 1420}}, 7, {ts : -1});
+check({u : 3}, 0);
+check({u : 9}, 9);
+check({ts : {$gt : 5000}}, 9);
+check({}, 0);
+
+// writes to capped partitions widen their zone maps
+t.insert({_id : 150.5, ts : 5000, u : 1});
+t2.insert({_id : 150.5, ts : 5000, u : 1});
+check({ts : {$gt : 4000}}, 9);
+t.update({_id : 250}, {$set : {u : 9}});
+t2.update({_id : 250}, {$set : {u : 9}});
+check({u : 9}, 9);
+t.update({_id : 350}, {$inc : {ts : 10000}});
+t2.update({_id : 350}, {$inc : {ts : 10000}});
+check({ts : {$gt : 4000}}, 8);
+info = t.getPartitionInfo();
+assert.eq(5000, info.partitions[1].zones.ts.max);
+
+// an aborted write leaves a zone map too wide, never too narrow
+db.runCommand({beginTransaction : 1});
+t.insert({_id : 450.5, ts : 7000});
+db.runCommand({rollbackTransaction : 1});
+assert.eq(0, t.find({ts : 7000}).itcount());
+
+// arrays count each of their elements
+t.insert({_id : 451.5, ts : [1, 9000]});
+t2.insert({_id : 451.5, ts : [1, 9000]});
+check({ts : 1}, 9);
+check({ts : 9000}, 8);
+
+// dropping partitions keeps the zone maps lined up
+assert.commandWorked(t.dropPartition(info.partitions[0]._id));
+t2.remove({_id : {$lte : 99}});
+check({ts : {$gte : 1250, $lt : 1420}}, 5);
+
+t.drop();
+t2.drop();
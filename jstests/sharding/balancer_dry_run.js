@@ -0,0 +1,71 @@
+//
+// Tests that balancerDryRun proposes moves, by chunk counts and by load, without making them
+//
+
+var st = new ShardingTest({shards : 2, mongos : 1, other : {separateConfig : true}});
+
+// Keep the balancer from moving anything
+st.stopBalancer();
+
+var mongos = st.s0;
+var admin = mongos.getDB("admin");
+var coll = mongos.getCollection("foo.bar");
+
+assert(admin.runCommand({enableSharding : coll.getDB() + ""}).ok);
+admin.runCommand({movePrimary : coll.getDB() + "", to : st.shard0.shardName});
+assert(admin.runCommand({shardCollection : coll + "", key : {_id : 1}}).ok);
+
+for (var i = 0; i < 1000; i++) {
+    coll.insert({_id : i, x : "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"});
+}
+assert.eq(null, coll.getDB().getLastError());
+
+// all 21 chunks are on shard0
+for (var i = 0; i < 20; i++) {
+    assert(admin.runCommand({split : coll + "", middle : {_id : i * 50}}).ok);
+}
+
+var res = admin.runCommand({balancerDryRun : 1});
+printjson(res);
+assert.commandWorked(res);
+assert.eq("chunks", res.mode);
+assert.eq(1, res.moves.length);
+assert.eq(coll + "", res.moves[0].ns);
+assert.eq(st.shard0.shardName, res.moves[0].from);
+assert.eq(st.shard1.shardName, res.moves[0].to);
+
+res = admin.runCommand({balancerDryRun : 1, ns : coll + "", load : {ops : 2}});
+printjson(res);
+assert.commandWorked(res);
+assert.eq("load", res.mode);
+assert.eq(2, res.weights.ops);
+assert.eq(1, res.moves.length);
+assert.eq(2, res.load.length);
+res.load.forEach(function(l) {
+    if (l.shard == st.shard0.shardName) {
+        assert.eq(21, l.chunks);
+        assert.lt(0, l.dataSize);
+        assert.eq(1, l.load);
+    } else {
+        assert.eq(0, l.chunks);
+        assert.eq(0, l.load);
+    }
+});
+
+// the load weights of the balancer settings are used when none are given
+mongos.getCollection("config.settings").update({_id : "balancer"}, {$set : {load : {dataSize : 3}}}, true);
+res = admin.runCommand({balancerDryRun : 1, ns : coll + ""});
+assert.commandWorked(res);
+assert.eq("load", res.mode);
+assert.eq(3, res.weights.dataSize);
+
+assert.commandFailed(admin.runCommand({balancerDryRun : 1, load : {ops : -1}}));
+assert.commandFailed(admin.runCommand({balancerDryRun : 1, ns : 5}));
+
+// nothing moved
+assert.eq(21, mongos.getCollection("config.chunks").count({ns : coll + "", shard : st.shard0.shardName}));
+assert.eq(0, mongos.getCollection("config.changelog").count({what : /moveChunk/}));
+
+jsTest.log("DONE!");
+
+st.stop();
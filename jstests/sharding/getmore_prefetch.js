@@ -0,0 +1,70 @@
+// mongos asks a shard for its next batch before the current one runs out.
+
+var s = new ShardingTest( "getmore_prefetch" , 2 , 0 , 1 );
+s.stopBalancer();
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { x : 1 } } );
+s.adminCommand( { split : "test.foo" , middle : { x : 500 } } );
+s.adminCommand( { movechunk : "test.foo" , find : { x : 500 } ,
+                  to : s.getOther( s.getServer( "test" ) ).name , waitForDelete : true } );
+
+// Big enough that each shard's results take several batches.
+var pad = new Array( 10000 ).join( "p" );
+var db = s.getDB( "test" );
+for ( var i = 0; i < 1000; i++ ) {
+    db.foo.insert( { x : i , y : i % 7 , pad : pad } );
+}
+db.getLastError();
+
+function prefetchStats() {
+    return s.admin.runCommand( { connPoolStats : 1 } ).getMorePrefetch;
+}
+
+function checkSorted( sort , limit ) {
+    var c = db.foo.find().sort( sort );
+    if ( limit ) {
+        c = c.limit( limit );
+    }
+    var a = c.toArray();
+    assert.eq( limit || 1000 , a.length , tojson( sort ) );
+    for ( var i = 1; i < a.length; i++ ) {
+        var prev = a[i - 1], cur = a[i];
+        if ( sort.y ) {
+            assert.lte( prev.y , cur.y , tojson( sort ) );
+            if ( prev.y == cur.y ) {
+                assert.lt( prev.x , cur.x , tojson( sort ) );
+            }
+        }
+        else {
+            assert.lt( cur.x , prev.x , tojson( sort ) );
+        }
+    }
+}
+
+var before = prefetchStats();
+checkSorted( { x : -1 } );
+checkSorted( { y : 1 , x : 1 } );
+checkSorted( { y : 1 , x : 1 } , 230 );
+var after = prefetchStats();
+printjson( after );
+assert.lt( before.hits , after.hits );
+
+// A threshold of 0 turns prefetching off, and those getMores are not counted.
+s.admin.runCommand( { setParameter : 1 , shardCursorPrefetchThreshold : 0 } );
+checkSorted( { x : -1 } );
+var off = prefetchStats();
+assert.eq( after.hits , off.hits );
+assert.eq( after.misses , off.misses );
+
+// Closing a cursor with a prefetch outstanding leaves the connection usable.
+s.admin.runCommand( { setParameter : 1 , shardCursorPrefetchThreshold : 1000 } );
+for ( var i = 0; i < 20; i++ ) {
+    var c = db.foo.find().sort( { x : 1 } );
+    c.next();
+    c.close();
+}
+assert.eq( 1000 , db.foo.find().sort( { x : 1 } ).itcount() );
+assert.lt( off.wasted , prefetchStats().wasted );
+
+s.stop();
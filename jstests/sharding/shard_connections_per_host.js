@@ -0,0 +1,60 @@
+// With shardConnectionsPerHost set, mongos client threads share a bounded set of connections
+// to each shard instead of each keeping its own.
+
+var st = new ShardingTest( { shards : 2 , mongos : 1 , other : { chunksize : 1 } } );
+st.stopBalancer();
+
+var admin = st.s0.getDB( "admin" );
+var coll = st.s0.getCollection( "test.foo" );
+admin.runCommand( { enableSharding : "test" } );
+admin.runCommand( { shardCollection : "test.foo" , key : { _id : 1 } } );
+admin.runCommand( { split : "test.foo" , middle : { _id : 500 } } );
+admin.runCommand( { moveChunk : "test.foo" , find : { _id : 500 } ,
+                    to : st.shard1.shardName , _waitForDelete : true } );
+for ( var i = 0; i < 1000; i++ ) {
+    coll.insert( { _id : i } );
+}
+assert.eq( null , coll.getDB().getLastError() );
+
+var limit = 2;
+assert.commandWorked( admin.runCommand( { setParameter : 1 , shardConnectionsPerHost : limit } ) );
+
+function poolStats() {
+    return admin.runCommand( { shardConnPoolStats : 1 } );
+}
+
+function createdTo( stats , host ) {
+    var n = 0;
+    for ( var k in stats.hosts ) {
+        if ( k.indexOf( host + "::" ) == 0 ) {
+            n += stats.hosts[k].created;
+        }
+    }
+    return n;
+}
+
+var before = poolStats();
+
+var joins = [];
+for ( var i = 0; i < 8; i++ ) {
+    joins.push( startParallelShell( "for ( var j = 0; j < 50; j++ ) {" +
+                                    "    assert.eq( 1000 , db.getSiblingDB( 'test' ).foo.find().itcount() );" +
+                                    "    assert.eq( 1000 , db.getSiblingDB( 'test' ).foo.count() );" +
+                                    "}" , st.s0.port ) );
+}
+joins.forEach( function( join ) { join(); } );
+
+var after = poolStats();
+printjson( after.limits );
+assert.eq( limit , after.limits.perHost );
+
+[ st.shard0 , st.shard1 ].forEach( function( shard ) {
+    var host = shard.host;
+    var h = after.limits.hosts[host];
+    assert( h , host );
+    var overflows = h.overflows - ( before.limits.hosts[host] ? before.limits.hosts[host].overflows : 0 );
+    assert.lte( createdTo( after , host ) - createdTo( before , host ) , limit + overflows , host );
+} );
+
+admin.runCommand( { setParameter : 1 , shardConnectionsPerHost : 0 } );
+st.stop();
@@ -0,0 +1,49 @@
+// dumprestore_parallel.js
+// Restore several collections at once, each in several insert batches, with and without the
+// bulk loader.
+
+t = new ToolTest( "dumprestore_parallel" );
+
+db = t.startDB( "foo" ).getDB( "dumprestore_parallel" );
+
+var numColls = 6;
+var numDocs = 3000;
+// Big enough that each collection is inserted in more than one batch.
+var pad = new Array( 4096 ).join( "x" );
+
+for ( var i = 0; i < numColls; i++ ) {
+    var c = db.getCollection( "coll" + i );
+    for ( var j = 0; j < numDocs; j++ ) {
+        c.insert( { _id : j , coll : i , pad : pad } );
+    }
+    c.ensureIndex( { coll : 1 , _id : 1 } );
+}
+db.getLastError();
+
+t.runTool( "dump" , "--out" , t.ext );
+
+function check( msg ) {
+    for ( var i = 0; i < numColls; i++ ) {
+        var c = db.getCollection( "coll" + i );
+        assert.eq( numDocs , c.count() , msg + ": count " + i );
+        assert.eq( numDocs , c.find( { coll : i } ).hint( { coll : 1 , _id : 1 } ).itcount() ,
+                   msg + ": index " + i );
+        assert.eq( numDocs - 1 , c.find().sort( { _id : -1 } ).limit( 1 ).next()._id ,
+                   msg + ": last " + i );
+    }
+}
+
+db.dropDatabase();
+t.runTool( "restore" , "--dir" , t.ext , "--numParallelCollections" , "4" );
+check( "parallel" );
+
+db.dropDatabase();
+t.runTool( "restore" , "--dir" , t.ext , "--numParallelCollections" , "4" , "--noLoader" );
+check( "parallel without loader" );
+
+// Restoring over existing collections inserts each object once more, in batches that keep
+// going past duplicate key errors.
+t.runTool( "restore" , "--dir" , t.ext , "-j" , "1" );
+check( "serial over existing data" );
+
+t.stop();
@@ -0,0 +1,47 @@
+// dumprestore_ranges.js
+// Dump a collection as primary key ranges over several connections and restore it.
+
+t = new ToolTest( "dumprestore_ranges" );
+
+db = t.startDB( "foo" ).getDB( "dumprestore_ranges" );
+
+var numDocs = 5000;
+var pad = new Array( 1024 ).join( "x" );
+
+var c = db.big;
+for ( var i = 0; i < numDocs; i++ ) {
+    c.insert( { _id : i , pad : pad } );
+}
+db.small.insert( { _id : 1 } );
+db.createCollection( "pk" , { primaryKey : { a : 1 , _id : 1 } } );
+for ( var i = 0; i < numDocs; i++ ) {
+    db.pk.insert( { a : i % 100 , pad : pad } );
+}
+db.getLastError();
+
+t.runTool( "dump" , "--out" , t.ext , "--numParallelRanges" , "4" , "--minRangeSizeMB" , "1" );
+
+// Large collections are split into a directory of range files, small ones are not.
+var dbDir = t.ext + "/dumprestore_ranges";
+assert( listFiles( dbDir + "/big.bson" ).length > 1 , "big not split" );
+assert( listFiles( dbDir + "/pk.bson" ).length > 1 , "pk not split" );
+assert( !listFiles( dbDir ).filter( function( f ) { return f.name == dbDir + "/small.bson"; } )[0].isDirectory ,
+        "small split" );
+
+db.dropDatabase();
+t.runTool( "restore" , "--dir" , t.ext );
+
+assert.eq( numDocs , db.big.count() , "big count" );
+assert.eq( numDocs , db.big.find().sort( { _id : 1 } ).itcount() , "big itcount" );
+assert.eq( numDocs - 1 , db.big.find().sort( { _id : -1 } ).limit( 1 ).next()._id , "big last" );
+assert.eq( 1 , db.small.count() , "small count" );
+assert.eq( numDocs , db.pk.count() , "pk count" );
+assert.eq( { a : 1 , _id : 1 } , db.system.namespaces.findOne( { name : db.pk.getFullName() } ).options.primaryKey ,
+           "pk options" );
+
+// A single-collection restore reads the range directory too.
+db.big.drop();
+t.runTool( "restore" , "--db" , "dumprestore_ranges" , "--collection" , "big" , dbDir + "/big.bson" );
+assert.eq( numDocs , db.big.count() , "big count after collection restore" );
+
+t.stop();
@@ -0,0 +1,53 @@
+// import_parallel.js
+// Import with several parsing threads and insertion connections, in more than one batch.
+
+t = new ToolTest( "import_parallel" );
+
+c = t.startDB( "foo" );
+
+var numDocs = 5000;
+for ( var i = 0; i < numDocs; i++ ) {
+    c.insert( { _id : i , x : i % 7 , s : "row " + i } );
+}
+c.getDB().getLastError();
+
+t.runTool( "export" , "--out" , t.extFile , "-d" , t.baseName , "-c" , "foo" );
+
+function check( msg ) {
+    assert.eq( numDocs , c.count() , msg + ": count" );
+    assert.eq( numDocs - 1 , c.find().sort( { _id : -1 } ).limit( 1 ).next()._id , msg + ": last" );
+    assert.eq( { _id : 1234 , x : 1234 % 7 , s : "row 1234" } , c.findOne( { _id : 1234 } ) ,
+               msg + ": doc" );
+}
+
+c.drop();
+t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" ,
+           "--numParsingWorkers" , "4" );
+check( "parallel parsing, bulk load" );
+
+c.drop();
+t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" ,
+           "--numParsingWorkers" , "3" , "--numInsertionWorkers" , "4" );
+check( "parallel parsing and inserts" );
+
+// Importing over existing data keeps going past the duplicate key errors in each batch.
+t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" ,
+           "--numInsertionWorkers" , "4" );
+check( "over existing data" );
+
+// Upserts replace the existing documents.
+c.update( {} , { $set : { x : -1 } } , false , true );
+assert.eq( numDocs , c.count( { x : -1 } ) , "setup upsert" );
+t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" , "--upsert" ,
+           "--numInsertionWorkers" , "4" );
+check( "upsert" );
+assert.eq( 0 , c.count( { x : -1 } ) , "upsert replaced" );
+
+// A --jsonArray is parsed as it is read, and inserted in batches.
+t.runTool( "export" , "--out" , t.extFile , "-d" , t.baseName , "-c" , "foo" , "--jsonArray" );
+c.drop();
+t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" , "--jsonArray" ,
+           "--numInsertionWorkers" , "2" );
+check( "jsonArray" );
+
+t.stop();
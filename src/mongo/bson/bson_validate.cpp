@@ -15,19 +15,195 @@
  *    limitations under the License.
  */
 
-#include <deque>
+#include <cstring>
+#include <vector>
 
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define MONGO_BSON_VALIDATE_SSE2 1
+#endif
+
+// The AVX2 kernels are compiled with a target attribute and only used if cpuid says so, so the
+// rest of the binary doesn't need -mavx2.
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    ((defined(__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))) || \
+     (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#include <immintrin.h>
+#define MONGO_BSON_VALIDATE_AVX2 1
+#endif
+
 namespace mongo {
 
     namespace {
 
+        /**
+         * The inner loops of validation: finding the end of a c-string and skipping over the ASCII
+         * part of a string before looking at multi-byte UTF-8 sequences.  Each returns a pointer
+         * in [p, end], end meaning "not found".
+         */
+        struct ScanKernels {
+            const char* name;
+            const char* (*findNul)( const char* p, const char* end );
+            const char* (*skipASCII)( const char* p, const char* end );
+        };
+
+        const char* findNulScalar( const char* p, const char* end ) {
+            const void* x = memchr( p, 0, end - p );
+            return x ? static_cast<const char*>( x ) : end;
+        }
+
+        const char* skipASCIIScalar( const char* p, const char* end ) {
+            const uint64_t highBits = 0x8080808080808080ULL;
+            for ( ; end - p >= 8; p += 8 ) {
+                uint64_t word;
+                memcpy( &word, p, sizeof(word) );
+                if ( word & highBits )
+                    break;
+            }
+            while ( p < end && !( *p & 0x80 ) )
+                ++p;
+            return p;
+        }
+
+        const ScanKernels scalarKernels = { "scalar", findNulScalar, skipASCIIScalar };
+
+#if defined(MONGO_BSON_VALIDATE_SSE2)
+        const char* findNulSSE2( const char* p, const char* end ) {
+            // Field names are usually short, so look at the first block inline rather than paying
+            // for a call to memchr, which is already vectorized for the long ones.
+            if ( end - p >= 16 ) {
+                __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+                unsigned mask = _mm_movemask_epi8( _mm_cmpeq_epi8( block, _mm_setzero_si128() ) );
+                if ( mask )
+                    return p + __builtin_ctz( mask );
+                p += 16;
+            }
+            return findNulScalar( p, end );
+        }
+
+        const char* skipASCIISSE2( const char* p, const char* end ) {
+            for ( ; end - p >= 16; p += 16 ) {
+                __m128i block = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+                unsigned mask = _mm_movemask_epi8( block );
+                if ( mask )
+                    return p + __builtin_ctz( mask );
+            }
+            return skipASCIIScalar( p, end );
+        }
+
+        const ScanKernels sse2Kernels = { "sse2", findNulSSE2, skipASCIISSE2 };
+#endif
+
+#if defined(MONGO_BSON_VALIDATE_AVX2)
+        __attribute__((target("avx2")))
+        const char* findNulAVX2( const char* p, const char* end ) {
+            if ( end - p >= 32 ) {
+                __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+                unsigned mask = _mm256_movemask_epi8( _mm256_cmpeq_epi8( block, _mm256_setzero_si256() ) );
+                if ( mask )
+                    return p + __builtin_ctz( mask );
+                p += 32;
+            }
+            return findNulScalar( p, end );
+        }
+
+        __attribute__((target("avx2")))
+        const char* skipASCIIAVX2( const char* p, const char* end ) {
+            for ( ; end - p >= 32; p += 32 ) {
+                __m256i block = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+                unsigned mask = _mm256_movemask_epi8( block );
+                if ( mask )
+                    return p + __builtin_ctz( mask );
+            }
+            return skipASCIIScalar( p, end );
+        }
+
+        const ScanKernels avx2Kernels = { "avx2", findNulAVX2, skipASCIIAVX2 };
+#endif
+
+        const ScanKernels* selectKernels() {
+#if defined(MONGO_BSON_VALIDATE_AVX2)
+            __builtin_cpu_init();
+            if ( __builtin_cpu_supports( "avx2" ) )
+                return &avx2Kernels;
+#endif
+#if defined(MONGO_BSON_VALIDATE_SSE2)
+            return &sse2Kernels;
+#else
+            return &scalarKernels;
+#endif
+        }
+
+        const ScanKernels* bestKernels() {
+            static const ScanKernels* best = selectKernels();
+            return best;
+        }
+
+        bool forceScalarKernels = false;
+
+        inline const ScanKernels& kernels() {
+            return forceScalarKernels ? scalarKernels : *bestKernels();
+        }
+
+        /**
+         * Length of the UTF-8 sequence starting with the non-ASCII byte at p, or 0 if it is
+         * malformed: a stray continuation byte, an overlong encoding, a surrogate, a codepoint
+         * past U+10FFFF, or a sequence cut off by end.
+         */
+        int utf8SequenceLength( const unsigned char* p, const unsigned char* end ) {
+            const unsigned char c = p[0];
+            int len;
+            unsigned char lo = 0x80, hi = 0xBF; // allowed range of the second byte
+            if ( c >= 0xC2 && c <= 0xDF ) {
+                len = 2;
+            }
+            else if ( c >= 0xE0 && c <= 0xEF ) {
+                len = 3;
+                if ( c == 0xE0 ) lo = 0xA0;      // overlong
+                else if ( c == 0xED ) hi = 0x9F; // surrogates
+            }
+            else if ( c >= 0xF0 && c <= 0xF4 ) {
+                len = 4;
+                if ( c == 0xF0 ) lo = 0x90;      // overlong
+                else if ( c == 0xF4 ) hi = 0x8F; // > U+10FFFF
+            }
+            else {
+                return 0;
+            }
+            if ( end - p < len )
+                return 0;
+            if ( p[1] < lo || p[1] > hi )
+                return 0;
+            for ( int i = 2; i < len; i++ ) {
+                if ( ( p[i] & 0xC0 ) != 0x80 )
+                    return 0;
+            }
+            return len;
+        }
+
+        bool validateUTF8With( const ScanKernels& k, const char* data, uint64_t len ) {
+            const char* p = data;
+            const char* end = data + len;
+            while ( true ) {
+                p = k.skipASCII( p, end );
+                if ( p == end )
+                    return true;
+                int seq = utf8SequenceLength( reinterpret_cast<const unsigned char*>( p ),
+                                              reinterpret_cast<const unsigned char*>( end ) );
+                if ( !seq )
+                    return false;
+                p += seq;
+            }
+        }
+
         class Buffer {
         public:
-            Buffer( const char* buffer, uint64_t maxLength )
-                : _buffer( buffer ), _position( 0 ), _maxLength( maxLength ) {
+            Buffer( const char* buffer, uint64_t maxLength, bool checkUTF8 )
+                : _buffer( buffer ), _position( 0 ), _maxLength( maxLength ),
+                  _checkUTF8( checkUTF8 ), _kernels( kernels() ) {
             }
 
             template<typename N>
@@ -43,10 +219,14 @@ namespace mongo {
             }
 
             Status readCString( StringData* out ) {
-                const void* x = memchr( _buffer + _position, 0, _maxLength - _position );
-                if ( !x )
+                const char* end = _buffer + _maxLength;
+                const char* x = _kernels.findNul( _buffer + _position, end );
+                if ( x == end )
                     return Status( ErrorCodes::InvalidBSON, "no end of c-string" );
-                uint64_t len = static_cast<uint64_t>( static_cast<const char*>(x) - ( _buffer + _position ) );
+                uint64_t len = static_cast<uint64_t>( x - ( _buffer + _position ) );
+
+                if ( _checkUTF8 && !validateUTF8With( _kernels, _buffer + _position, len ) )
+                    return Status( ErrorCodes::InvalidBSON, "c-string is not valid UTF-8" );
 
                 StringData data( _buffer + _position, len );
                 _position += len + 1;
@@ -61,6 +241,8 @@ namespace mongo {
                 int sz;
                 if ( !readNumber<int>( &sz ) )
                     return Status( ErrorCodes::InvalidBSON, "invalid bson" );
+                if ( sz <= 0 )
+                    return Status( ErrorCodes::InvalidBSON, "invalid bson string length" );
 
                 if ( out ) {
                     *out = StringData( _buffer + _position, sz );
@@ -76,6 +258,9 @@ namespace mongo {
                 if ( c != 0 )
                     return Status( ErrorCodes::InvalidBSON, "not null terminate string" );
 
+                if ( _checkUTF8 && !validateUTF8With( _kernels, _buffer + _position - sz, sz - 1 ) )
+                    return Status( ErrorCodes::InvalidBSON, "string is not valid UTF-8" );
+
                 return Status::OK();
             }
 
@@ -92,6 +277,8 @@ namespace mongo {
             const char* _buffer;
             uint64_t _position;
             uint64_t _maxLength;
+            const bool _checkUTF8;
+            const ScanKernels& _kernels;
         };
 
         struct ValidationState {
@@ -127,6 +314,43 @@ namespace mongo {
             int _startPosition;
         };
 
+        /**
+         * The stack of objects being validated.  Nearly all documents nest only a few levels deep,
+         * so the first frames live inline and validating one doesn't have to allocate.
+         */
+        class ValidationFrameStack {
+        public:
+            ValidationFrameStack() : _size( 0 ) {}
+
+            ValidationObjectFrame* push() {
+                if ( _size < kInlineFrames ) {
+                    return &_inline[_size++];
+                }
+                _overflow.push_back( ValidationObjectFrame() );
+                _size++;
+                return &_overflow.back();
+            }
+
+            void pop() {
+                if ( _size > kInlineFrames ) {
+                    _overflow.pop_back();
+                }
+                _size--;
+            }
+
+            ValidationObjectFrame* back() {
+                return _size > kInlineFrames ? &_overflow.back() : &_inline[_size - 1];
+            }
+
+            bool empty() const { return _size == 0; }
+
+        private:
+            enum { kInlineFrames = 32 };
+            ValidationObjectFrame _inline[kInlineFrames];
+            std::vector<ValidationObjectFrame> _overflow;
+            size_t _size;
+        };
+
         Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState) {
             Status status = Status::OK();
 
@@ -222,15 +446,14 @@ namespace mongo {
         }
 
         Status validateBSONIterative(Buffer* buffer) {
-            std::deque<ValidationObjectFrame> frames;
+            ValidationFrameStack frames;
             ValidationObjectFrame* curr = NULL;
             ValidationState::State state = ValidationState::BeginObj;
 
             while (state != ValidationState::Done) {
                 switch (state) {
                 case ValidationState::BeginObj:
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    curr = frames.push();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(false);
                     if (!buffer->readNumber<int>(&curr->expectedSize)) {
@@ -251,12 +474,12 @@ namespace mongo {
                         return Status( ErrorCodes::InvalidBSON,
                                        "bson length doesn't match what we found" );
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty()) {
                         state = ValidationState::Done;
                     }
                     else {
-                        curr = &frames.back();
+                        curr = frames.back();
                         if (curr->isCodeWithScope())
                             state = ValidationState::EndCodeWScope;
                         else
@@ -265,8 +488,7 @@ namespace mongo {
                     break;
                 }
                 case ValidationState::BeginCodeWScope: {
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    curr = frames.push();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(true);
                     if ( !buffer->readNumber<int>( &curr->expectedSize ) )
@@ -283,10 +505,10 @@ namespace mongo {
                         return Status( ErrorCodes::InvalidBSON,
                                        "bson length for CodeWScope doesn't match what we found" );
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty())
                         return Status(ErrorCodes::InvalidBSON, "unnested CodeWScope");
-                    curr = &frames.back();
+                    curr = frames.back();
                     state = ValidationState::WithinObj;
                     break;
                 }
@@ -300,13 +522,25 @@ namespace mongo {
 
     }  // namespace
 
-    Status validateBSON( const char* originalBuffer, uint64_t maxLength ) {
+    Status validateBSON( const char* originalBuffer, uint64_t maxLength, bool checkUTF8 ) {
         if ( maxLength < 5 ) {
             return Status( ErrorCodes::InvalidBSON, "bson data has to be at least 5 bytes" );
         }
 
-        Buffer buf( originalBuffer, maxLength );
+        Buffer buf( originalBuffer, maxLength, checkUTF8 );
         return validateBSONIterative( &buf );
     }
 
+    bool validateUTF8( const char* data, uint64_t len ) {
+        return validateUTF8With( kernels(), data, len );
+    }
+
+    const char* bsonValidateImplementation() {
+        return kernels().name;
+    }
+
+    void setBSONValidateScalarOnly( bool scalarOnly ) {
+        forceScalarKernels = scalarOnly;
+    }
+
 }  // namespace mongo
@@ -28,8 +28,24 @@ namespace mongo {
      * @param buf - bson data
      * @param maxLength - maxLength of buffer
      *                    this is NOT the bson size, but how far we know the buffer is valid
+     * @param checkUTF8 - also reject element names and strings that are not well formed UTF-8
      */
-    Status validateBSON( const char* buf, uint64_t maxLength );
+    Status validateBSON( const char* buf, uint64_t maxLength, bool checkUTF8 = false );
+
+    /**
+     * @return true if the len bytes at data are well formed UTF-8: no overlong encodings,
+     *         surrogates, codepoints past U+10FFFF or truncated sequences.  NUL is allowed.
+     */
+    bool validateUTF8( const char* data, uint64_t len );
+
+    /**
+     * The string scanning code is picked once, by what the cpu supports.
+     * @return "avx2", "sse2" or "scalar"
+     */
+    const char* bsonValidateImplementation();
+
+    /** For tests and benchmarks: use the portable scalar code even if the cpu can do better. */
+    void setBSONValidateScalarOnly( bool scalarOnly );
 
 }
 
@@ -17,6 +17,7 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/platform/random.h"
 #include "mongo/bson/bson_validate.h"
+#include "mongo/util/timer.h"
 
 namespace {
 
@@ -213,4 +214,102 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
     }
 
+    TEST(BSONValidateUTF8, Strings) {
+        ASSERT_TRUE( validateUTF8( "", 0 ) );
+        ASSERT_TRUE( validateUTF8( "plain ascii", 11 ) );
+        ASSERT_TRUE( validateUTF8( "a\0b", 3 ) );
+        ASSERT_TRUE( validateUTF8( "\xc3\xa9t\xc3\xa9", 6 ) );          // U+00E9
+        ASSERT_TRUE( validateUTF8( "\xe2\x82\xac", 3 ) );               // U+20AC
+        ASSERT_TRUE( validateUTF8( "\xf0\x9f\x98\x80", 4 ) );           // U+1F600
+        ASSERT_TRUE( validateUTF8( "\xf4\x8f\xbf\xbf", 4 ) );           // U+10FFFF
+
+        ASSERT_FALSE( validateUTF8( "\x80", 1 ) );                      // stray continuation
+        ASSERT_FALSE( validateUTF8( "\xc0\xaf", 2 ) );                  // overlong
+        ASSERT_FALSE( validateUTF8( "\xe0\x80\xaf", 3 ) );              // overlong
+        ASSERT_FALSE( validateUTF8( "\xed\xa0\x80", 3 ) );              // surrogate
+        ASSERT_FALSE( validateUTF8( "\xf4\x90\x80\x80", 4 ) );          // > U+10FFFF
+        ASSERT_FALSE( validateUTF8( "\xe2\x82", 2 ) );                  // truncated
+        ASSERT_FALSE( validateUTF8( "\xe2\x82\xac", 2 ) );              // cut off by len
+    }
+
+    TEST(BSONValidateUTF8, Objects) {
+        BSONObj good = BSON( "caf\xc3\xa9" << "cr\xc3\xa8me br\xc3\xbbl\xc3\xa9e" );
+        ASSERT_OK( validateBSON( good.objdata(), good.objsize(), true ) );
+
+        BSONObj badValue = BSON( "x" << "abc\xff" );
+        ASSERT_OK( validateBSON( badValue.objdata(), badValue.objsize() ) );
+        ASSERT_NOT_OK( validateBSON( badValue.objdata(), badValue.objsize(), true ) );
+
+        BSONObj badName = BSON( "x\xc0" << 1 );
+        ASSERT_OK( validateBSON( badName.objdata(), badName.objsize() ) );
+        ASSERT_NOT_OK( validateBSON( badName.objdata(), badName.objsize(), true ) );
+    }
+
+    TEST(BSONValidateUTF8, ScalarAgrees) {
+        // Long enough strings that the vector loops run, with the bad byte at every offset.
+        PseudoRandom r( 1234 );
+        for ( int len = 1; len < 100; len++ ) {
+            string s;
+            for ( int i = 0; i < len; i++ )
+                s += 'a' + r.nextInt32( 26 );
+            for ( int bad = 0; bad < len; bad++ ) {
+                string t = s;
+                t[bad] = '\xff';
+                BSONObj x = BSON( t << t );
+                for ( int scalar = 0; scalar < 2; scalar++ ) {
+                    setBSONValidateScalarOnly( scalar );
+                    ASSERT_OK( validateBSON( x.objdata(), x.objsize() ) );
+                    ASSERT_NOT_OK( validateBSON( x.objdata(), x.objsize(), true ) );
+                    ASSERT_TRUE( validateUTF8( s.data(), s.size() ) );
+                    ASSERT_FALSE( validateUTF8( t.data(), t.size() ) );
+                }
+            }
+        }
+        setBSONValidateScalarOnly( false );
+    }
+
+    TEST(BSONValidateFast, DeeplyNested) {
+        // Deeper than the frames kept inline.
+        BSONObj x = BSON( "a" << 1 );
+        for ( int i = 0; i < 100; i++ )
+            x = BSON( "a" << x << "b" << BSON_ARRAY( i ) );
+        ASSERT_OK( validateBSON( x.objdata(), x.objsize() ) );
+        ASSERT_NOT_OK( validateBSON( x.objdata(), x.objsize() - 1 ) );
+    }
+
+    /** Validation throughput, in MB/s, for the portable code and for what this cpu picked. */
+    TEST(BSONValidateFast, Throughput) {
+        vector<BSONObj> docs;
+        long long bytes = 0;
+        for ( int i = 0; i < 1000; i++ ) {
+            BSONObjBuilder b;
+            b.append( "_id", i );
+            b.append( "name", "some user name that is reasonably long" );
+            b.append( "email", "someone@example.com" );
+            b.append( "bio", string( 200 + i % 100, 'x' ) + "caf\xc3\xa9" );
+            b.append( "tags", BSON_ARRAY( "alpha" << "beta" << "gamma" ) );
+            b.append( "address", BSON( "street" << "1 Main St" << "city" << "Springfield" ) );
+            docs.push_back( b.obj() );
+            bytes += docs.back().objsize();
+        }
+
+        const int passes = 50;
+        for ( int checkUTF8 = 0; checkUTF8 < 2; checkUTF8++ ) {
+            for ( int scalar = 1; scalar >= 0; scalar-- ) {
+                setBSONValidateScalarOnly( scalar );
+                Timer t;
+                for ( int pass = 0; pass < passes; pass++ ) {
+                    for ( size_t i = 0; i < docs.size(); i++ ) {
+                        ASSERT_OK( validateBSON( docs[i].objdata(), docs[i].objsize(), checkUTF8 ) );
+                    }
+                }
+                const long long micros = std::max( (long long) t.micros(), 1LL );
+                log() << "BSONValidate throughput (" << bsonValidateImplementation()
+                      << ( checkUTF8 ? ", utf8" : "" ) << "): "
+                      << ( bytes * passes ) / micros << " MB/s" << endl;
+            }
+        }
+        setBSONValidateScalarOnly( false );
+    }
+
 }
@@ -316,6 +316,20 @@ namespace mongo {
         }
     }
 
+    void DBConnectionPool::noteGetMore( const string& host , bool prefetched ) {
+        scoped_lock lk( _mutex );
+        PrefetchStats& stats = _prefetchStats[host];
+        if ( prefetched )
+            stats.hits++;
+        else
+            stats.misses++;
+    }
+
+    void DBConnectionPool::noteWastedPrefetch( const string& host ) {
+        scoped_lock lk( _mutex );
+        _prefetchStats[host].wasted++;
+    }
+
     void DBConnectionPool::appendInfo( BSONObjBuilder& b ) {
 
         int avail = 0;
@@ -375,6 +389,31 @@ namespace mongo {
             temp.done();
         }
 
+        {
+            long long hits = 0, misses = 0, wasted = 0;
+            BSONObjBuilder pb( b.subobjStart( "getMorePrefetch" ) );
+            BSONObjBuilder hb( pb.subobjStart( "hosts" ) );
+            {
+                scoped_lock lk( _mutex );
+                for ( map<string,PrefetchStats>::iterator i = _prefetchStats.begin(); i != _prefetchStats.end(); ++i ) {
+                    BSONObjBuilder temp( hb.subobjStart( i->first ) );
+                    temp.appendNumber( "hits" , i->second.hits );
+                    temp.appendNumber( "misses" , i->second.misses );
+                    temp.appendNumber( "wasted" , i->second.wasted );
+                    temp.done();
+
+                    hits += i->second.hits;
+                    misses += i->second.misses;
+                    wasted += i->second.wasted;
+                }
+            }
+            hb.done();
+            pb.appendNumber( "hits" , hits );
+            pb.appendNumber( "misses" , misses );
+            pb.appendNumber( "wasted" , wasted );
+            pb.done();
+        }
+
         b.append( "totalAvailable" , avail );
         b.appendNumber( "totalCreated" , created );
     }
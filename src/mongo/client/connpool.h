@@ -154,6 +154,15 @@ namespace mongo {
         void addHook( DBConnectionHook * hook ); // we take ownership
         void appendInfo( BSONObjBuilder& b );
 
+        /**
+         * Count a getMore to host by a cursor that prefetches (see DBClientCursor::setPrefetch),
+         * as a hit if it was sent before the batch was needed.
+         */
+        void noteGetMore( const string& host , bool prefetched );
+
+        /** Count a prefetched batch from host that was never read. */
+        void noteWastedPrefetch( const string& host );
+
         /**
          * Clears all connections for all host.
          */
@@ -200,10 +209,18 @@ namespace mongo {
 
         typedef map<PoolKey,PoolForHost,poolKeyCompare> PoolMap; // servername -> pool
 
+        struct PrefetchStats {
+            PrefetchStats() : hits(0), misses(0), wasted(0) {}
+            long long hits;
+            long long misses;
+            long long wasted;
+        };
+
         mongo::mutex _mutex;
         string _name;
         
         PoolMap _pools;
+        map<string,PrefetchStats> _prefetchStats; // by host
 
         // pointers owned by me, right now they leak on shutdown
         // _hooks itself also leaks because it creates a shutdown race condition
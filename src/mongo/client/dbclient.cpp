@@ -1086,6 +1086,9 @@ namespace mongo {
         if( flags & WriteOption_FromWriteback )
             reservedFlags |= Reserved_FromWriteback;
 
+        if( flags & WriteOption_WaitForLogFlush )
+            reservedFlags |= Reserved_WaitForLogFlush;
+
         b.appendNum( reservedFlags );
         b.appendStr( ns );
         obj.appendSelfToBufBuilder( b );
@@ -1110,6 +1113,11 @@ namespace mongo {
             flags ^= WriteOption_FromWriteback;
         }
 
+        if( flags & WriteOption_WaitForLogFlush ){
+            reservedFlags |= Reserved_WaitForLogFlush;
+            flags ^= WriteOption_WaitForLogFlush;
+        }
+
         b.appendNum( reservedFlags );
         b.appendStr( ns );
         for( vector< BSONObj >::const_iterator i = v.begin(); i != v.end(); ++i )
@@ -1136,6 +1144,11 @@ namespace mongo {
             flags ^= WriteOption_FromWriteback;
         }
 
+        if( flags & WriteOption_WaitForLogFlush ){
+            reservedFlags |= Reserved_WaitForLogFlush;
+            flags ^= WriteOption_WaitForLogFlush;
+        }
+
         b.appendNum( reservedFlags );
         b.appendStr( ns );
         b.appendNum( flags );
@@ -1164,6 +1177,11 @@ namespace mongo {
             flags ^= WriteOption_FromWriteback;
         }
 
+        if( flags & WriteOption_WaitForLogFlush ){
+            reservedFlags |= Reserved_WaitForLogFlush;
+            flags ^= WriteOption_WaitForLogFlush;
+        }
+
         b.appendNum( reservedFlags ); // reserved
         b.appendStr( ns );
         b.appendNum( flags );
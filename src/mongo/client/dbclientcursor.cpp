@@ -117,6 +117,15 @@ namespace mongo {
         return ok;
     }
 
+    void DBClientCursor::_assembleGetMore( Message& toSend ) {
+        BufBuilder b;
+        b.appendNum(opts);
+        b.appendStr(ns);
+        b.appendNum(nextBatchSize());
+        b.appendNum(cursorId);
+        toSend.setData(dbGetMore, b.buf(), b.len());
+    }
+
     void DBClientCursor::requestMore() {
         verify( cursorId && batch.pos == batch.nReturned );
 
@@ -124,14 +133,17 @@ namespace mongo {
             nToReturn -= batch.nReturned;
             verify(nToReturn > 0);
         }
-        BufBuilder b;
-        b.appendNum(opts);
-        b.appendStr(ns);
-        b.appendNum(nextBatchSize());
-        b.appendNum(cursorId);
+
+        if ( _prefetchConn ) {
+            _recvPrefetch();
+            return;
+        }
+        if ( _prefetchLowWater > 0 && !_client ) {
+            pool.noteGetMore( _scopedHost, false );
+        }
 
         Message toSend;
-        toSend.setData(dbGetMore, b.buf(), b.len());
+        _assembleGetMore( toSend );
         auto_ptr<Message> response(new Message());
 
         if ( _client ) {
@@ -152,6 +164,48 @@ namespace mongo {
         }
     }
 
+    void DBClientCursor::_sendPrefetch() {
+        // The getMore has to ask for what will be left of the limit after this batch, but
+        // more() keeps checking this batch against the limit as it stands until it runs out.
+        const int limit = nToReturn;
+        if ( haveLimit ) {
+            nToReturn -= batch.nReturned;
+        }
+        Message toSend;
+        _assembleGetMore( toSend );
+        nToReturn = limit;
+
+        auto_ptr<ScopedDbConnection> conn(
+                ScopedDbConnection::getScopedDbConnection( _scopedHost ) );
+        conn->get()->say( toSend );
+        _prefetchConn = conn.release();
+    }
+
+    void DBClientCursor::_recvPrefetch() {
+        scoped_ptr<ScopedDbConnection> conn( _prefetchConn );
+        _prefetchConn = 0;
+
+        auto_ptr<Message> response(new Message());
+        if ( !conn->get()->recv( *response ) ) {
+            conn->kill();
+            uasserted( 10278 , str::stream() << "dbclient error communicating with server: " << _scopedHost );
+        }
+        pool.noteGetMore( _scopedHost, true );
+
+        _client = conn->get();
+        this->batch.m = response;
+        try {
+            dataReceived();
+        }
+        catch ( ... ) {
+            _client = 0;
+            conn->done();
+            throw;
+        }
+        _client = 0;
+        conn->done();
+    }
+
     /** with QueryOption_Exhaust, the server just blasts data at us (marked at end with cursorid==0). */
     void DBClientCursor::exhaustReceiveMore() {
         verify( cursorId && batch.pos == batch.nReturned );
@@ -238,6 +292,18 @@ namespace mongo {
         batch.pos++;
         BSONObj o(batch.data);
         batch.data += o.objsize();
+
+        if ( _prefetchLowWater > 0 && batch.nReturned - batch.pos < _prefetchLowWater &&
+             cursorId && !_prefetchConn && !_client && !tailable() &&
+             !( haveLimit && batch.nReturned >= nToReturn ) ) {
+            try {
+                _sendPrefetch();
+            }
+            catch ( DBException& e ) {
+                // o is already consumed; a real problem will surface when the batch is needed
+                LOG(1) << "couldn't prefetch from " << _scopedHost << causedBy( e ) << endl;
+            }
+        }
         /* todo would be good to make data null at end of batch for safety */
         return o;
     }
@@ -321,6 +387,23 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        if ( _prefetchConn ) {
+            // Read the batch we asked for, so the connection can go back to the pool and we
+            // know whether the cursor is still open on the server.
+            scoped_ptr<ScopedDbConnection> conn( _prefetchConn );
+            _prefetchConn = 0;
+            pool.noteWastedPrefetch( _scopedHost );
+
+            Message response;
+            if ( conn->get()->recv( response ) ) {
+                cursorId = ( (QueryResult *) response.singleData() )->cursorId;
+                conn->done();
+            }
+            else {
+                conn->kill();
+            }
+        }
+
         if ( cursorId && _ownCursor && ! inShutdown() ) {
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
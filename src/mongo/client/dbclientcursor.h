@@ -29,6 +29,7 @@
 namespace mongo {
 
     class AScopedConnection;
+    class ScopedDbConnection;
 
     /** for mock purposes only -- do not create variants of DBClientCursor, nor hang code here 
         @see DBClientMockCursor
@@ -133,6 +134,14 @@ namespace mongo {
         /// Change batchSize after construction. Can change after requesting first batch.
         void setBatchSize(int newBatchSize) { batchSize = newBatchSize; }
 
+        /**
+           Send the getMore for the next batch once fewer than lowWater objects are left in
+           the current one, so the server works on it while the rest are consumed.  Only
+           attached cursors prefetch, as the pooled connection is held from sending the
+           getMore until the batch is needed.  0 (the default) turns prefetching off.
+        */
+        void setPrefetch( int lowWater ) { _prefetchLowWater = lowWater; }
+
         DBClientCursor( DBClientBase* client, const string &_ns, BSONObj _query, int _nToReturn,
                         int _nToSkip, const BSONObj *_fieldsToReturn, int queryOptions , int bs ) :
             _client(client),
@@ -147,7 +156,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(),
             _ownCursor( true ),
-            wasError( false ) {
+            wasError( false ),
+            _prefetchLowWater( 0 ),
+            _prefetchConn( 0 ) {
             _finishConsInit();
         }
 
@@ -163,7 +174,9 @@ namespace mongo {
             resultFlags(0),
             cursorId(_cursorId),
             _ownCursor(true),
-            wasError(false) {
+            wasError(false),
+            _prefetchLowWater(0),
+            _prefetchConn(0) {
             _finishConsInit();
         }
 
@@ -262,10 +275,15 @@ namespace mongo {
         string _scopedHost;
         string _lazyHost;
         bool wasError;
+        int _prefetchLowWater;
+        ScopedDbConnection* _prefetchConn; // holds the connection a prefetched getMore was sent on
 
         void dataReceived() { bool retry; string lazyHost; dataReceived( retry, lazyHost ); }
         void dataReceived( bool& retry, string& lazyHost );
         void requestMore();
+        void _assembleGetMore( Message& toSend );
+        void _sendPrefetch();
+        void _recvPrefetch();
         void exhaustReceiveMore(); // for exhaust
 
         // Don't call from a virtual function
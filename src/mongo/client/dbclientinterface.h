@@ -127,7 +127,10 @@ namespace mongo {
      */
     enum WriteOptions {
         /** logical writeback option */
-        WriteOption_FromWriteback = 1 << 31
+        WriteOption_FromWriteback = 1 << 31,
+
+        /** finish the write only once its commit is synced to the log, as getLastError j:true */
+        WriteOption_WaitForLogFlush = 1 << 30
     };
 
     //
@@ -138,7 +141,8 @@ namespace mongo {
 
     enum ReservedOptions {
         Reserved_InsertOption_ContinueOnError = 1 << 0 ,
-        Reserved_FromWriteback = 1 << 1
+        Reserved_FromWriteback = 1 << 1,
+        Reserved_WaitForLogFlush = 1 << 2
     };
 
     enum ReadPreference {
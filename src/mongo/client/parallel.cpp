@@ -23,6 +23,7 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/parallel.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -34,6 +35,10 @@ namespace mongo {
 
     LabeledLevel pc( "pcursor", 2 );
 
+    // A shard cursor asks for its next batch once fewer than this many documents are left in
+    // its current one.  0 waits for the batch to run out.
+    MONGO_EXPORT_SERVER_PARAMETER(shardCursorPrefetchThreshold, int, 32);
+
     // --------  ClusteredCursor -----------
 
     ClusteredCursor::ClusteredCursor( const QuerySpec& q ) {
@@ -386,6 +391,51 @@ namespace mongo {
         _done = true;
     }
 
+    // --------  SortedMergeHeap -----------
+
+    extern BSONObj staticNull;
+
+    SortedMergeHeap::SortedMergeHeap( const BSONObj& sortKey ) : _sortKey( sortKey.getOwned() ) {
+        BSONObjIterator i( _sortKey );
+        while ( i.more() ) {
+            BSONElement f = i.next();
+            _fields.push_back( f.fieldName() );
+            _descending.push_back( f.number() < 0 );
+        }
+    }
+
+    void SortedMergeHeap::push( int from , const BSONObj& doc ) {
+        const size_t n = _fields.size();
+        if ( _keys.size() < ( from + 1 ) * n )
+            _keys.resize( ( from + 1 ) * n );
+        for ( size_t i = 0; i < n; i++ ) {
+            BSONElement e = doc.getFieldDotted( _fields[i] );
+            _keys[ from * n + i ] = e.eoo() ? staticNull.firstElement() : e;
+        }
+
+        After after = { this };
+        _heap.push_back( from );
+        std::push_heap( _heap.begin() , _heap.end() , after );
+    }
+
+    void SortedMergeHeap::pop() {
+        After after = { this };
+        std::pop_heap( _heap.begin() , _heap.end() , after );
+        _heap.pop_back();
+    }
+
+    bool SortedMergeHeap::_before( int a , int b ) const {
+        const size_t n = _fields.size();
+        const BSONElement* l = &_keys[ a * n ];
+        const BSONElement* r = &_keys[ b * n ];
+        for ( size_t i = 0; i < n; i++ ) {
+            int x = l[i].woCompare( r[i] , false );
+            if ( x != 0 )
+                return _descending[i] ? x > 0 : x < 0;
+        }
+        return a < b;
+    }
+
     // --------  SerialServerClusteredCursor -----------
 
     SerialServerClusteredCursor::SerialServerClusteredCursor( const set<ServerAndQuery>& servers , QueryMessage& q , int sortOrder) : ClusteredCursor( q ) {
@@ -1129,6 +1179,7 @@ namespace mongo {
 
                     // Finalize state
                     state->cursor->attach( state->conn.get() ); // Closes connection for us
+                    state->cursor->setPrefetch( shardCursorPrefetchThreshold );
 
                     LOG( pc ) << "finished on shard " << shard
                         << ", current connection state is " << mdata.toBSON() << endl;
@@ -1496,6 +1547,7 @@ namespace mongo {
 
                 try {
                     _cursors[i].raw()->attach( conns[i].get() ); // this calls done on conn
+                    _cursors[i].raw()->setPrefetch( shardCursorPrefetchThreshold );
                     _checkCursor( _cursors[i].raw() );
 
                     finishedQueries++;
@@ -1599,6 +1651,11 @@ namespace mongo {
             _needToSkip = n;
         }
 
+        if ( ! _sortKey.isEmpty() ) {
+            _fillMerge();
+            return ! _merge->empty();
+        }
+
         for ( int i=0; i<_numServers; i++ ) {
             if ( _cursors[i].more() )
                 return true;
@@ -1606,7 +1663,44 @@ namespace mongo {
         return false;
     }
 
+    void ParallelSortClusteredCursor::_pushMergeHead( SortedMergeHeap& merge , int i ) {
+        if ( _cursors[i].more() )
+            merge.push( i , _cursors[i].peek() );
+        else if ( _cursors[i].rawMData() )
+            _cursors[i].rawMData()->pcState->done = true;
+    }
+
+    void ParallelSortClusteredCursor::_fillMerge() {
+        if ( ! _merge ) {
+            // only kept once every server's head is in, so that if one of them
+            // throws the next call starts over rather than merging without it
+            scoped_ptr<SortedMergeHeap> merge( new SortedMergeHeap( _sortKey ) );
+            for ( int i = 0; i < _numServers; i++ )
+                _pushMergeHead( *merge , i );
+            _merge.swap( merge );
+        }
+        else if ( _lastFrom >= 0 ) {
+            _pushMergeHead( *_merge , _lastFrom );
+        }
+        _lastFrom = -1;
+    }
+
     BSONObj ParallelSortClusteredCursor::next() {
+        if ( ! _sortKey.isEmpty() ) {
+            _fillMerge();
+            uassert( 10019 ,  "no more elements" , ! _merge->empty() );
+
+            int from = _merge->top();
+            _merge->pop();
+            BSONObj best = _cursors[from].next();
+            if( _cursors[from].rawMData() )
+                _cursors[from].rawMData()->pcState->count++;
+
+            _lastFrom = from;
+            return best;
+        }
+
+        // Unsorted, so take from each server in turn.
         BSONObj best = BSONObj();
         int bestFrom = -1;
 
@@ -1623,21 +1717,9 @@ namespace mongo {
                 continue;
             }
 
-            BSONObj me = _cursors[i].peek();
-
-            if ( best.isEmpty() ) {
-                best = me;
-                bestFrom = i;
-                if( _sortKey.isEmpty() ) break;
-                continue;
-            }
-
-            int comp = best.woSortOrder( me , _sortKey , true );
-            if ( comp < 0 )
-                continue;
-
-            best = me;
+            best = _cursors[i].peek();
             bestFrom = i;
+            break;
         }
 
         _lastFrom = bestFrom;
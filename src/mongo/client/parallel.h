@@ -159,6 +159,50 @@ namespace mongo {
         bool _done;
     };
 
+    /**
+     * Picks the next document of a merge of N sorted streams.
+     *
+     * The sort fields of each stream's head document are extracted once, when
+     * the head is pushed, and the streams are kept in a binary heap ordered by
+     * those keys, so choosing the next document costs O(log N) key comparisons
+     * instead of a woSortOrder() against every stream.  Keys compare like
+     * BSONObj::woSortOrder( other, sortKey, true ): missing fields are null.
+     *
+     * The keys point into the pushed documents, which must stay valid until
+     * their stream is popped.
+     */
+    class SortedMergeHeap : boost::noncopyable {
+    public:
+        explicit SortedMergeHeap( const BSONObj& sortKey );
+
+        /** Make doc the head of stream from, which must not already be in the heap. */
+        void push( int from , const BSONObj& doc );
+
+        bool empty() const { return _heap.empty(); }
+
+        /** The stream whose head sorts first, ties going to the lowest stream. */
+        int top() const { return _heap.front(); }
+
+        void pop();
+
+    private:
+        /** True if stream a's head sorts after stream b's, making std::*_heap a min-heap. */
+        struct After {
+            const SortedMergeHeap* merge;
+            bool operator()( int a , int b ) const { return merge->_before( b , a ); }
+        };
+
+        bool _before( int a , int b ) const;
+
+        BSONObj _sortKey;
+        vector<const char*> _fields;
+        vector<bool> _descending;
+
+        // _keys[ from * _fields.size() + i ] is field i of stream from's head
+        vector<BSONElement> _keys;
+        vector<int> _heap;
+    };
+
 
     class Servers {
     public:
@@ -368,6 +412,9 @@ namespace mongo {
         void _init();
         void _oldInit();
 
+        void _fillMerge();
+        void _pushMergeHead( SortedMergeHeap& merge , int i );
+
         virtual void _explain( map< string,list<BSONObj> >& out );
 
         void _markStaleNS( const NamespaceString& staleNS, const StaleConfigException& e, bool& forceReload, bool& fullReload );
@@ -392,6 +439,11 @@ namespace mongo {
         FilteringClientCursor * _cursors;
         int _needToSkip;
 
+        // Sorted queries merge through this, built on first use.  The stream
+        // last returned from is pushed back lazily, so a caller that stops
+        // early doesn't cause a getMore it will never read.
+        scoped_ptr<SortedMergeHeap> _merge;
+
     private:
         /**
          * Setups the shard version of the connection. When using a replica
@@ -183,6 +183,7 @@ namespace {
         clusterAdminRoleReadActions.addAction(ActionType::setShardVersion); // TODO: should this be internal?
         clusterAdminRoleReadActions.addAction(ActionType::serverStatus);
         clusterAdminRoleReadActions.addAction(ActionType::showLiveTransactions);
+        clusterAdminRoleReadActions.addAction(ActionType::showLockContention);
         clusterAdminRoleReadActions.addAction(ActionType::showPendingLockRequests);
         clusterAdminRoleReadActions.addAction(ActionType::splitVector);
         clusterAdminRoleReadActions.addAction(ActionType::shutdown);
@@ -485,6 +485,7 @@ namespace mongo {
         
         exceptionInfo.reset();
         lockNotGrantedInfo = BSONObj();
+        lockRetries = 0;
         
         executionTime = 0;
         nreturned = -1;
@@ -571,6 +572,7 @@ namespace mongo {
             }
             s << " lockNotGranted: " << expandedLockNotGrantedInfoBuilder.done();
         }
+        OPDEBUG_TOSTRING_HELP_BOOL( lockRetries );
 
         s << " ";
         curop.lockStat().report( s );
@@ -615,6 +617,11 @@ namespace mongo {
         
         if ( ! exceptionInfo.empty() ) 
             exceptionInfo.append( b , "exception" , "exceptionCode" );
+
+        if ( ! lockNotGrantedInfo.isEmpty() )
+            b.append( "lockNotGranted" , lockNotGrantedInfo );
+        if ( lockRetries )
+            b.append( "lockRetries" , lockRetries );
         
         OPDEBUG_APPEND_NUMBER( nreturned );
         OPDEBUG_APPEND_NUMBER( responseLength );
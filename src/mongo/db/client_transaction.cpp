@@ -24,6 +24,7 @@
 #include "pch.h"
 
 #include "mongo/db/client.h"
+#include "mongo/db/storage/env.h"
 
 namespace mongo {
 
@@ -56,6 +57,9 @@ namespace mongo {
         shared_ptr<TxnContext> txnToCommit = _txns.top();
         txnToCommit->commit(flags);
         pop();
+        if (_txns.empty()) {
+            storage::note_log_commit();
+        }
     }
 
     void Client::TransactionStack::commitTxn() {
@@ -164,6 +164,7 @@ namespace {
         hidden.add_options()
         ("objcheck", "inspect client data for validity on receipt (DEFAULT)")
         ("noobjcheck", "do NOT inspect client data for validity on receipt")
+        ("objcheckUTF8", "also reject client data with strings that are not valid UTF-8")
         ("traceExceptions", "log stack traces for every exception")
         ;
     }
@@ -393,6 +394,13 @@ namespace {
             }
             cmdLine.objcheck = false;
         }
+        if (params.count("objcheckUTF8")) {
+            if (!cmdLine.objcheck) {
+                out() << "--objcheckUTF8 requires --objcheck" << endl;
+                return false;
+            }
+            cmdLine.objcheckUTF8 = true;
+        }
 
         if (params.count("bind_ip")) {
             // passing in wildcard is the same as default behavior; remove and warn
@@ -89,6 +89,7 @@ namespace mongo {
 
 
         bool objcheck;         // --objcheck
+        bool objcheckUTF8;     // --objcheckUTF8
 
         int defaultProfile;    // --profile
         int slowMS;            // --time in ms that is "slow"
@@ -183,7 +184,7 @@ namespace mongo {
         configsvr(false), quota(false), quotaFiles(8), cpu(false),
         logFlushPeriod(100), // 0 means fsync every transaction, 100 means fsync log once every 100 ms
         expireOplogDays(14), expireOplogHours(0), // default of 14, two weeks
-        objcheck(true), defaultProfile(0),
+        objcheck(true), objcheckUTF8(false), defaultProfile(0),
         slowMS(100), defaultLocalThresholdMillis(15), moveParanoia( false ),
         syncdelay(60), noUnixSocket(false), doFork(0), socket("/tmp"), maxConns(DEFAULT_MAX_CONN),
         logAppend(false), logWithSyslog(false),
@@ -481,6 +481,7 @@ namespace mongo {
         _multiKeyIndexBits(0) {
 
         TOKULOG(1) << "Creating collection " << ns << endl;
+        std::fill(_multiKeyPaths, _multiKeyPaths + Collection::NIndexesMax, 0);
 
         // Create the primary key index, generating the info from the pk pattern and options.
         BSONObj info = indexInfo(_ns, pkIndexPattern, true, true, options);
@@ -494,6 +495,15 @@ namespace mongo {
         _nIndexes(serialized["indexes"].Array().size()),
         _multiKeyIndexBits(static_cast<uint64_t>(serialized["multiKeyIndexBits"].Long())){
 
+        // Multikey paths were not always tracked, assume the worst for those that weren't.
+        std::fill(_multiKeyPaths, _multiKeyPaths + Collection::NIndexesMax, ~0ULL);
+        if (serialized["multiKeyPaths"].type() == Array) {
+            std::vector<BSONElement> paths = serialized["multiKeyPaths"].Array();
+            for (size_t i = 0; i < paths.size() && i < (size_t) Collection::NIndexesMax; i++) {
+                _multiKeyPaths[i] = static_cast<uint64_t>(paths[i].numberLong());
+            }
+        }
+
         bool reserialize = false;
         std::vector<BSONElement> index_array = serialized["indexes"].Array();
         // TODO: Find out why this code is in this constructor and not the SystemUsersCollection constructor
@@ -518,6 +528,8 @@ namespace mongo {
                 // Removes the nth bit, and shifts any bits higher than it down a slot.
                 _multiKeyIndexBits = ((_multiKeyIndexBits & ((1ULL << idxNum) - 1)) |
                                       ((_multiKeyIndexBits >> (idxNum + 1)) << idxNum));
+                std::copy(_multiKeyPaths + idxNum + 1, _multiKeyPaths + Collection::NIndexesMax,
+                          _multiKeyPaths + idxNum);
                 _nIndexes--;
                 continue;
             }
@@ -535,29 +547,51 @@ namespace mongo {
 
     // Serialize the information necessary to re-open this collection later.
     BSONObj Collection::serialize(const StringData& ns, const BSONObj &options, const BSONObj &pk,
-                                      unsigned long long multiKeyIndexBits, const BSONArray &indexes_array) {
-        return BSON("ns" << ns <<
-                    "options" << options <<
-                    "pk" << pk <<
-                    "multiKeyIndexBits" << static_cast<long long>(multiKeyIndexBits) <<
-                    "indexes" << indexes_array);
+                                      unsigned long long multiKeyIndexBits, const BSONArray &indexes_array,
+                                      const BSONArray &multiKeyPaths) {
+        BSONObjBuilder b;
+        b.append("ns", ns);
+        b.append("options", options);
+        b.append("pk", pk);
+        b.append("multiKeyIndexBits", static_cast<long long>(multiKeyIndexBits));
+        b.append("indexes", indexes_array);
+        if (!multiKeyPaths.isEmpty()) {
+            b.append("multiKeyPaths", multiKeyPaths);
+        }
+        return b.obj();
     }
 
     BSONObj Collection::serialize(const bool includeHotIndex) const {
         BSONArrayBuilder indexes_array;
+        BSONArrayBuilder paths_array;
+        const unsigned long long multiKeyIndexBits = _cd->getMultiKeyIndexBits();
         // Serialize all indexes that exist, including a hot index if it exists.
         for (int i = 0; i < (includeHotIndex ? nIndexesBeingBuilt() : nIndexes()); i++) {
             IndexDetails &currIdx = idx(i);
             indexes_array.append(currIdx.info());
+            if (multiKeyIndexBits != 0) {
+                paths_array.append(static_cast<long long>(_cd->getMultiKeyPaths(i)));
+            }
         }
-        return serialize(_ns, _options, _pk, _cd->getMultiKeyIndexBits(), indexes_array.arr());
+        return serialize(_ns, _options, _pk, multiKeyIndexBits, indexes_array.arr(), paths_array.arr());
     }
 
     void Collection::noteMultiKeyChanged() {
         uassert(17329, str::stream() << _ns <<
                 ": cannot change the 'multikey' nature of an index, background index build in progress.",
                 !indexBuildInProgress());
-        collectionMap(_ns)->update_ns(_ns, serialize(), true);
+        if (cc().hasMultTxns() && !bulkLoading()) {
+            // In a multi statement transaction only the multikey paths of an index that
+            // was already multikey can change, and then to all of them, which doesn't
+            // depend on the transaction committing. Save that in a transaction of its
+            // own, so that the multi statement transaction doesn't lock the metadata.
+            Client::AlternateTransactionStack altStack;
+            Client::Transaction transaction(DB_SERIALIZABLE);
+            collectionMap(_ns)->update_ns(_ns, serialize(), true);
+            transaction.commit();
+        } else {
+            collectionMap(_ns)->update_ns(_ns, serialize(), true);
+        }
         resetTransient();
     }
 
@@ -756,7 +790,8 @@ namespace mongo {
                     }
                 }
                 if (idxKeys.size() > 1) {
-                    setIndexIsMultikey(i, indexBitChanged);
+                    setIndexIsMultikey(i, indexBitChanged, Descriptor::multiKeyPaths(idxKeys));
+                    idx.noteMultiKeyInsert();
                 }
                 // Store the keys we just generated, so we won't do it twice in
                 // the generate keys callback. See storage::generate_keys()
@@ -939,7 +974,8 @@ namespace mongo {
                     }
                 }
                 if (newIdxKeys.size() > 1) {
-                    setIndexIsMultikey(i, indexBitChanged);
+                    setIndexIsMultikey(i, indexBitChanged, Descriptor::multiKeyPaths(newIdxKeys));
+                    idx.noteMultiKeyInsert();
                 }
 
                 // Store the keys we just generated, so we won't do it twice in
@@ -996,23 +1032,29 @@ namespace mongo {
     bool CollectionBase::_allowSetMultiKeyInMSTForTests = false;
 
     // only set indexBitsChanged if true, NEVER set to false
-    void CollectionBase::setIndexIsMultikey(const int idxNum, bool* indexBitChanged) {
+    void CollectionBase::setIndexIsMultikey(const int idxNum, bool* indexBitChanged, uint64_t paths) {
         // Under no circumstasnces should the primary key become multikey.
         verify(idxNum > 0);
         dassert(idxNum < Collection::NIndexesMax);
         const unsigned long long x = ((unsigned long long) 1) << idxNum;
-        if (_multiKeyIndexBits & x) {
+        const bool wasMultiKey = _multiKeyIndexBits & x;
+        if (wasMultiKey && (paths & ~_multiKeyPaths[idxNum]) == 0) {
             *indexBitChanged = false;
             return;
         }
-        if (!bulkLoading() && !_allowSetMultiKeyInMSTForTests) {
-            uassert(17317, "Cannot transition from not multi key to multi key in multi statement transaction", !cc().hasMultTxns());
+        if (!bulkLoading() && !_allowSetMultiKeyInMSTForTests && cc().hasMultTxns()) {
+            uassert(17317, "Cannot transition from not multi key to multi key in multi statement transaction", wasMultiKey);
+            // A new multikey path for an index that is already multikey. Take every path
+            // to be multikey, which stays true whether or not the transaction commits.
+            // See noteMultiKeyChanged().
+            paths = ~0ULL;
         }
         if (!Lock::isWriteLocked(_ns)) {
             throw RetryWithWriteLock();
         }
         *indexBitChanged = true;
         _multiKeyIndexBits |= x;
+        _multiKeyPaths[idxNum] = (wasMultiKey ? _multiKeyPaths[idxNum] : 0) | paths;
     }
 
     void CollectionBase::checkIndexUniqueness(const IndexDetailsBase &idx) {
@@ -1060,6 +1102,8 @@ namespace mongo {
         // Removes the nth bit, and shifts any bits higher than it down a slot.
         _multiKeyIndexBits = ((_multiKeyIndexBits & ((1ULL << idxNum) - 1)) |
                              ((_multiKeyIndexBits >> (idxNum + 1)) << idxNum));
+        std::copy(_multiKeyPaths + idxNum + 1, _multiKeyPaths + Collection::NIndexesMax,
+                  _multiKeyPaths + idxNum);
     }
 
     void CollectionBase::acquireTableLock() {
@@ -2021,6 +2065,45 @@ namespace mongo {
         return getOplogMinUnsafeKey();
     }
 
+    // ------------------------------------------------------------------------
+
+    // Protects the map of notifiers. Notifiers themselves are never destroyed, so
+    // pointers to them stay valid once handed out.
+    static SimpleMutex tailableNotifiersMutex("tailableNotifiers");
+    static map<string, TailableNotifier *> tailableNotifiers;
+
+    TailableNotifier *TailableNotifier::get(const StringData &ns) {
+        SimpleMutex::scoped_lock lk(tailableNotifiersMutex);
+        TailableNotifier *&notifier = tailableNotifiers[ns.toString()];
+        if (notifier == NULL) {
+            notifier = new TailableNotifier();
+        }
+        return notifier;
+    }
+
+    unsigned long long TailableNotifier::version() const {
+        boost::mutex::scoped_lock lk(_mutex);
+        return _version;
+    }
+
+    bool TailableNotifier::waitForChange(unsigned long long version, int millis) {
+        const boost::system_time deadline = boost::get_system_time() +
+                                            boost::posix_time::milliseconds(millis);
+        boost::mutex::scoped_lock lk(_mutex);
+        while (_version == version) {
+            if (!_cond.timed_wait(lk, deadline)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TailableNotifier::notify() {
+        boost::mutex::scoped_lock lk(_mutex);
+        _version++;
+        _cond.notify_all();
+    }
+
     // ------------------------------------------------------------------------
     shared_ptr<PartitionedOplogCollection> PartitionedOplogCollection::make(
         const StringData &ns, 
@@ -2242,7 +2325,8 @@ namespace mongo {
         _currentObjects(0),
         _currentSize(0),
         _mutex("cappedMutex"),
-        _deleteMutex("cappedDeleteMutex") {
+        _deleteMutex("cappedDeleteMutex"),
+        _tailableNotifier(TailableNotifier::get(ns)) {
 
         // Create an _id index if "autoIndexId" is missing or it exists as true.
         if (mayIndexId) {
@@ -2260,7 +2344,8 @@ namespace mongo {
         _currentObjects(0),
         _currentSize(0),
         _mutex("cappedMutex"),
-        _deleteMutex("cappedDeleteMutex") {
+        _deleteMutex("cappedDeleteMutex"),
+        _tailableNotifier(TailableNotifier::get(_ns)) {
         
         // Determine the number of objects and the total size.
         // We'll have to look at the data, but this might not be so bad because:
@@ -2428,9 +2513,13 @@ namespace mongo {
     // minimum-PK-inserted (if there is one) from the set.
     void CappedCollection::noteComplete(const BSONObj &minPK) {
         if (!minPK.isEmpty()) {
-            SimpleMutex::scoped_lock lk(_mutex);
-            const int n = _uncommittedMinPKs.erase(minPK);
-            verify(n == 1);
+            {
+                SimpleMutex::scoped_lock lk(_mutex);
+                const int n = _uncommittedMinPKs.erase(minPK);
+                verify(n == 1);
+            }
+            // minUnsafeKey() may have advanced, wake tailable cursors
+            _tailableNotifier->notify();
         }
     }
 
@@ -2627,7 +2716,7 @@ namespace mongo {
                     checkIndexUniqueness(idx);
                 }
                 if (_multiKeyTrackers[i]->isMultiKey()) {
-                    setIndexIsMultikey(i, indexBitsChanged);
+                    setIndexIsMultikey(i, indexBitsChanged, _multiKeyTrackers[i]->multiKeyPaths());
                 }
             }
         }
@@ -2734,11 +2823,30 @@ namespace mongo {
     //
     // constructor and methods that create a PartitionedCollection
     //
+    static vector<string> getZoneMapFieldsFromOptions(const BSONObj &options) {
+        vector<string> fields;
+        const BSONElement e = options["zoneMapFields"];
+        if (e.eoo()) {
+            return fields;
+        }
+        uassert(17373, "zoneMapFields must be an array of field names", e.type() == Array);
+        for (BSONObjIterator it(e.Obj()); it.more(); ) {
+            const BSONElement field = it.next();
+            uassert(17374, str::stream() << "bad zoneMapFields entry " << field,
+                    field.type() == String && field.valuestrsize() > 1 && field.valuestr()[0] != '$');
+            fields.push_back(field.String());
+        }
+        return fields;
+    }
+
     PartitionedCollection::PartitionedCollection(const StringData &ns, const BSONObj &options) :
         CollectionData(ns, getPrimaryKeyFromOptions(options)),
         _options(options.getOwned()),
         _ordering(Ordering::make(BSONObj())), // dummy for now, we create it properly below
-        _shardKeyPattern(_pk)
+        _shardKeyPattern(_pk),
+        _zoneFields(getZoneMapFieldsFromOptions(options)),
+        _zoneMutex("PartitionedCollection::_zoneMutex"),
+        _policy(_options["partitionPolicy"])
     {
         // MUST CALL initialize directly after this.
         // We can't call initialize here because it depends on virtual functions
@@ -2784,7 +2892,10 @@ namespace mongo {
            CollectionData(serialized),
            _options(serialized["options"].Obj().getOwned()),
            _ordering(Ordering::make(BSONObj())), // dummy for now, we create it properly below
-           _shardKeyPattern(_pk)
+           _shardKeyPattern(_pk),
+           _zoneFields(getZoneMapFieldsFromOptions(_options)),
+           _zoneMutex("PartitionedCollection::_zoneMutex"),
+           _policy(_options["partitionPolicy"])
     {
     }
 
@@ -2823,6 +2934,8 @@ namespace mongo {
             getPartitionName(_ns, 0)
             );
         _partitions.push_back(openExistingPartition(currCollSerialized));        
+        // it has data we have not seen
+        _zones[0] = ZoneMap();
     }
 
     shared_ptr<PartitionedCollection> PartitionedCollection::make(const BSONObj &serialized, CollectionRenamer* renamer) {
@@ -2843,7 +2956,10 @@ namespace mongo {
         CollectionData(serialized),
         _options(serialized["options"].Obj().getOwned()),
         _ordering(Ordering::make(BSONObj())), // dummy for now, we create it properly below
-        _shardKeyPattern(_pk)
+        _shardKeyPattern(_pk),
+        _zoneFields(getZoneMapFieldsFromOptions(_options)),
+        _zoneMutex("PartitionedCollection::_zoneMutex"),
+        _policy(_options["partitionPolicy"])
     {
         // MUST CALL initialize directly after this.
         // We can't call initialize here because it depends on virtual functions
@@ -2868,6 +2984,12 @@ namespace mongo {
             // extract the pivot
             _partitionPivots.push_back(curr["max"].Obj().copy());
             _partitionIDs.push_back(currID);
+            _zones.push_back(ZoneMap(_zoneFields, curr["zones"]));
+        }
+        // The last partition's zone map is not stored as it changes,
+        // so whatever is stored for it is out of date.
+        if (!_zones.empty()) {
+            _zones.back() = ZoneMap();
         }
         // create the index details
         createIndexDetails();
@@ -2923,6 +3045,14 @@ namespace mongo {
         return false;
     }
 
+    uint64_t PartitionedCollection::getMultiKeyPaths(int idx) const {
+        uint64_t retval = 0;
+        for (uint64_t i = 0; i < numPartitions(); i++) {
+            retval |= _partitions[i]->getMultiKeyPaths(idx);
+        }
+        return retval;
+    }
+
     bool PartitionedCollection::isVisibleFromCurrentTransaction() const {
         // first, let's check that the number of partitions is the same as the number
         // this transaction sees
@@ -3121,6 +3251,7 @@ namespace mongo {
     void PartitionedCollection::sanityCheck() {
         verify(numPartitions() == _partitionPivots.size());
         verify(numPartitions() == _partitionIDs.size());
+        verify(numPartitions() == _zones.size());
         // verify that pivots are increasing in order
         for (uint64_t i = 1; i < numPartitions(); i++) {
             BSONObj bigger = _partitionPivots[i];
@@ -3164,6 +3295,7 @@ namespace mongo {
         bool foundLast = _partitions[numPartitions()-1]->getMaxPKForPartitionCap(currPK);
         uassert(storage::ASSERT_IDS::CapPartitionFailed, "can only cap a partition with no pivot if it is non-empty", foundLast);
         overwritePivot(numPartitions()-1, currPK);
+        saveZoneMapForCap(numPartitions()-1);
     }
 
     // case where user manually passes is what they want the capped value
@@ -3190,6 +3322,7 @@ namespace mongo {
                 newPivot.woCompare(currPK, _ordering) >= 0);
         }
         overwritePivot(numPartitions()-1, newPivot);
+        saveZoneMapForCap(numPartitions()-1);
     }
 
     // for pivot associated with ith partition (note, not the id),
@@ -3217,7 +3350,7 @@ namespace mongo {
         _partitionPivots[i] = newPivot.getOwned();
     }
 
-    void PartitionedCollection::appendPartition(BSONObj partitionInfo) {
+    void PartitionedCollection::appendPartition(BSONObj partitionInfo, bool created) {
         uint64_t id = partitionInfo["_id"].numberLong();
         bool indexBitChanged = false;
         _metaCollection->insertObject(partitionInfo, 0, &indexBitChanged);
@@ -3250,6 +3383,12 @@ namespace mongo {
         // add data to internal vectors
         _partitionPivots.push_back(partitionInfo["max"].Obj().copy());
         _partitionIDs.push_back(id);
+        {
+            SimpleMutex::scoped_lock lk(_zoneMutex);
+            _zones.push_back(created
+                             ? ZoneMap(_zoneFields)
+                             : ZoneMap(_zoneFields, partitionInfo["zones"]));
+        }
 
         // some sanity checks
         verify(_partitions[numPartitions()-1].get() == newPartition.get());    
@@ -3311,7 +3450,7 @@ namespace mongo {
                 }
                 cloneBSONWithFieldChanged(currWithFilledPivot, curr, "max", strippedPivot.done(), false);
             }
-            appendPartition(currWithFilledPivot.obj());
+            appendPartition(currWithFilledPivot.obj(), false);
         }
         sanityCheck();
     }
@@ -3457,6 +3596,10 @@ namespace mongo {
         // now that we have index, clean up in-memory data structures
         _partitionPivots.erase(_partitionPivots.begin() + index);
         _partitionIDs.erase(_partitionIDs.begin() + index);
+        {
+            SimpleMutex::scoped_lock lk(_zoneMutex);
+            _zones.erase(_zones.begin() + index);
+        }
         // ugly way to "drop" a collection. Perhaps we need
         // a CollectionData method for this.
         while (_partitions[index]->nIndexes() > 0) {
@@ -3587,6 +3730,174 @@ namespace mongo {
             _partitions[whichPartition]->deleteObject(newPK, newObj, flags);
             _partitions[newPartition]->insertObject(newObj, flags, indexBitChanged);
         }
+        noteZoneWrite(newPartition, newObj, false);
+    }
+
+    uint64_t PartitionedCollection::prunePartitions(const BSONObj &query, vector<bool> *partitionsToRead) const {
+        if (!hasZoneMaps()) {
+            return 0;
+        }
+        vector<ZoneMap> zones;
+        {
+            SimpleMutex::scoped_lock lk(_zoneMutex);
+            zones = _zones;
+        }
+        verify(zones.size() == partitionsToRead->size());
+        // a partition is excluded if every $or clause excludes it
+        vector<bool> excluded(zones.size(), true);
+        OrRangeGenerator org(_ns.c_str(), query, false);
+        do {
+            boost::scoped_ptr<FieldRangeSetPair> frsp(org.topFrspOriginal());
+            if (frsp->matchPossible()) {
+                // the multikey ranges, as documents may have several keys for a field
+                const FieldRangeSet &frs = frsp->frsForIndex(NULL, -1);
+                const bool special = !frsp->getSpecial().empty();
+                for (size_t i = 0; i < zones.size(); i++) {
+                    if (excluded[i] && (special || !zones[i].excludes(frs))) {
+                        excluded[i] = false;
+                    }
+                }
+            }
+            if (!org.orRangesExhausted()) {
+                org.popOrClauseSingleKey();
+            }
+        } while (!org.orRangesExhausted());
+
+        uint64_t pruned = 0;
+        uint64_t firstPruned = 0;
+        bool anyLeft = false;
+        for (uint64_t i = 0; i < partitionsToRead->size(); i++) {
+            if (!(*partitionsToRead)[i]) {
+                continue;
+            }
+            if (excluded[i]) {
+                if (pruned++ == 0) {
+                    firstPruned = i;
+                }
+                (*partitionsToRead)[i] = false;
+            }
+            else {
+                anyLeft = true;
+            }
+        }
+        if (!anyLeft && pruned > 0) {
+            // cursors still need a partition to be on
+            (*partitionsToRead)[firstPruned] = true;
+            pruned--;
+        }
+        return pruned;
+    }
+
+    void PartitionedCollection::noteZoneWrite(uint64_t i, const BSONObj &obj, bool modified) {
+        if (!hasZoneMaps()) {
+            return;
+        }
+        {
+            SimpleMutex::scoped_lock lk(_zoneMutex);
+            ZoneMap &zones = _zones[i];
+            if (!zones.known()) {
+                // nothing to keep up to date, it never prunes anything
+                return;
+            }
+            if (modified) {
+                zones.addModified(obj);
+            }
+            else {
+                zones.add(obj);
+            }
+        }
+        if (i == numPartitions() - 1) {
+            // stored when the partition is capped
+            return;
+        }
+
+        // The stored zone map must cover every committed document. It is
+        // widened in a transaction of its own, committed before the write's:
+        // a wider zone map is right whether or not the write commits, and the
+        // metadata row is then locked only while it is written, rather than
+        // until the user's (possibly multi statement) transaction ends.
+        Client::AlternateTransactionStack altStack;
+        Client::Transaction transaction(DB_SERIALIZABLE);
+        // Look at it in a snapshot first, so that only writes that widen it
+        // lock its row.
+        ZoneMap stored(_zoneFields, getPartitionMetadata(i)["zones"]);
+        if (!(modified ? stored.addModified(obj) : stored.add(obj))) {
+            return;
+        }
+        {
+            // with the row locked we see the latest committed zone map
+            Client::WithOpSettings wos(OpSettings().setQueryCursorMode(READ_LOCK_CURSOR));
+            const BSONObj metadata = getPartitionMetadata(i);
+            ZoneMap locked(_zoneFields, metadata["zones"]);
+            if (modified ? locked.addModified(obj) : locked.add(obj)) {
+                writeZoneMap(i, metadata, locked);
+            }
+        }
+        transaction.commit();
+    }
+
+    void PartitionedCollection::saveZoneMapForCap(uint64_t i) {
+        if (!hasZoneMaps()) {
+            return;
+        }
+        ZoneMap zones;
+        {
+            SimpleMutex::scoped_lock lk(_zoneMutex);
+            zones = _zones[i];
+        }
+        if (!zones.known()) {
+            zones = computeZoneMap(i);
+            SimpleMutex::scoped_lock lk(_zoneMutex);
+            _zones[i] = zones;
+        }
+        writeZoneMap(i, getPartitionMetadata(i), zones);
+    }
+
+    // Used when the partition was written to before this process opened the
+    // collection. Takes each field's range from the first and last key of
+    // an index that starts with it. We are called with cursors that take
+    // read locks, so uncommitted writes to the partition make us wait.
+    ZoneMap PartitionedCollection::computeZoneMap(uint64_t i) {
+        CollectionData *cd = _partitions[i].get();
+        ZoneMap zones(_zoneFields);
+        for (vector<string>::const_iterator f = _zoneFields.begin(); f != _zoneFields.end(); ++f) {
+            bool found = false;
+            for (int j = 0; j < cd->nIndexes() && !found; j++) {
+                IndexDetails &idx = cd->idx(j);
+                const BSONElement first = idx.keyPattern().firstElement();
+                // sparse indexes leave documents out, special ones transform keys
+                if (idx.sparse() || !first.isNumber() || *f != first.fieldName()) {
+                    continue;
+                }
+                shared_ptr<Cursor> lo = Cursor::make(cd, idx, 1, false);
+                if (!lo->ok()) {
+                    // no documents at all
+                    return ZoneMap(_zoneFields);
+                }
+                shared_ptr<Cursor> hi = Cursor::make(cd, idx, -1, false);
+                BSONObj loKey = lo->currKey();
+                BSONObj hiKey = hi->currKey();
+                if (loKey.firstElement().woCompare(hiKey.firstElement(), false) > 0) {
+                    std::swap(loKey, hiKey);
+                }
+                zones.add(*f, loKey.firstElement(), hiKey.firstElement());
+                found = true;
+            }
+            if (!found) {
+                zones.add(*f, minKey.firstElement(), maxKey.firstElement());
+            }
+        }
+        return zones;
+    }
+
+    void PartitionedCollection::writeZoneMap(uint64_t i, const BSONObj &metadata, const ZoneMap &zones) {
+        BSONObj newMetadata = cloneBSONWithFieldChanged(metadata, "zones", zones.toBSON());
+        bool indexBitChanged = false;
+        BSONObj pk = _metaCollection->getValidatedPKFromObject(metadata);
+        _metaCollection->updateObject(pk, metadata, newMetadata,
+                                      false,
+                                      0, &indexBitChanged);
+        verify(!indexBitChanged);
     }
 
     BSONObj PartitionedCollection::getUpperBound() {
@@ -30,7 +30,9 @@
 #include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/rwlock.h"
 #include "mongo/util/concurrency/simplerwlock.h"
+#include "mongo/db/partition_policy.h"
 #include "mongo/db/queryutil.h"
+#include "mongo/db/zone_map.h"
 #include "mongo/s/shardkey.h"
 
 namespace mongo {
@@ -287,6 +289,12 @@ namespace mongo {
 
         virtual bool isMultiKey(int i) const = 0;
 
+        // Mask of the key pattern positions of index i that have generated more
+        // than one key for some document, see Descriptor::multiKeyPaths().
+        // Zero if the index is not multikey. A scan that constrains each of these
+        // positions to a single value cannot see the same document twice.
+        virtual uint64_t getMultiKeyPaths(int i) const = 0;
+
         // functions that create cursors
         // table scan
         virtual shared_ptr<Cursor> makeCursor(const int direction, const bool countCursor) = 0;
@@ -413,7 +421,8 @@ namespace mongo {
 
         static BSONObj serialize(const StringData& ns, const BSONObj &options,
                                  const BSONObj &pk, unsigned long long multiKeyIndexBits,
-                                 const BSONArray &indexes_array);
+                                 const BSONArray &indexes_array,
+                                 const BSONArray &multiKeyPaths = BSONArray());
 
         // Serializes metadata to a BSONObj that can be stored on disk for later access.
         // @return a BSON representation of this Collection's state
@@ -836,7 +845,10 @@ namespace mongo {
                                       const bool fromMigrate,
                                       uint64_t flags);
         
-        void setIndexIsMultikey(const int idxNum, bool* indexBitChanged);
+        // paths are the multikey paths of the document(s) that made the index
+        // multikey. The default assumes any field may be.
+        void setIndexIsMultikey(const int idxNum, bool* indexBitChanged,
+                                uint64_t paths = ~0ULL);
 
         class IndexerBase : public CollectionIndexer {
         public:
@@ -925,6 +937,10 @@ namespace mongo {
             return (_multiKeyIndexBits & mask) != 0;
         }
 
+        uint64_t getMultiKeyPaths(int i) const {
+            return isMultiKey(i) ? _multiKeyPaths[i] : 0;
+        }
+
         bool isVisibleFromCurrentTransaction() const;
 
         // table scan
@@ -998,6 +1014,9 @@ namespace mongo {
         int _nIndexes;
 
         unsigned long long _multiKeyIndexBits;
+        // Per index multikey paths, meaningful only where the multikey bit is set.
+        // Collections serialized before these were tracked get all bits set.
+        uint64_t _multiKeyPaths[Collection::NIndexesMax];
 
         static bool _allowSetMultiKeyInMSTForTests;
     public:
@@ -1067,6 +1086,33 @@ namespace mongo {
         virtual ~TailableCollection() { }
     };
 
+    // AwaitData cursors that run out of data wait here, without holding any locks,
+    // for a tailable collection's minUnsafeKey() to advance. Notifiers are looked
+    // up by namespace because the collection may go away while a cursor waits.
+    class TailableNotifier : boost::noncopyable {
+    public:
+        // @return the notifier for ns, created on first use and never destroyed
+        static TailableNotifier *get(const StringData &ns);
+
+        // @return a version to pass to waitForChange(); read it before looking
+        //         for data so that no notification in between is missed
+        unsigned long long version() const;
+
+        // Wait up to millis for notify() to be called after version was read.
+        // @return false on timeout
+        bool waitForChange(unsigned long long version, int millis);
+
+        // Wake all waiters, since data may have become visible.
+        void notify();
+
+    private:
+        TailableNotifier() : _version(0) { }
+
+        mutable boost::mutex _mutex;
+        boost::condition_variable _cond;
+        unsigned long long _version;
+    };
+
     class NaturalOrderCollection : public CollectionBase {
     public:
         NaturalOrderCollection(const StringData &ns, const BSONObj &options);
@@ -1232,6 +1278,8 @@ namespace mongo {
         BSONObjSet _uncommittedMinPKs;
         SimpleMutex _mutex;
         SimpleMutex _deleteMutex;
+        // Notified whenever minUnsafeKey() may have advanced.
+        TailableNotifier *_tailableNotifier;
     };
 
     // Profile collections are non-replicated capped collections that
@@ -1409,6 +1457,7 @@ namespace mongo {
         virtual void insertObject(BSONObj &obj, uint64_t flags, bool* indexBitChanged) {
             uint64_t whichPartition = partitionWithRow(obj);
             _partitions[whichPartition]->insertObject(obj, flags, indexBitChanged);
+            noteZoneWrite(whichPartition, obj, false);
         }
 
         virtual void deleteObject(const BSONObj &pk, const BSONObj &obj, uint64_t flags) {
@@ -1426,6 +1475,7 @@ namespace mongo {
                                       uint64_t flags) {
             uint64_t whichPartition = partitionWithPK(pk);
             _partitions[whichPartition]->updateObjectMods(pk, updateObj, query, fastUpdateFlags, fromMigrate, flags);
+            noteZoneWrite(whichPartition, updateObj, true);
         }
 
         virtual bool rebuildIndex(int i, const BSONObj &options, BSONObjBuilder &result);
@@ -1482,6 +1532,8 @@ namespace mongo {
 
         // for now, no multikey indexes on partitioned collections
         virtual bool isMultiKey(int i) const;
+
+        virtual uint64_t getMultiKeyPaths(int i) const;
         
         virtual bool isVisibleFromCurrentTransaction() const;
 
@@ -1561,6 +1613,13 @@ namespace mongo {
             return _partitions.size();;
         }
 
+        // return the ID of the partition at offset index
+        uint64_t getPartitionID(uint64_t idx) const {
+            massert(17394, mongoutils::str::stream() << "invalid index " << idx << " for partition (max: " << numPartitions() << ")",
+                    idx < numPartitions());
+            return _partitionIDs[idx];
+        }
+
         // return the partition at offset index, note this is NOT the partition ID
         shared_ptr<CollectionData> getPartition(uint64_t idx) const{
             massert(17254, mongoutils::str::stream() << "invalid index " << idx << " for partition (max: " << numPartitions() << ")",
@@ -1576,6 +1635,25 @@ namespace mongo {
             return _metaCollection;
         }
 
+        // Zone maps are kept for the fields named by the zoneMapFields
+        // option given at creation. The zone map of a capped partition is
+        // stored in its metadata as "zones", the last partition's only
+        // in memory until it is capped. A write to a capped partition reads
+        // its zone map, and one that widens it briefly locks the metadata row
+        // to store it, in a transaction of its own.
+        bool hasZoneMaps() const {
+            return !_zoneFields.empty();
+        }
+        // Clears the entries of partitionsToRead (one per partition) whose
+        // zone maps show they hold nothing that matches query, but never
+        // all of them. Returns the number cleared.
+        uint64_t prunePartitions(const BSONObj &query, vector<bool> *partitionsToRead) const;
+
+        // from the partitionPolicy option given at creation
+        const PartitionPolicy &partitionPolicy() const {
+            return _policy;
+        }
+
         static shared_ptr<PartitionedCollection> make(const StringData &ns, const BSONObj &options);
         static shared_ptr<PartitionedCollection> make(const BSONObj &serialized, CollectionRenamer* renamer);
         static shared_ptr<PartitionedCollection> make(const BSONObj &serialized);
@@ -1607,7 +1685,9 @@ namespace mongo {
         void prepareAddPartition();
         // helper function, adds a partition as specified by partitionInfo
         // used by appendNewPartition and createPartitionsFromClone
-        void appendPartition(BSONObj partitionInfo);
+        // created is false for partitions cloned from elsewhere,
+        // whose zone maps come from partitionInfo
+        void appendPartition(BSONObj partitionInfo, bool created = true);
         // adds a partition, does NOT cap previous partition
         // So, from a user's perspective, this function only does a 
         // subset of what is needed to add a partition to the system
@@ -1627,6 +1707,14 @@ namespace mongo {
         // return upper bound
         BSONObj getUpperBound();
 
+        // zone map maintenance, obj is an update object if modified is true
+        void noteZoneWrite(uint64_t i, const BSONObj &obj, bool modified);
+        // store the zone map of partition i, now that it is being capped,
+        // computing it first if this process has not kept track of it
+        void saveZoneMapForCap(uint64_t i);
+        ZoneMap computeZoneMap(uint64_t i);
+        void writeZoneMap(uint64_t i, const BSONObj &metadata, const ZoneMap &zones);
+
 
         // options to be used when creating new partitions
         BSONObj _options;
@@ -1655,6 +1743,15 @@ namespace mongo {
 
         // for makeCursor, to determine what partitions we needto visit
         const ShardKeyPattern _shardKeyPattern;
+
+        vector<string> _zoneFields;
+        // one per partition, covering every write made through this
+        // object, including uncommitted ones. Protected by _zoneMutex
+        // since writers only hold a read lock.
+        vector<ZoneMap> _zones;
+        mutable SimpleMutex _zoneMutex;
+
+        const PartitionPolicy _policy;
     };
 
     // for legacy oplogs that were not partitioned. So we can open them just long enough
@@ -26,19 +26,26 @@
 #include "mongo/client/parallel.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/collection.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/interrupt_status_mongod.h"
+#include "mongo/db/keypattern.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/matcher.h"
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/replutil.h"
 #include "mongo/db/ops/insert.h"
 #include "mongo/db/ops/update.h"
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/s/d_chunk_manager.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/stale_exception.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
 
@@ -223,6 +230,242 @@ namespace mongo {
             _reduce( x , key , endSizeEstimate );
         }
 
+        bool NativeReducer::isNative( const BSONElement& code ) {
+            return code.type() == Object && str::equals( code.Obj().firstElementFieldName() , "$native" );
+        }
+
+        NativeReducer::NativeReducer( const BSONElement& code ) {
+            uassert( 17381 , "$native reduce takes no other fields" , code.Obj().nFields() == 1 );
+            BSONElement spec = code.Obj().firstElement();
+            if ( spec.type() == Object ) {
+                BSONObjIterator it( spec.Obj() );
+                while ( it.more() ) {
+                    BSONElement e = it.next();
+                    uassert( 17388 , str::stream() << "$native reduce field can't be dotted: " << e.fieldName() ,
+                             ! strchr( e.fieldName() , '.' ) );
+                    _fields.push_back( make_pair( string( e.fieldName() ) , parseOp( e ) ) );
+                }
+                uassert( 17389 , "$native reduce needs at least one field" , ! _fields.empty() );
+            }
+            else {
+                _fields.push_back( make_pair( string() , parseOp( spec ) ) );
+            }
+        }
+
+        NativeReducer::Op NativeReducer::parseOp( const BSONElement& e ) {
+            uassert( 17382 , str::stream() << "$native reduce op must be a string: " << e , e.type() == String );
+            const string op = e.String();
+            if ( op == "sum" )
+                return SUM;
+            if ( op == "count" )
+                return COUNT;
+            if ( op == "min" )
+                return MIN;
+            if ( op == "max" )
+                return MAX;
+            if ( op == "avg" )
+                return AVG;
+            if ( op == "addToSet" )
+                return ADD_TO_SET;
+            uasserted( 17390 , str::stream() << "unknown $native reduce op: " << op );
+            return SUM; // not reached
+        }
+
+        /**
+         * Reduces a list of tuple objects (key, value) to a single tuple {"0": key, "1": value}
+         */
+        BSONObj NativeReducer::reduce( const BSONList& tuples ) {
+            if (tuples.size() <= 1)
+                return tuples[0];
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "0" );
+            _reduce( tuples , false , false , b , "1" );
+            ++numReduces;
+            return b.obj();
+        }
+
+        /**
+         * Reduces a list of tuple object (key, value) to a single tuple {_id: key, value: val}
+         * Values stay in the form a later reduce takes, the finalizer makes them final.
+         * A single tuple is reduced too, so that every value has the same form.
+         */
+        BSONObj NativeReducer::finalReduce( const BSONList& tuples , Finalizer * finalizer ) {
+            return _finalReduce( tuples , false , finalizer );
+        }
+
+        /**
+         * The values of the output collection are final, so counts there are plain numbers.
+         */
+        BSONObj NativeReducer::reduceFinalized( const BSONList& tuples , Finalizer * finalizer ) {
+            return _finalReduce( tuples , true , finalizer );
+        }
+
+        BSONObj NativeReducer::_finalReduce( const BSONList& tuples , bool finalInputs , Finalizer * finalizer ) {
+            uassert( 10074 ,  "need values" , tuples.size() );
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "_id" );
+            _reduce( tuples , false , finalInputs , b , "value" );
+            if ( tuples.size() > 1 )
+                ++numReduces;
+            BSONObj res = b.obj();
+
+            if ( finalizer ) {
+                res = finalizer->finalize( res );
+            }
+
+            return res;
+        }
+
+        BSONObj NativeReducer::finalize( const BSONObj& tuple ) const {
+            BSONObjBuilder b;
+            b.append( tuple.firstElement() );
+            _reduce( BSONList( 1 , tuple ) , true , false , b , "value" );
+            return b.obj();
+        }
+
+        /**
+         * the accumulated value, in its final form or in the one a later reduce takes
+         */
+        static Value nativeResult( bool count , bool final , const Accumulator& accumulator ) {
+            Value v = accumulator.getValue();
+            if ( count && ! final ) {
+                // marked, so that it is not counted as one emitted value
+                MutableDocument d;
+                d.addField( "count" , v );
+                v = Value( d.freeze() );
+            }
+            return v;
+        }
+
+        void NativeReducer::_reduce( const BSONList& tuples , bool final , bool finalInputs ,
+                                     BSONObjBuilder& b , const char* fieldName ) const {
+            // avg and addToSet are always merging, what they are given is first put
+            // in the form they leave when not final
+            intrusive_ptr<ExpressionContext> ctx( ExpressionContext::create( &InterruptStatusMongod::status ) );
+            ctx->setDoingMerge( true );
+            ctx->setInShard( ! final );
+            intrusive_ptr<ExpressionFieldPath> operand( ExpressionFieldPath::create( "v" ) );
+
+            vector< intrusive_ptr<Accumulator> > accumulators;
+            for ( unsigned f = 0; f < _fields.size(); f++ ) {
+                intrusive_ptr<Accumulator> a;
+                switch ( _fields[f].second ) {
+                case SUM:
+                case COUNT:
+                    a = AccumulatorSum::create( ctx );
+                    break;
+                case MIN:
+                    a = AccumulatorMinMax::createMin( ctx );
+                    break;
+                case MAX:
+                    a = AccumulatorMinMax::createMax( ctx );
+                    break;
+                case AVG:
+                    a = AccumulatorAvg::create( ctx );
+                    break;
+                case ADD_TO_SET:
+                    a = AccumulatorAddToSet::create( ctx );
+                    break;
+                }
+                a->addOperand( operand );
+                accumulators.push_back( a );
+            }
+
+            for ( BSONList::const_iterator i = tuples.begin(); i != tuples.end(); ++i ) {
+                BSONObjIterator j( *i );
+                j.next();
+                BSONElement val = j.next();
+
+                for ( unsigned f = 0; f < _fields.size(); f++ ) {
+                    const string& name = _fields[f].first;
+                    BSONElement e;
+                    if ( name.empty() )
+                        e = val;
+                    else if ( val.type() == Object )
+                        e = val.Obj()[name];
+
+                    Value v;
+                    switch ( _fields[f].second ) {
+                    case SUM:
+                    case MIN:
+                    case MAX:
+                        if ( ! e.eoo() )
+                            v = Value( e );
+                        break;
+                    case COUNT:
+                        if ( e.type() == Object ) {
+                            BSONObj o = e.Obj();
+                            if ( o.nFields() == 1 && o["count"].isNumber() ) {
+                                // a count already made
+                                v = Value( o["count"] );
+                                break;
+                            }
+                        }
+                        if ( finalInputs && e.isNumber() )
+                            v = Value( e );
+                        else
+                            v = Value( 1 );
+                        break;
+                    case AVG:
+                        if ( e.isNumber() ) {
+                            MutableDocument d;
+                            d.addField( "subTotal" , Value( e.numberDouble() ) );
+                            d.addField( "count" , Value( 1LL ) );
+                            v = Value( d.freeze() );
+                        }
+                        else if ( e.type() == Object ) {
+                            BSONObj o = e.Obj();
+                            uassert( 17383 , str::stream() << "$native avg can't reduce " << e ,
+                                     o["subTotal"].isNumber() && o["count"].isNumber() );
+                            MutableDocument d;
+                            d.addField( "subTotal" , Value( o["subTotal"].numberDouble() ) );
+                            d.addField( "count" , Value( o["count"].numberLong() ) );
+                            v = Value( d.freeze() );
+                        }
+                        break;
+                    case ADD_TO_SET:
+                        if ( e.type() == Array )
+                            v = Value( e );
+                        else if ( ! e.eoo() )
+                            v = Value( vector<Value>( 1 , Value( e ) ) );
+                        break;
+                    }
+
+                    if ( v.missing() )
+                        continue;
+                    MutableDocument doc;
+                    doc.addField( "v" , v );
+                    accumulators[f]->evaluate( doc.freeze() );
+                }
+            }
+
+            if ( _fields[0].first.empty() ) {
+                Value v = nativeResult( _fields[0].second == COUNT , final , *accumulators[0] );
+                if ( v.missing() )
+                    b.appendNull( fieldName );
+                else
+                    v.addToBsonObj( &b , fieldName );
+                return;
+            }
+
+            BSONObjBuilder sub( b.subobjStart( fieldName ) );
+            for ( unsigned f = 0; f < _fields.size(); f++ ) {
+                Value v = nativeResult( _fields[f].second == COUNT , final , *accumulators[f] );
+                if ( v.missing() )
+                    sub.appendNull( _fields[f].first );
+                else
+                    v.addToBsonObj( &sub , _fields[f].first );
+            }
+            sub.done();
+        }
+
+        BSONObj NativeFinalizer::finalize( const BSONObj& o ) {
+            BSONObj res = _reducer.finalize( o );
+            if ( _next )
+                res = _next->finalize( res );
+            return res;
+        }
+
         Config::Config( const string& _dbname , const BSONObj& cmdObj )
         {
             dbname = _dbname;
@@ -234,6 +477,13 @@ namespace mongo {
             if (cmdObj.hasField("splitInfo"))
                 splitInfo = cmdObj["splitInfo"].Int();
 
+            parallel = 1;
+            if ( cmdObj.hasField( "parallel" ) ) {
+                BSONElement p = cmdObj["parallel"];
+                uassert( 17378 , "parallel must be a positive number" , p.isNumber() && p.numberInt() > 0 );
+                parallel = p.numberInt();
+            }
+
             jsMaxKeys = 500000;
             reduceTriggerRatio = 10.0;
             maxInMemSize = 500 * 1024;
@@ -267,9 +517,23 @@ namespace mongo {
                     scopeSetup = cmdObj["scope"].embeddedObjectUserCheck();
 
                 mapper.reset( new JSMapper( cmdObj["map"] ) );
-                reducer.reset( new JSReducer( cmdObj["reduce"] ) );
+                auto_ptr<Finalizer> jsFinalizer;
                 if ( cmdObj["finalize"].type() && cmdObj["finalize"].trueValue() )
-                    finalizer.reset( new JSFinalizer( cmdObj["finalize"] ) );
+                    jsFinalizer.reset( new JSFinalizer( cmdObj["finalize"] ) );
+                if ( NativeReducer::isNative( cmdObj["reduce"] ) ) {
+                    uassert( 17384 , "jsMode needs a javascript reduce function" , ! jsMode );
+                    NativeReducer* nativeReducer = new NativeReducer( cmdObj["reduce"] );
+                    reducer.reset( nativeReducer );
+                    // the first pass of a sharded job leaves values for mongos to reduce again
+                    if ( shardedFirstPass )
+                        finalizer.reset( jsFinalizer.release() );
+                    else
+                        finalizer.reset( new NativeFinalizer( *nativeReducer , jsFinalizer.release() ) );
+                }
+                else {
+                    reducer.reset( new JSReducer( cmdObj["reduce"] ) );
+                    finalizer.reset( jsFinalizer.release() );
+                }
 
                 if ( cmdObj["mapparams"].type() == Array ) {
                     mapParams = cmdObj["mapparams"].embeddedObjectUserCheck();
@@ -568,8 +832,8 @@ namespace mongo {
                             values.push_back( temp );
                             values.push_back( old );
                             upsert(_config.outputOptions.finalNamespace,
-                                   _config.reducer->finalReduce(values,
-                                                                _config.finalizer.get()));
+                                   _config.reducer->reduceFinalized(values,
+                                                                    _config.finalizer.get()));
                         }
                         else {
                             upsert( _config.outputOptions.finalNamespace, temp);
@@ -647,9 +911,12 @@ namespace mongo {
          * Initialize the mapreduce operation, creating the inc collection
          */
         void State::init() {
+            init( ClientBasic::getCurrent()->getAuthorizationManager()
+                                           ->getAuthenticatedPrincipalNamesToken() );
+        }
+
+        void State::init( const string& userToken ) {
             // setup js
-            const string userToken = ClientBasic::getCurrent()->getAuthorizationManager()
-                                                              ->getAuthenticatedPrincipalNamesToken();
             _scope.reset(globalScriptEngine->getPooledScope(
                             _config.dbname, "mapreduce" + userToken).release());
 
@@ -997,6 +1264,23 @@ namespace mongo {
 
         }
 
+        auto_ptr<InMemory> State::releaseInMemory() {
+            auto_ptr<InMemory> im( new InMemory() );
+            im->swap( *_temp );
+            _size = 0;
+            _dupCount = 0;
+            return im;
+        }
+
+        void State::addInMemory( const InMemory& im , long long numEmits ) {
+            for ( InMemory::const_iterator i=im.begin(); i!=im.end(); ++i ) {
+                const BSONList& all = i->second;
+                for ( BSONList::const_iterator j=all.begin(); j!=all.end(); ++j )
+                    _add( _temp.get() , *j , _size );
+            }
+            _numEmits += numEmits;
+        }
+
         /**
          * Adds object to in memory map
          */
@@ -1090,6 +1374,285 @@ namespace mongo {
             return BSONObj();
         }
 
+        // ------------  parallel map phase -----------
+
+        // threads shared by all map/reduce jobs, which also caps the parallel option
+        static const int maxParallelMapThreads = 16;
+
+        static mongo::mutex parallelMapPoolMutex("parallelMapPool");
+        static ThreadPool *parallelMapPool = NULL;
+
+        static ThreadPool &getParallelMapPool() {
+            scoped_lock lk(parallelMapPoolMutex);
+            if (parallelMapPool == NULL) {
+                // never deleted, its threads may be mid-map at shutdown
+                parallelMapPool = new ThreadPool(maxParallelMapThreads);
+            }
+            return *parallelMapPool;
+        }
+
+        /**
+         * Runs the map phase of a job over ranges of the primary key on several threads.
+         * Each thread has a State of its own, with its own pooled scope and in memory map,
+         * and reduces what it emits there.  When that map grows too large, and when the
+         * thread runs out of ranges, it hands the reduced tuples over to the job's State,
+         * which merges them on the job's thread, the only one that writes.
+         *
+         * Every range is read in a snapshot of its own, and the map and reduce functions
+         * can't reach the database, so this is only done when asked for with the parallel
+         * option, and only when the order of the documents can't matter.
+         */
+        class ParallelMap : boost::noncopyable {
+        public:
+            struct Range {
+                BSONObj start;
+                BSONObj end;
+                bool endInclusive;
+            };
+
+            /**
+             * @return false if the map phase of config's job should not run in parallel,
+             * otherwise the ranges of the primary key it should be split into
+             */
+            static bool split( const Config& config , vector<Range>* ranges ) {
+                if ( config.parallel <= 1 || config.jsMode || ! config.sort.isEmpty() || config.limit )
+                    return false;
+
+                LOCK_REASON(lockReason, "m/r: splitting for parallel emit phase");
+                Client::ReadContext ctx(config.ns, lockReason);
+                Collection *cl = getCollection(config.ns);
+                if ( cl == NULL || cl->isPartitioned() || cl->isCapped() || ! cl->getPKIndex().clustering() )
+                    return false;
+
+                // about four ranges per thread, so threads that got the quick ones
+                // can take over the rest
+                const long long nRanges = 4 * std::min( config.parallel , maxParallelMapThreads );
+                CollectionData::Stats stats;
+                cl->fillCollectionStats(stats, NULL, 1);
+                // splitVector aims for half of the size it is given
+                const long long chunkSize = 2 * std::max( (long long) stats.size / nRanges , 64LL << 10 );
+
+                vector<BSONObj> splitPoints;
+                findSplitPoints(cl, cl->getPKIndex(), chunkSize, nRanges - 1, splitPoints);
+                if ( splitPoints.empty() )
+                    return false;
+
+                KeyPattern kp( cl->getPKIndex().keyPattern() );
+                BSONObj start = KeyPattern::toKeyFormat( kp.extendRangeBound( BSONObj() , false ) );
+                for ( vector<BSONObj>::const_iterator it = splitPoints.begin(); it != splitPoints.end(); ++it ) {
+                    Range r;
+                    r.start = start;
+                    r.end = KeyPattern::toKeyFormat( *it );
+                    r.endInclusive = false;
+                    ranges->push_back( r );
+                    start = r.end;
+                }
+                Range last;
+                last.start = start;
+                last.end = KeyPattern::toKeyFormat( kp.extendRangeBound( BSONObj() , true ) );
+                last.endInclusive = true;
+                ranges->push_back( last );
+                return true;
+            }
+
+            ParallelMap( const string& dbname , const BSONObj& cmd ,
+                         const ShardChunkManagerPtr& chunkManager , const vector<Range>& ranges ) :
+                _dbname( dbname ),
+                _cmd( cmd.getOwned() ),
+                _userToken( ClientBasic::getCurrent()->getAuthorizationManager()
+                                                     ->getAuthenticatedPrincipalNamesToken() ),
+                _chunkManager( chunkManager ),
+                _mutex( "ParallelMap" ),
+                _ranges( ranges.begin() , ranges.end() ),
+                _running( 0 ),
+                _cancelled( false ),
+                _reduces( 0 ) {
+            }
+
+            static void start( const shared_ptr<ParallelMap>& pm , int nThreads ) {
+                ThreadPool &pool = getParallelMapPool();
+                nThreads = std::min( nThreads , maxParallelMapThreads );
+                nThreads = std::min( nThreads , (int) pm->_ranges.size() );
+                {
+                    scoped_lock lk( pm->_mutex );
+                    pm->_running = nThreads;
+                }
+                for ( int i = 0; i < nThreads; i++ ) {
+                    pool.schedule( &ParallelMap::run , pm );
+                }
+            }
+
+            /**
+             * Merges what the threads hand over into state until they are all done.
+             * @return the number of documents mapped
+             */
+            long long merge( State& state , ProgressMeterHolder& pm ) {
+                long long num = 0;
+                while ( true ) {
+                    Output out;
+                    {
+                        scoped_lock lk( _mutex );
+                        if ( _output.empty() && _running > 0 && _error.empty() ) {
+                            // wake now and then to notice the job being killed
+                            _cond.timed_wait( lk.boost() , boost::posix_time::milliseconds( 100 ) );
+                        }
+                        uassert( 17379 , str::stream() << "parallel map failed: " << _error , _error.empty() );
+                        if ( _output.empty() && _running == 0 ) {
+                            break;
+                        }
+                        if ( ! _output.empty() ) {
+                            out = _output.front();
+                            _output.pop_front();
+                        }
+                    }
+                    killCurrentOp.checkForInterrupt();
+                    if ( ! out.im ) {
+                        continue;
+                    }
+                    state.addInMemory( *out.im , out.emits );
+                    state.checkSize();
+                    num += out.input;
+                    pm.hit( out.input );
+                }
+                state._config.reducer->numReduces += _reduces;
+                return num;
+            }
+
+            /**
+             * stops the threads and waits for them, they may still be mapping when the job fails
+             */
+            void cancel() {
+                scoped_lock lk( _mutex );
+                _cancelled = true;
+                _ranges.clear();
+                _output.clear();
+                while ( _running > 0 ) {
+                    _cond.wait( lk.boost() );
+                }
+            }
+
+        private:
+            struct Output {
+                shared_ptr<InMemory> im;
+                long long emits;
+                long long input;
+            };
+
+            static void run( shared_ptr<ParallelMap> pm ) {
+                if ( ! haveClient() ) {
+                    Client::initThread( "mapreduce" );
+                }
+                try {
+                    pm->mapRanges();
+                }
+                catch ( DBException& e ) {
+                    pm->fail( e.toString() );
+                }
+                catch ( std::exception& e ) {
+                    pm->fail( e.what() );
+                }
+                scoped_lock lk( pm->_mutex );
+                pm->_running--;
+                pm->_cond.notify_all();
+            }
+
+            void mapRanges() {
+                // functions of our own, bound to this thread's scope
+                Config config( _dbname , _cmd );
+                config.outputOptions.outType = Config::INMEMORY;
+                State state( config );
+                state.init( _userToken );
+                Scope::NoDBAccess no = state.scope()->disableDBAccess( "can't access db inside a parallel map/reduce" );
+                Matcher matcher( config.filter );
+
+                long long emits = 0;
+                Range range;
+                while ( nextRange( &range ) ) {
+                    long long input = 0;
+                    LOCK_REASON(lockReason, "m/r: parallel emit phase");
+                    Client::ReadContext ctx( config.ns , lockReason );
+                    Client::Transaction transaction( DB_TXN_SNAPSHOT | DB_TXN_READ_ONLY );
+                    Collection *cl = getCollection( config.ns );
+                    uassert( 17380 , "collection dropped during map/reduce" , cl != NULL );
+                    shared_ptr<Cursor> c = Cursor::make( cl , cl->getPKIndex() ,
+                                                         range.start , range.end , range.endInclusive , 1 );
+                    for ( ; c->ok(); c->advance() ) {
+                        if ( cancelled() )
+                            return;
+
+                        BSONObj o = c->current();
+                        if ( ! matcher.matches( o ) )
+                            continue;
+                        if ( _chunkManager && ! _chunkManager->belongsToMe( o ) )
+                            continue;
+
+                        config.mapper->map( o );
+                        state.checkSize();
+                        input++;
+
+                        if ( state.inMemSize() > config.maxInMemSize ) {
+                            // reducing didn't shrink it enough, let the job's thread spill it
+                            handOver( state , input , &emits );
+                            input = 0;
+                        }
+                    }
+                    transaction.commit();
+                    state.reduceInMemory();
+                    handOver( state , input , &emits );
+                }
+                scoped_lock lk( _mutex );
+                _reduces += config.reducer->numReduces;
+            }
+
+            void handOver( State& state , long long input , long long* emits ) {
+                Output out;
+                out.im.reset( state.releaseInMemory().release() );
+                out.emits = state.numEmits() - *emits;
+                out.input = input;
+                *emits = state.numEmits();
+                scoped_lock lk( _mutex );
+                _output.push_back( out );
+                _cond.notify_all();
+            }
+
+            bool nextRange( Range* range ) {
+                scoped_lock lk( _mutex );
+                if ( _cancelled || _ranges.empty() ) {
+                    return false;
+                }
+                *range = _ranges.front();
+                _ranges.pop_front();
+                return true;
+            }
+
+            bool cancelled() {
+                scoped_lock lk( _mutex );
+                return _cancelled || inShutdown();
+            }
+
+            void fail( const string& error ) {
+                scoped_lock lk( _mutex );
+                if ( _error.empty() ) {
+                    _error = error;
+                }
+                _cancelled = true;
+            }
+
+            const string _dbname;
+            const BSONObj _cmd;
+            const string _userToken;
+            const ShardChunkManagerPtr _chunkManager;
+
+            mongo::mutex _mutex;
+            boost::condition _cond;
+            deque<Range> _ranges;
+            deque<Output> _output;
+            int _running;
+            bool _cancelled;
+            string _error;
+            long long _reduces;
+        };
+
         /**
          * This class represents a map/reduce command executed on a single server
          */
@@ -1193,7 +1756,20 @@ namespace mongo {
 
                         wassert( config.limit < 0x4000000 ); // see case on next line to 32 bit unsigned
                         long long mapTime = 0;
-                        {
+                        vector<ParallelMap::Range> ranges;
+                        if ( ParallelMap::split( config , &ranges ) ) {
+                            shared_ptr<ParallelMap> parallelMap( new ParallelMap( dbname , cmd , chunkManager , ranges ) );
+                            ParallelMap::start( parallelMap , config.parallel );
+                            try {
+                                num = parallelMap->merge( state , pm );
+                            }
+                            catch ( ... ) {
+                                parallelMap->cancel();
+                                throw;
+                            }
+                            timingBuilder.append( "parallelRanges" , (int) ranges.size() );
+                        }
+                        else {
                             LOCK_REASON(lockReason, "m/r: emit phase");
                             Client::ReadContext ctx(config.ns, lockReason);
 
@@ -66,6 +66,13 @@ namespace mongo {
             virtual BSONObj reduce( const BSONList& tuples ) = 0;
             /** this means its a final reduce, even if there is no finalizer */
             virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer ) = 0;
+            /**
+             * a final reduce of a new result with the one already in the output collection,
+             * for out: {reduce: ...}, where both values went through the finalizer
+             */
+            virtual BSONObj reduceFinalized( const BSONList& tuples , Finalizer * finalizer ) {
+                return finalReduce( tuples , finalizer );
+            }
 
             long long numReduces;
         };
@@ -139,6 +146,68 @@ namespace mongo {
 
         };
 
+        // ------------  native implementations -----------
+
+        /**
+         * a reduce given as {$native: op} for scalar values, or as
+         * {$native: {field: op, ...}} for object values, where op is one of
+         * sum, count, min, max, avg and addToSet
+         * runs on the aggregation accumulators, without calling into javascript
+         *
+         * values reduced but not final keep what is needed to reduce them again:
+         * sum holds a number, count {count}, avg {subTotal, count}, addToSet an array
+         * every emitted value counts as one, unless it is such a {count} object
+         * reducing into an existing collection weighs each final avg there as one value
+         */
+        class NativeReducer : public Reducer {
+        public:
+            NativeReducer( const BSONElement& code );
+            virtual void init( State * state ) {}
+
+            virtual BSONObj reduce( const BSONList& tuples );
+            virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
+            virtual BSONObj reduceFinalized( const BSONList& tuples , Finalizer * finalizer );
+
+            /**
+             * puts the value of a tuple (key, val) in its final form
+             * returns tuple obj {key, value: newval}
+             */
+            BSONObj finalize( const BSONObj& tuple ) const;
+
+            static bool isNative( const BSONElement& code );
+
+        private:
+            enum Op { SUM , COUNT , MIN , MAX , AVG , ADD_TO_SET };
+
+            static Op parseOp( const BSONElement& e );
+
+            BSONObj _finalReduce( const BSONList& tuples , bool finalInputs , Finalizer * finalizer );
+
+            /**
+             * appends the reduction of the values of tuples as fieldName
+             * @param finalInputs the values are final, so a number in a count is a count
+             */
+            void _reduce( const BSONList& tuples , bool final , bool finalInputs ,
+                          BSONObjBuilder& b , const char* fieldName ) const;
+
+            // with an empty name, the op applies to the whole value
+            vector< pair<string,Op> > _fields;
+        };
+
+        /**
+         * puts the values of a native reduce in their final form, then applies
+         * the finalize function if one was given
+         */
+        class NativeFinalizer : public Finalizer {
+        public:
+            NativeFinalizer( const NativeReducer& reducer , Finalizer * next ) : _reducer( reducer ) , _next( next ) {}
+            virtual BSONObj finalize( const BSONObj& o );
+            virtual void init( State * state ) { if ( _next ) _next->init( state ); }
+        private:
+            const NativeReducer& _reducer;
+            scoped_ptr<Finalizer> _next;
+        };
+
         // -----------------
 
 
@@ -166,6 +235,8 @@ namespace mongo {
             bool verbose;
             bool jsMode;
             int splitInfo;
+            // number of threads the map phase may use, see ParallelMap
+            int parallel;
 
             // query options
 
@@ -226,6 +297,10 @@ namespace mongo {
             ~State();
 
             void init();
+            /**
+             * @param userToken names the authenticated users, whose scopes are kept apart
+             */
+            void init( const string& userToken );
 
             // ---- prep  -----
             bool sourceExists();
@@ -257,6 +332,17 @@ namespace mongo {
             void insertToInc( BSONObj& o );
             void _insertToInc( BSONObj& o );
 
+            /**
+             * moves the in memory map out, leaving an empty one
+             * used by the threads of a parallel map phase to hand over what they reduced
+             */
+            auto_ptr<InMemory> releaseInMemory();
+
+            /**
+             * adds the tuples of a map another State built from numEmits emits
+             */
+            void addInMemory( const InMemory& im , long long numEmits );
+
             // ------ reduce stage -----------
 
             void prepTempCollection();
@@ -303,6 +389,7 @@ namespace mongo {
             long long numEmits() const { if (_jsMode) return _scope->getNumberLongLong("_emitCt"); return _numEmits; }
             long long numReduces() const { if (_jsMode) return _scope->getNumberLongLong("_redCt"); return _config.reducer->numReduces; }
             long long numInMemKeys() const { if (_jsMode) return _scope->getNumberLongLong("_keyCt"); return _temp->size(); }
+            long inMemSize() const { return _size; }
 
             bool jsMode() {return _jsMode;}
             void switchMode(bool jsMode);
@@ -76,6 +76,7 @@ namespace mongo {
         // error handling
         ExceptionInfo exceptionInfo;
         BSONObj lockNotGrantedInfo;
+        int lockRetries;     // times a single-statement write was retried after a lock conflict
         
         // response info
         int executionTime;
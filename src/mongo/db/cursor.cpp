@@ -17,12 +17,16 @@
 
 #include "mongo/pch.h"
 
+#include "mongo/base/counter.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/cursor.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/queryutil.h"
 #include "mongo/db/collection.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/exception.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
 
@@ -233,6 +237,148 @@ namespace mongo {
         verify(forward());
     }
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Background reads of partitions a cursor has yet to reach
+
+    MONGO_EXPORT_SERVER_PARAMETER(partitionScanParallelism, int, 0);
+
+    // threads shared by all cursors, which also caps partitionScanParallelism
+    static const int maxPartitionScanThreads = 16;
+
+    static Counter64 partitionsPrefetched;
+    static Counter64 partitionPrefetchesSkipped;
+    static ServerStatusMetricField<Counter64> partitionsPrefetchedDisplay(
+            "partitionScan.prefetched", &partitionsPrefetched);
+    static ServerStatusMetricField<Counter64> partitionPrefetchesSkippedDisplay(
+            "partitionScan.skipped", &partitionPrefetchesSkipped);
+
+    static mongo::mutex partitionScanPoolMutex("partitionScanPool");
+    static ThreadPool *partitionScanPool = NULL;
+
+    static ThreadPool &getPartitionScanPool() {
+        scoped_lock lk(partitionScanPoolMutex);
+        if (partitionScanPool == NULL) {
+            // never deleted, its threads may be mid-read at shutdown
+            partitionScanPool = new ThreadPool(maxPartitionScanThreads);
+        }
+        return *partitionScanPool;
+    }
+
+    shared_ptr<PartitionPrefetcher> PartitionPrefetcher::start(
+        const shared_ptr<SinglePartitionCursorGenerator> &generator,
+        const vector<uint64_t> &partitionIndexes
+        ) {
+        shared_ptr<PartitionPrefetcher> ret;
+        const int parallelism = std::min(partitionScanParallelism, maxPartitionScanThreads);
+        // Cursors used under a write lock would only make the prefetch
+        // threads wait for that lock, by which time it's too late.
+        if (parallelism <= 0 || partitionIndexes.empty() ||
+            cc().opSettings().getQueryCursorMode() != DEFAULT_LOCK_CURSOR) {
+            return ret;
+        }
+        ret.reset(new PartitionPrefetcher(generator));
+        for (vector<uint64_t>::const_iterator it = partitionIndexes.begin(); it != partitionIndexes.end(); ++it) {
+            Pending pending;
+            pending.index = *it;
+            pending.id = ret->_pc->getPartitionID(*it);
+            pending.partition = ret->_pc->getPartition(*it);
+            ret->_pending.push_back(pending);
+        }
+        ThreadPool &pool = getPartitionScanPool();
+        const size_t nThreads = std::min(static_cast<size_t>(parallelism), partitionIndexes.size());
+        for (size_t i = 0; i < nThreads; i++) {
+            pool.schedule(&PartitionPrefetcher::run, ret);
+        }
+        return ret;
+    }
+
+    PartitionPrefetcher::PartitionPrefetcher(const shared_ptr<SinglePartitionCursorGenerator> &generator) :
+        _generator(generator),
+        _pc(generator->collection()),
+        _ns(_pc->ns()),
+        _mutex("PartitionPrefetcher"),
+        _cancelled(false)
+    {
+    }
+
+    void PartitionPrefetcher::reached(uint64_t partitionIndex) {
+        scoped_lock lk(_mutex);
+        // _pending is in scan order and threads take from the front, so
+        // if partitionIndex isn't there, nothing before it is either
+        for (deque<Pending>::iterator it = _pending.begin(); it != _pending.end(); ++it) {
+            if (it->index == partitionIndex) {
+                partitionPrefetchesSkipped.increment(it - _pending.begin() + 1);
+                _pending.erase(_pending.begin(), it + 1);
+                break;
+            }
+        }
+    }
+
+    void PartitionPrefetcher::cancel() {
+        scoped_lock lk(_mutex);
+        _cancelled = true;
+        partitionPrefetchesSkipped.increment(_pending.size());
+        _pending.clear();
+    }
+
+    bool PartitionPrefetcher::cancelled() {
+        scoped_lock lk(_mutex);
+        return _cancelled;
+    }
+
+    bool PartitionPrefetcher::next(Pending *pending) {
+        scoped_lock lk(_mutex);
+        if (_cancelled || _pending.empty()) {
+            return false;
+        }
+        *pending = _pending.front();
+        _pending.pop_front();
+        return true;
+    }
+
+    void PartitionPrefetcher::run(shared_ptr<PartitionPrefetcher> prefetcher) {
+        if (!haveClient()) {
+            Client::initThread("partitionscan");
+        }
+        Pending pending;
+        while (!inShutdown() && prefetcher->next(&pending)) {
+            prefetcher->read(pending);
+        }
+    }
+
+    void PartitionPrefetcher::read(const Pending &pending) {
+        LOCK_REASON(lockReason, "partitioned cursor: prefetching partition");
+        Client::ReadContext ctx(_ns, lockReason);
+        Client::Transaction txn(DB_TXN_SNAPSHOT | DB_TXN_READ_ONLY);
+        // The cursor that queued this may be long gone. Only read if the
+        // collection and the partition are the ones it was queued for. While
+        // the partition is alive no other one can have its address, and the
+        // collection holding it at its index is the one it was queued in.
+        Collection *cl = getCollection(_ns);
+        if (cl == NULL || !cl->isPartitioned()) {
+            return;
+        }
+        PartitionedCollection *pc = cl->as<PartitionedCollection>();
+        {
+            shared_ptr<CollectionData> partition = pending.partition.lock();
+            if (!partition || pending.index >= pc->numPartitions() ||
+                pc->getPartitionID(pending.index) != pending.id ||
+                pc->getPartition(pending.index) != partition || pc != _pc) {
+                return;
+            }
+        }
+        // Only walks the index the cursor uses. For a secondary index
+        // that isn't clustering, the documents themselves aren't read.
+        shared_ptr<Cursor> c = _generator->makeSubCursor(pending.index);
+        for (long long n = 1; c->ok(); c->advance(), n++) {
+            if (n % 1024 == 0 && (cancelled() || inShutdown())) {
+                return;
+            }
+        }
+        txn.commit();
+        partitionsPrefetched.increment();
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Partitioned Cursors (over the _id index)
     PartitionedCursor::PartitionedCursor(
@@ -248,13 +394,26 @@ namespace mongo {
         _prevNScanned(0),
         _tailable(false)
     {
+        vector<uint64_t> remaining;
+        _partitionIDGenerator->remainingIndexes(&remaining);
+        _prefetcher = PartitionPrefetcher::start(_subCursorGenerator, remaining);
         initializeSubCursor();
     }
 
+    PartitionedCursor::~PartitionedCursor() {
+        if (_prefetcher) {
+            _prefetcher->cancel();
+        }
+    }
+
     void PartitionedCursor::getNextSubCursor() {
         _partitionIDGenerator->advanceIndex();
+        const uint64_t currPartition = _partitionIDGenerator->getCurrentPartitionIndex();
+        if (_prefetcher) {
+            _prefetcher->reached(currPartition);
+        }
         shared_ptr<Cursor> oldCursor = _currentCursor;
-        _currentCursor = _subCursorGenerator->makeSubCursor(_partitionIDGenerator->getCurrentPartitionIndex());
+        _currentCursor = _subCursorGenerator->makeSubCursor(currPartition);
         if (oldCursor) {
             if (_matcher) {
                 _currentCursor->setMatcher(_matcher);
@@ -316,6 +475,12 @@ namespace mongo {
         _multiKey(multiKey),
         _comparator(_direction, _ordering)
     {
+        // every partition is read from the start, so all of them can be prefetched
+        vector<uint64_t> partitions;
+        partitions.push_back(_partitionIDGenerator->getCurrentPartitionIndex());
+        _partitionIDGenerator->remainingIndexes(&partitions);
+        _prefetcher = PartitionPrefetcher::start(_subCursorGenerator, partitions);
+
         // create each sub cursor in _cursors
         uint64_t curr = _partitionIDGenerator->getCurrentPartitionIndex();
         shared_ptr<Cursor> currentCursor = _subCursorGenerator->makeSubCursor(curr);
@@ -331,6 +496,12 @@ namespace mongo {
         std::make_heap(_cursors.begin(), _cursors.end(), _comparator);
     }
     
+    SortedPartitionedCursor::~SortedPartitionedCursor() {
+        if (_prefetcher) {
+            _prefetcher->cancel();
+        }
+    }
+
     bool SortedPartitionedCursor::advance() {
         std::pop_heap(
             _cursors.begin(),
@@ -412,10 +583,12 @@ namespace mongo {
         ) :
         _startPartition(direction > 0 ? 0 : pc->numPartitions() - 1),
         _endPartition(direction > 0 ? pc->numPartitions() - 1 : 0),
-        _direction(direction)
+        _direction(direction),
+        _skipped(0)
     {
         _currPartition = _startPartition;
         sanityCheckPartitionEndpoints();
+        pruneWithZoneMaps(pc);
     }
 
     PartitionedCursorIDGeneratorImpl::PartitionedCursorIDGeneratorImpl(
@@ -426,10 +599,12 @@ namespace mongo {
         ) :
         _startPartition(pc->partitionWithPK(startKey)),
         _endPartition(pc->partitionWithPK(endKey)),
-        _direction(direction)
+        _direction(direction),
+        _skipped(0)
     {
         _currPartition = _startPartition;
         sanityCheckPartitionEndpoints();
+        pruneWithZoneMaps(pc);
     }
 
     PartitionedCursorIDGeneratorImpl::PartitionedCursorIDGeneratorImpl(
@@ -439,10 +614,12 @@ namespace mongo {
         ) :
         _startPartition(pc->partitionWithPK(bounds->startKey())),
         _endPartition(pc->partitionWithPK(bounds->endKey())),
-        _direction(direction)
+        _direction(direction),
+        _skipped(0)
     {
         _currPartition = _startPartition;
         sanityCheckPartitionEndpoints();
+        pruneWithZoneMaps(pc);
     }
 
     void PartitionedCursorIDGeneratorImpl::sanityCheckPartitionEndpoints() {
@@ -455,17 +632,42 @@ namespace mongo {
         }
     }
 
+    void PartitionedCursorIDGeneratorImpl::pruneWithZoneMaps(PartitionedCollection* pc) {
+        if (!pc->hasZoneMaps()) {
+            return;
+        }
+        vector<bool> partitionsToRead(pc->numPartitions(), false);
+        const uint64_t first = std::min(_startPartition, _endPartition);
+        const uint64_t last = std::max(_startPartition, _endPartition);
+        std::fill(partitionsToRead.begin() + first, partitionsToRead.begin() + last + 1, true);
+        _skipped = pc->prunePartitions(cc().querySettings().getQuery(), &partitionsToRead);
+        if (_skipped == 0) {
+            return;
+        }
+        _partitionsToRead.swap(partitionsToRead);
+        // prunePartitions leaves at least one, so these stop
+        while (!_partitionsToRead[_startPartition]) {
+            _startPartition = step(_startPartition);
+        }
+        while (!_partitionsToRead[_endPartition]) {
+            _endPartition = _direction > 0 ? _endPartition - 1 : _endPartition + 1;
+        }
+        _currPartition = _startPartition;
+    }
+
+    uint64_t PartitionedCursorIDGeneratorImpl::step(uint64_t partition) const {
+        return _direction > 0 ? partition + 1 : partition - 1;
+    }
+
     uint64_t PartitionedCursorIDGeneratorImpl::getCurrentPartitionIndex() {
         return _currPartition;
     }
 
     void PartitionedCursorIDGeneratorImpl::advanceIndex() {
         massert(17343, "cannot advanceIndex, at end", !lastIndex());
-        if (_direction > 0) {
-            _currPartition++;
-        }
-        else {
-            _currPartition--;
+        _currPartition = step(_currPartition);
+        while (!_partitionsToRead.empty() && !_partitionsToRead[_currPartition]) {
+            _currPartition = step(_currPartition);
         }
     }
     
@@ -473,6 +675,15 @@ namespace mongo {
         return (_currPartition == _endPartition);
     }
 
+    void PartitionedCursorIDGeneratorImpl::remainingIndexes(vector<uint64_t> *indexes) {
+        for (uint64_t i = _currPartition; i != _endPartition; ) {
+            i = step(i);
+            if (_partitionsToRead.empty() || _partitionsToRead[i]) {
+                indexes->push_back(i);
+            }
+        }
+    }
+
     FilteredPartitionIDGeneratorImpl::FilteredPartitionIDGeneratorImpl(
         PartitionedCollection* pc,
         const char* ns,
@@ -480,7 +691,8 @@ namespace mongo {
         const int direction
         ):
         _partitionsToRead(pc->numPartitions(), false),
-        _direction(direction)
+        _direction(direction),
+        _skipped(0)
     {
         // initialize the bitmap to be all false
         uint64_t numPartitions = pc->numPartitions();
@@ -525,6 +737,12 @@ namespace mongo {
                 org.popOrClauseSingleKey();
             }
         } while (!org.orRangesExhausted());
+        // leave out partitions whose zone maps rule them out
+        _skipped = pc->prunePartitions(cc().querySettings().getQuery(), &_partitionsToRead);
+        if (_skipped > 0) {
+            minPartitionToRead = std::find(_partitionsToRead.begin(), _partitionsToRead.end(), true) - _partitionsToRead.begin();
+            maxPartitionToRead = _partitionsToRead.rend() - std::find(_partitionsToRead.rbegin(), _partitionsToRead.rend(), true) - 1;
+        }
         // at this point, we have set all of the appropriate
         // entries in _partitionsToRead to true
         // Now we need to set up _currPartition
@@ -564,5 +782,14 @@ namespace mongo {
     bool FilteredPartitionIDGeneratorImpl::lastIndex() {
         return (_currPartition == _endPartition);
     }
+
+    void FilteredPartitionIDGeneratorImpl::remainingIndexes(vector<uint64_t> *indexes) {
+        for (uint64_t i = _currPartition; i != _endPartition; ) {
+            i = _direction > 0 ? i + 1 : i - 1;
+            if (_partitionsToRead[i]) {
+                indexes->push_back(i);
+            }
+        }
+    }
     
 } // namespace mongo
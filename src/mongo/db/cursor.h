@@ -19,6 +19,8 @@
 
 #include "mongo/pch.h"
 
+#include <boost/weak_ptr.hpp>
+
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher.h"
 #include "mongo/db/projection.h"
@@ -272,8 +274,11 @@ namespace mongo {
          * @return false if the pk has not been seen
          */
         bool getsetdup(const BSONObj &pk) {
-            if ( _multiKey ) {
-                return _dups.getsetdup(pk);
+            if ( _dedup ) {
+                if ( _dups.getsetdup(pk) ) {
+                    _nDups++;
+                    return true;
+                }
             }
             return false;
         }
@@ -292,6 +297,8 @@ namespace mongo {
         string toString() const;
         BSONObj prettyIndexBounds() const;
 
+        void explainDetails( BSONObjBuilder& b ) const;
+
         CoveredIndexMatcher *matcher() const { return _matcher.get(); }
         void setMatcher( shared_ptr< CoveredIndexMatcher > matcher ) { _matcher = matcher;  }
         bool currentMatches( MatchDetails *details = NULL );
@@ -393,6 +400,11 @@ namespace mongo {
         BSONObj _minUnsafeKey;
         bool _endKeyInclusive;
         const bool _multiKey;
+        // False if the index is multikey but the bounds hold every multikey path
+        // of the index to a single value, so each document has at most one key
+        // in range and there is nothing to dedup.
+        const bool _dedup;
+        long long _nDups;
         const int _direction;
         shared_ptr< FieldRangeVector > _bounds; // field ranges to iterate over, if non-null
         auto_ptr< FieldRangeVectorIterator > _boundsIterator;
@@ -614,6 +626,7 @@ namespace mongo {
     public:
         // generate a cursor on partition with index of partitionIndex
         shared_ptr<Cursor> makeSubCursor(uint64_t partitionIndex);
+        const PartitionedCollection* collection() const { return _pc; }
         virtual ~SinglePartitionCursorGenerator() { }
     protected:
         SinglePartitionCursorGenerator(
@@ -653,6 +666,53 @@ namespace mongo {
         // that the cursor cares about. If true, calls to advanceIndex
         // will massert
         virtual bool lastIndex() = 0;
+        // append the partition indexes that come after the current one,
+        // in the order advanceIndex() would visit them, without advancing
+        virtual void remainingIndexes(vector<uint64_t> *indexes) = 0;
+        // number of partitions left out because their zone maps
+        // showed they could not match the query
+        virtual uint64_t partitionsSkipped() const = 0;
+    };
+
+    // Reads the partitions a partitioned cursor will get to later on
+    // background threads, so that their data is already in the cache
+    // when the cursor reaches them. The cursor still does all of its own
+    // reads on its own thread and in its own transaction; the prefetch
+    // threads use their own snapshot and only warm the cache. At most
+    // partitionScanParallelism partitions are read at once for one cursor,
+    // and 0 (the default) turns this off.
+    class PartitionPrefetcher : boost::noncopyable {
+    public:
+        // returns an empty pointer if there is nothing to do
+        static shared_ptr<PartitionPrefetcher> start(
+            const shared_ptr<SinglePartitionCursorGenerator> &generator,
+            const vector<uint64_t> &partitionIndexes
+            );
+        // the cursor has reached partitionIndex, so there is
+        // no point reading it or anything queued before it
+        void reached(uint64_t partitionIndex);
+        // the cursor is done, stop as soon as possible
+        void cancel();
+    private:
+        // A partition to read, by index. The ID and the (unowned) partition
+        // itself tell whether that index still holds it when it is read.
+        struct Pending {
+            uint64_t index;
+            uint64_t id;
+            boost::weak_ptr<CollectionData> partition;
+        };
+        explicit PartitionPrefetcher(const shared_ptr<SinglePartitionCursorGenerator> &generator);
+        static void run(shared_ptr<PartitionPrefetcher> prefetcher);
+        bool next(Pending *pending);
+        bool cancelled();
+        void read(const Pending &pending);
+
+        shared_ptr<SinglePartitionCursorGenerator> _generator;
+        const PartitionedCollection *_pc;
+        const string _ns;
+        mongo::mutex _mutex;
+        deque<Pending> _pending;
+        bool _cancelled;
     };
 
     // class for cursor over Partitioned Collection
@@ -667,6 +727,7 @@ namespace mongo {
     // If results must be in order, the caller should use a SortedPartitionedCursor
     class PartitionedCursor : public Cursor {
     public:
+        virtual ~PartitionedCursor();
 
         virtual bool ok() {
             return _currentCursor->ok();
@@ -742,6 +803,11 @@ namespace mongo {
         bool tailable() const { return _tailable; }
         void setTailable();
 
+        virtual void explainDetails( BSONObjBuilder& b ) const {
+            b.appendNumber( "partitionsSkipped",
+                            (long long) _partitionIDGenerator->partitionsSkipped() );
+        }
+
     private:
         PartitionedCursor(
             const bool distributed,
@@ -766,6 +832,7 @@ namespace mongo {
 
         bool _tailable;
         PKDupSet _dups;
+        shared_ptr<PartitionPrefetcher> _prefetcher;
 
         friend class PartitionedCollection;
     };
@@ -828,6 +895,7 @@ namespace mongo {
     // simultaneously
     class SortedPartitionedCursor : public Cursor {
     public:
+        virtual ~SortedPartitionedCursor();
 
         virtual bool ok() {
             return (frontCursor())->ok();
@@ -910,6 +978,11 @@ namespace mongo {
             uasserted(17348, "Cannot set a secondary index on a partitioned cursor to tailable");
         }
 
+        virtual void explainDetails( BSONObjBuilder& b ) const {
+            b.appendNumber( "partitionsSkipped",
+                            (long long) _partitionIDGenerator->partitionsSkipped() );
+        }
+
     private:
         SortedPartitionedCursor(
             const BSONObj idxPattern,
@@ -939,6 +1012,7 @@ namespace mongo {
         vector< SPCSingleCursor > _cursors;
 
         PKDupSet _dups;
+        shared_ptr<PartitionPrefetcher> _prefetcher;
 
         friend class PartitionedCollection;
     };
@@ -1035,12 +1109,19 @@ namespace mongo {
         virtual uint64_t getCurrentPartitionIndex();
         virtual void advanceIndex();
         virtual bool lastIndex();
+        virtual void remainingIndexes(vector<uint64_t> *indexes);
+        virtual uint64_t partitionsSkipped() const { return _skipped; }
     private:
         uint64_t _currPartition;
-        const uint64_t _startPartition;
-        const uint64_t _endPartition;
+        uint64_t _startPartition;
+        uint64_t _endPartition;
         const int _direction;
+        // empty unless zone maps ruled out some partitions
+        vector<bool> _partitionsToRead;
+        uint64_t _skipped;
         void sanityCheckPartitionEndpoints();
+        void pruneWithZoneMaps(PartitionedCollection* pc);
+        uint64_t step(uint64_t partition) const;
     };
 
     class FilteredPartitionIDGeneratorImpl : public PartitionedCursorIDGenerator {
@@ -1054,10 +1135,13 @@ namespace mongo {
         virtual uint64_t getCurrentPartitionIndex();
         virtual void advanceIndex();
         virtual bool lastIndex();
+        virtual void remainingIndexes(vector<uint64_t> *indexes);
+        virtual uint64_t partitionsSkipped() const { return _skipped; }
     private:
         vector<bool> _partitionsToRead;
         uint64_t _currPartition;
         uint64_t _endPartition;
         const int _direction;
+        uint64_t _skipped;
     };
 } // namespace mongo
@@ -47,12 +47,14 @@
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/ops/insert.h"
 #include "mongo/db/ops/update.h"
+#include "mongo/db/partition_policy.h"
 #include "mongo/db/repl.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/restapi.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/stats/snapshots.h"
 #include "mongo/db/storage/env.h"
+#include "mongo/db/stats/lock_contention.h"
 #include "mongo/db/ttl.h"
 #include "mongo/db/txn_complete_hooks.h"
 #include "mongo/plugins/loader.h"
@@ -735,11 +737,13 @@ namespace mongo {
         snapshotThread.go();
         d.clientCursorMonitor.go();
         PeriodicTask::theRunner->go();
+        startLockContentionSampler();
         if (missingRepl) {
             // a warning was logged earlier
         }
         else {
             startTTLBackgroundJob();
+            startPartitionPolicyBackgroundJob();
         }
 
 #ifndef _WIN32
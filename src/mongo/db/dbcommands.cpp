@@ -108,6 +108,13 @@ namespace mongo {
     static Counter64 gleWtimeouts;
     static ServerStatusMetricField<Counter64> gleWtimeoutsDisplay( "getLastError.wtimeouts", &gleWtimeouts );
 
+    static TimerHistogramStats gleWtimeHistogram;
+    static ServerStatusMetricField<TimerHistogramStats> displayGleLatencyHistogram( "getLastError.wtimeHistogram", &gleWtimeHistogram );
+
+    // how long a w: waiter sleeps at most before rechecking for stepdown, interruption and its
+    // wtimeout, if no member's position satisfies it in the meantime
+    static const int gleWaitSliceMillis = 100;
+
     class CmdGetLastError : public InformationCommand {
     public:
         CmdGetLastError() : InformationCommand("getLastError", false, "getlasterror") { }
@@ -167,9 +174,10 @@ namespace mongo {
                 //
                 if ( cmdObj["j"].trueValue() || cmdObj["fsync"].trueValue()) {
                     // if there's a non-zero log flush period, transactions
-                    // do not fsync on commit and so we must do it here.
+                    // do not fsync on commit and so we must wait for a flush
+                    // here, which is shared with any other waiting clients.
                     if (cmdLine.logFlushPeriod != 0) {
-                        storage::log_flush();
+                        storage::wait_for_log_flush();
                     }
                 }
 
@@ -247,8 +255,13 @@ namespace mongo {
                             return false;
                         }
 
-                        // check this first for w=0 or w=1
-                        OP_REPL_STATUS s = opReplicatedEnough( gtid, e );
+                        int waitMillis = gleWaitSliceMillis;
+                        if ( timeout > 0 ) {
+                            waitMillis = std::min( waitMillis, timeout - timer.millis() );
+                        }
+
+                        // w=0 and w=1 are satisfied without waiting
+                        OP_REPL_STATUS s = waitForReplication( gtid, e, waitMillis );
                         if ( s == REPL_SUCCESS ) {
                             break;
                         }
@@ -270,11 +283,11 @@ namespace mongo {
 
                         verify( sprintf( buf , "w block pass: %lld" , ++passes ) < 30 );
                         c.curop()->setMessage( buf );
-                        sleepmillis(1);
                         killCurrentOp.checkForInterrupt();
                     }
 
                     result.append("writtenTo", getHostsWrittenTo(gtid));
+                    gleWtimeHistogram.recordMicros( timer.micros() );
                     int myMillis = timer.recordMillis();
                     result.appendNumber( "wtime" , myMillis );
                 }
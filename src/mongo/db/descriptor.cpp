@@ -130,4 +130,21 @@ namespace mongo {
         }
     }
 
+    uint64_t Descriptor::multiKeyPaths(const BSONObjSet &keys) {
+        uint64_t paths = 0;
+        if (keys.size() > 1) {
+            BSONObjSet::const_iterator first = keys.begin();
+            for (BSONObjSet::const_iterator k = first; ++k != keys.end(); ) {
+                BSONObjIterator a(*first);
+                BSONObjIterator b(*k);
+                for (int i = 0; a.more() && b.more(); i++) {
+                    if (a.next().woCompare(b.next(), false) != 0) {
+                        paths |= 1ULL << std::min(i, 63);
+                    }
+                }
+            }
+        }
+        return paths;
+    }
+
 } // namespace mongo
@@ -57,6 +57,12 @@ namespace mongo {
 
         void generateKeys(const BSONObj &obj, BSONObjSet &keys) const;
 
+        // Given the keys generated for one document, returns a mask of the key
+        // pattern positions whose values are not the same in every key, ie: the
+        // fields that made this document multikey. Positions past 63 share the
+        // last bit. Zero iff there is at most one key.
+        static uint64_t multiKeyPaths(const BSONObjSet &keys);
+
         BSONObj fillKeyFieldNames(const BSONObj &key) const;
 
         bool clustering() const {
@@ -97,7 +97,10 @@ namespace mongo {
         _lastLiveGTID = lastGTID;
         _minLiveGTID = _lastLiveGTID;
         _minLiveGTID.inc(); // comment this
+        _minLiveSeq.store(_minLiveGTID.getGTSeqNo());
         _newPrimaryValue = 0;
+        _liveDone.reset(new AtomicUInt64[LIVE_RING_SIZE]);
+        _liveRingPrimary = 0;
         _highestKnownPossiblePrimary = std::max(_lastLiveGTID.getPrimary(), lastVotedForPrimary);
 
         // note that _minUnappliedGTID is not set
@@ -122,23 +125,35 @@ namespace mongo {
 
         boost::unique_lock<boost::mutex> lock(_lock);
         dassert(GTID::cmp(_lastLiveGTID, _lastUnappliedGTID) == 0);
+        const bool noneLive = noLiveGTIDs();
         // _newPrimaryValue ought to always be greater that _lastLiveGTID.getPrimary(),
         // so this second check is just paranoia
         if (_newPrimaryValue > 0 && _newPrimaryValue > _lastLiveGTID.getPrimary()) {
+            dassert(noneLive);
             _lastLiveGTID.setPrimaryTo(_newPrimaryValue);
             _newPrimaryValue = 0;
         }
         else {
+            // the ring is full, wait for the oldest live GTID to be done
+            while (_lastLiveGTID.getGTSeqNo() + 1 - _minLiveGTID.getGTSeqNo() >= LIVE_RING_SIZE) {
+                _minLiveCond.wait(lock);
+            }
             _lastLiveGTID.inc();
         }
 
-        if (_liveGTIDs.size() == 0) {
+        if (noneLive) {
+            if (_lastLiveGTID.getPrimary() != _liveRingPrimary) {
+                for (uint64_t i = 0; i < LIVE_RING_SIZE; i++) {
+                    _liveDone[i].store(0);
+                }
+                _liveRingPrimary = _lastLiveGTID.getPrimary();
+            }
             _minLiveGTID = _lastLiveGTID;
+            _minLiveSeq.swap(_minLiveGTID.getGTSeqNo());
         }
 
         _lastUnappliedGTID = _lastLiveGTID;
         *gtid = _lastLiveGTID;
-        _liveGTIDs.insert(*gtid);
         _lastTimestamp = *timestamp;
         *hash = (_lastHash* 131 + *timestamp) * 17 + _selfID;
         _lastHash = *hash;
@@ -153,22 +168,34 @@ namespace mongo {
     // THIS MUST BE DONE ON A PRIMARY
     //
     void GTIDManager::noteLiveGTIDDone(const GTID& gtid) {
-        boost::unique_lock<boost::mutex> lock(_lock);
-        dassert(GTID::cmp(gtid, _minLiveGTID) >= 0);
-        dassert(_liveGTIDs.size() > 0);
-        // remove from list of GTIDs
-        _liveGTIDs.erase(gtid);
-        // if what we are removing is currently the minumum live GTID
-        // we need to update the minimum live GTID
-        if (GTID::cmp(_minLiveGTID, gtid) == 0) {
-            if (_liveGTIDs.size() == 0) {
-                _minLiveGTID = _lastLiveGTID;
-                _minLiveGTID.inc();
-            }
-            else {
-                // get the minumum from _liveGTIDs and set it to _minLiveGTIDs
-                _minLiveGTID = *(_liveGTIDs.begin());
-            }
+        const uint64_t seq = gtid.getGTSeqNo();
+        // If what we are removing is currently the minumum live GTID
+        // we need to update the minimum live GTID. Otherwise, whoever
+        // holds the minimum will find our slot done when it gets there.
+        // Both the flag and _minLiveSeq are swapped (a full barrier) before
+        // the other is read, so at least one of us sees the other's write.
+        liveDone(seq).swap(seq + 1);
+        if (_minLiveSeq.loadRelaxed() == seq) {
+            boost::unique_lock<boost::mutex> lock(_lock);
+            advanceMinLive();
+        }
+    }
+
+    // true if no GTIDs handed out on a primary are still live
+    bool GTIDManager::noLiveGTIDs() const {
+        return GTID::cmp(_minLiveGTID, _lastLiveGTID) > 0;
+    }
+
+    // moves _minLiveGTID past all GTIDs whose transactions are done
+    // must be called with _lock held
+    void GTIDManager::advanceMinLive() {
+        bool changed = false;
+        while (!noLiveGTIDs() && isLiveDone(_minLiveGTID.getGTSeqNo())) {
+            _minLiveGTID.inc();
+            _minLiveSeq.swap(_minLiveGTID.getGTSeqNo());
+            changed = true;
+        }
+        if (changed) {
             // note that on a primary, which we must be, these are equivalent
             _minUnappliedGTID = _minLiveGTID;
             // notify that _minLiveGTID has changed
@@ -188,6 +215,7 @@ namespace mongo {
         _lastLiveGTID = gtid;
         _minLiveGTID = _lastLiveGTID;
         _minLiveGTID.inc();
+        _minLiveSeq.store(_minLiveGTID.getGTSeqNo());
 
         _lastTimestamp = ts;
         _lastHash = lastHash;
@@ -265,7 +293,7 @@ namespace mongo {
 
     bool GTIDManager::resetManager(uint64_t newPrimary) {
         boost::unique_lock<boost::mutex> lock(_lock);
-        dassert(_liveGTIDs.size() == 0);
+        dassert(noLiveGTIDs());
         if (_lastLiveGTID.getPrimary() >= newPrimary) {
             log() << "attempt to resetManager failing, existing primary of _lastLiveGTID: " << \
                 _lastLiveGTID.getPrimary() << " newPrimary: " << newPrimary << endl;
@@ -277,6 +305,7 @@ namespace mongo {
 
         _minLiveGTID = _lastLiveGTID;
         _minLiveGTID.inc();
+        _minLiveSeq.store(_minLiveGTID.getGTSeqNo());
 
         _lastUnappliedGTID = _lastLiveGTID;
         _minUnappliedGTID = _minLiveGTID;
@@ -338,11 +367,12 @@ namespace mongo {
     // we can proceed with replication.
     void GTIDManager::resetAfterInitialSync(GTID last, uint64_t lastTime, uint64_t lastHash) {
         boost::unique_lock<boost::mutex> lock(_lock);
-        verify(_liveGTIDs.size() == 0);
+        verify(noLiveGTIDs());
         verify(_unappliedGTIDs.size() == 0);
         _lastLiveGTID = last;
         _minLiveGTID = _lastLiveGTID;
         _minLiveGTID.inc(); // comment this
+        _minLiveSeq.store(_minLiveGTID.getGTSeqNo());
 
         _lastUnappliedGTID = _lastLiveGTID;
         _minUnappliedGTID = _minLiveGTID;
@@ -360,7 +390,7 @@ namespace mongo {
 
     void GTIDManager::catchUnappliedToLive() {
         boost::unique_lock<boost::mutex> lock(_lock);
-        verify(_liveGTIDs.size() == 0);
+        verify(noLiveGTIDs());
         verify(_unappliedGTIDs.size() == 0);
         _lastUnappliedGTID = _lastLiveGTID;
         _minUnappliedGTID = _minLiveGTID;
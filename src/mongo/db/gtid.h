@@ -20,6 +20,10 @@
 //#include "mongo/db/jsobj.h"
 #include <limits>
 
+#include <boost/scoped_array.hpp>
+
+#include "mongo/platform/atomic_word.h"
+
 namespace mongo {
 
     class BSONObjBuilder;
@@ -43,6 +47,9 @@ namespace mongo {
         string toString() const;
         bool isInitial() const;
         uint64_t getPrimary() const;        
+        uint64_t getGTSeqNo() const {
+            return _GTSeqNo;
+        }
         bool operator==(const GTID& other) const {
             return _primarySeqNo == other._primarySeqNo && _GTSeqNo == other._GTSeqNo;
         }
@@ -101,12 +108,28 @@ namespace mongo {
         // that has yet to be applied to the collections on the secondary
         GTID _minUnappliedGTID;
 
-        // set of GTIDs that are live and not committed.
+        // GTIDs that are live and not committed.
         // on a primary, these GTIDs have been handed out
         // by the GTIDManager to be used in the oplog, and
         // the GTIDManager has yet to get notification that 
-        // the associated transaction to this GTID has been committed
-        GTIDSet _liveGTIDs;
+        // the associated transaction to this GTID has been committed.
+        //
+        // Live GTIDs all share a primary and are exactly the sequence
+        // numbers from _minLiveGTID to _lastLiveGTID, so rather than a set
+        // we keep a ring of "done" marks indexed by sequence number. When
+        // a GTID's transaction is done its slot is set, without the lock,
+        // to its sequence number plus one, which no earlier user of the
+        // slot could have left there. Only the completion of the minimum
+        // live GTID takes the lock, to move _minLiveGTID past every done
+        // slot. At most LIVE_RING_SIZE GTIDs may be live at once, past
+        // that getGTIDForPrimary waits for the oldest to be done.
+        // Sequence numbers restart with each primary, so the ring is
+        // cleared when GTIDs are first handed out for a new one.
+        static const uint64_t LIVE_RING_SIZE = 1 << 16;
+        boost::scoped_array<AtomicUInt64> _liveDone;
+        uint64_t _liveRingPrimary;
+        // sequence number of _minLiveGTID, readable without the lock
+        AtomicUInt64 _minLiveSeq;
 
         // set of GTIDs committed to the opLog, but not applied
         // to the collections. On a primary, this should be empty
@@ -179,6 +202,14 @@ namespace mongo {
         bool canAcknowledgeGTID();
     private:
         void handleHighestKnownPrimary();
+        bool noLiveGTIDs() const;
+        void advanceMinLive();
+        AtomicUInt64 &liveDone(uint64_t seq) {
+            return _liveDone[seq & (LIVE_RING_SIZE - 1)];
+        }
+        bool isLiveDone(uint64_t seq) const {
+            return _liveDone[seq & (LIVE_RING_SIZE - 1)].loadRelaxed() == seq + 1;
+        }
 
     friend class GTIDManagerTest; // for testing
         
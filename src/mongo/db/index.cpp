@@ -548,6 +548,7 @@ namespace mongo {
         stats.nscannedObjects = _accessStats.nscannedObjects.load();
         stats.inserts = _accessStats.inserts.load();
         stats.deletes = _accessStats.deletes.load();
+        stats.multiKeyInserts = _accessStats.multiKeyInserts.load();
         return stats;
     }
 
@@ -594,6 +595,7 @@ namespace mongo {
         b.appendNumber("nscannedObjects", nscannedObjects);
         b.appendNumber("inserts", inserts);
         b.appendNumber("deletes", deletes);
+        b.appendNumber("multiKeyInserts", multiKeyInserts);
         // TODO: (Zardosht) Need to figure out how to display these dates
         /*
         Date_t create_date(_stats.bt_create_time_sec);
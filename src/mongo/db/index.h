@@ -33,6 +33,7 @@
 #include "mongo/db/storage/env.h"
 #include "mongo/db/storage/key.h"
 #include "mongo/db/storage/txn.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/percentage_progress_meter.h"
 
@@ -178,6 +179,7 @@ namespace mongo {
             AtomicWordOnCacheLine nscannedObjects;
             AtomicWordOnCacheLine inserts;
             AtomicWordOnCacheLine deletes;
+            AtomicWordOnCacheLine multiKeyInserts;
         };
 
         // Book-keeping for index access, displayed in db.stats()
@@ -192,6 +194,10 @@ namespace mongo {
         void noteDelete() const {
             _accessStats.deletes.fetchAndAdd(1);
         }
+        // A document was written that generated more than one key.
+        void noteMultiKeyInsert() const {
+            _accessStats.multiKeyInserts.fetchAndAdd(1);
+        }
 
         struct Stats {
             string name;
@@ -208,6 +214,7 @@ namespace mongo {
             uint64_t nscannedObjects;
             uint64_t inserts;
             uint64_t deletes;
+            uint64_t multiKeyInserts;
 
             Stats() : name(""),
                       count(0),
@@ -221,7 +228,8 @@ namespace mongo {
                       nscanned(0),
                       nscannedObjects(0),
                       inserts(0),
-                      deletes(0) {}
+                      deletes(0),
+                      multiKeyInserts(0) {}
             void appendInfo(BSONObjBuilder &b, int scale) const;
         };
 
@@ -415,8 +423,9 @@ namespace mongo {
         }
     }    
 
-    // Sets db->app_private to a bool that gets set
-    // if storage::generate_keys() generates multikeys.
+    // Sets db->app_private to a mask that gets the multikey paths (see
+    // Descriptor::multiKeyPaths()) of every document for which
+    // storage::generate_keys() generates multikeys.
     // On destruction, safely unsets db->app_private.
     //
     // Used by the hot indexer and loader to track
@@ -424,19 +433,23 @@ namespace mongo {
     class MultiKeyTracker : boost::noncopyable {
     public:
         MultiKeyTracker(DB *db) :
-            _db(db), _multiKey(false) {
-            _db->app_private = &_multiKey;
+            _db(db), _multiKeyPaths(0) {
+            _db->app_private = &_multiKeyPaths;
         }
         ~MultiKeyTracker() {
             _db->app_private = NULL;
         }
         bool isMultiKey() const {
-            return _multiKey;
+            return _multiKeyPaths.load() != 0;
+        }
+        uint64_t multiKeyPaths() const {
+            return _multiKeyPaths.load();
         }
 
     private:
         DB *_db;
-        bool _multiKey;
+        // Keys may be generated by several threads at once.
+        AtomicUInt64 _multiKeyPaths;
     };
 
     // IndexDetails class for PartitionedCollections
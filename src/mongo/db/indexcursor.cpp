@@ -162,6 +162,8 @@ namespace mongo {
         _endKey(endKey),
         _endKeyInclusive(endKeyInclusive),
         _multiKey(cl->isMultiKey(cl->idxNo(idx))),
+        _dedup(_multiKey),
+        _nDups(0),
         _direction(direction),
         _bounds(),
         _boundsMustMatch(true),
@@ -190,6 +192,8 @@ namespace mongo {
         _endKey(),
         _endKeyInclusive(true),
         _multiKey(cl->isMultiKey(cl->idxNo(idx))),
+        _dedup(_multiKey && !bounds->singlePointsOn(cl->getMultiKeyPaths(cl->idxNo(idx)))),
+        _nDups(0),
         _direction(direction),
         _bounds(bounds),
         _boundsMustMatch(true),
@@ -850,4 +854,11 @@ again:      while ( !allInclusive && ok() ) {
         }
     }    
 
+    void IndexCursor::explainDetails( BSONObjBuilder& b ) const {
+        if ( _multiKey ) {
+            b.append( "dedup", _dedup );
+            b.appendNumber( "nDups", _nDups );
+        }
+    }
+
 } // namespace mongo
@@ -121,7 +121,7 @@ namespace mongo {
         verify(_idx.get() != NULL);
         // The primary key doesn't need to be built - there's no data.
         if (_isSecondaryIndex) {
-            // Give the underlying DB a pointer to the multikey bool, which 
+            // Give the underlying DB a pointer to the multikey paths, which
             // will be set during index creation if multikeys are generated.
             // see storage::generate_keys()
             _multiKeyTracker.reset(new MultiKeyTracker(_idx->db()));
@@ -154,7 +154,8 @@ namespace mongo {
             }
             if (_multiKeyTracker->isMultiKey()) {
                 bool indexBitChanged;
-                _cl->setIndexIsMultikey(_cl->idxNo(*_idx.get()), &indexBitChanged);
+                _cl->setIndexIsMultikey(_cl->idxNo(*_idx.get()), &indexBitChanged,
+                                        _multiKeyTracker->multiKeyPaths());
             }
         }
     }
@@ -182,7 +183,8 @@ namespace mongo {
                 _idx->getKeysFromObject(obj, keys);
                 if (keys.size() > 1) {
                     bool indexBitChanged;
-                    _cl->setIndexIsMultikey(_cl->idxNo(*_idx.get()), &indexBitChanged);
+                    _cl->setIndexIsMultikey(_cl->idxNo(*_idx.get()), &indexBitChanged,
+                                            Descriptor::multiKeyPaths(keys));
                 }
                 for (BSONObjSet::const_iterator ki = keys.begin(); ki != keys.end(); ++ki) {
                     builder.insertPair(*ki, &pk, obj);
@@ -42,6 +42,7 @@
 #include "mongo/db/introspect.h"
 #include "mongo/db/repl.h"
 #include "mongo/db/client.h"
+#include "mongo/db/collection.h"
 #include "mongo/db/crash.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/instance.h"
@@ -61,9 +62,13 @@
 #include "mongo/db/ops/query.h"
 #include "mongo/db/ops/update.h"
 #include "mongo/db/ops/insert.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/top.h"
 #include "mongo/db/storage/assert_ids.h"
 #include "mongo/db/storage/env.h"
+#include "mongo/db/storage/exception.h"
+#include "mongo/platform/random.h"
 
 #include "mongo/plugins/loader.h"
 
@@ -535,6 +540,110 @@ namespace mongo {
         lastError.getSafe()->recordUpdate( res.existing , res.num , res.upserted ); // for getlasterror
     }
 
+    static void lockAndReceiveUpdate(const char *ns, Message &m, CurOp &op, const BSONObj &updateobj, const BSONObj &query,
+                                     const bool upsert, const bool multi) {
+        LOCK_REASON(lockReason, "update");
+        try {
+            Lock::DBRead lk(ns, lockReason);
+            lockedReceivedUpdate(ns, m, op, updateobj, query, upsert, multi);
+        }
+        catch (RetryWithWriteLock &e) {
+            Lock::DBWrite lk(ns, lockReason);
+            lockedReceivedUpdate(ns, m, op, updateobj, query, upsert, multi);
+        }
+    }
+
+    // Number of times a single-statement write that hit a row lock conflict
+    // is aborted and run again before the conflict goes back to the client.
+    static int lockRetries = 3;
+    ExportedServerParameter<int> lockRetriesParameter(ServerParameterSet::getGlobal(),
+                                                      "lockRetries", &lockRetries, true, true);
+
+    // Base of the jittered exponential backoff between those retries.
+    static int lockRetryBackoffMillis = 10;
+    static const int lockRetryMaxBackoffMillis = 1000;
+    class LockRetryBackoffParameter : public ExportedServerParameter<int> {
+      public:
+        LockRetryBackoffParameter()
+                : ExportedServerParameter<int>(ServerParameterSet::getGlobal(), "lockRetryBackoff",
+                                               &lockRetryBackoffMillis, true, true) {}
+      protected:
+        virtual Status validate(const int& potentialNewValue) {
+            if (potentialNewValue <= 0 || potentialNewValue > lockRetryMaxBackoffMillis) {
+                return Status(ErrorCodes::BadValue,
+                              str::stream() << "lockRetryBackoff must be in (0, "
+                                            << lockRetryMaxBackoffMillis << "]");
+            }
+            return Status::OK();
+        }
+    } lockRetryBackoffParameter;
+
+    // Each thread jitters its retries with a generator of its own.
+    static boost::thread_specific_ptr<PseudoRandom> lockRetryRandom;
+
+    // @return a number of milliseconds in [1, maxMillis]
+    static int lockRetryJitter(int maxMillis) {
+        if (lockRetryRandom.get() == NULL) {
+            scoped_ptr<SecureRandom> sr(SecureRandom::create());
+            lockRetryRandom.reset(new PseudoRandom(sr->nextInt64()));
+        }
+        return static_cast<int>(static_cast<uint32_t>(lockRetryRandom->nextInt32()) % maxMillis) + 1;
+    }
+
+    /**
+     * Run a write, which takes its own locks and transaction, retrying it if
+     * it fails to get a row lock.  The failed attempt's transaction has been
+     * aborted by then, so running it again is like the client resending it,
+     * minus the round trip.
+     */
+    static void runWithLockRetries(const StringData &ns, CurOp &op, const boost::function<void ()> &write) {
+        if (cc().hasTxn()) {
+            // In a multi-statement transaction only our child transaction is
+            // aborted, the client's transaction keeps the locks it already has
+            // and has to decide for itself what to do about the conflict.
+            write();
+            return;
+        }
+        for (int attempt = 0; ; ++attempt) {
+            Timer t;
+            try {
+                write();
+                return;
+            }
+            catch (storage::LockException &e) {
+                Top::global.recordLockNotGranted(ns, t.micros());
+                if (attempt >= lockRetries) {
+                    throw;
+                }
+                // full jitter, so that the writers that conflicted don't all
+                // come back at the same time
+                const int maxBackoff = std::min(lockRetryBackoffMillis << std::min(attempt, 10),
+                                                lockRetryMaxBackoffMillis);
+                const int backoff = lockRetryJitter(maxBackoff);
+                LOG(1) << "retrying " << opToString(op.getOp()) << " on " << ns << " in " << backoff
+                       << "ms after lock conflict: " << e.what() << endl;
+                op.debug().lockRetries++;
+                Top::global.recordLockRetry(ns, backoff * 1000LL);
+                sleepmillis(backoff);
+                killCurrentOp.checkForInterrupt();
+            }
+        }
+    }
+
+    /**
+     * Writes sent with WriteOption_WaitForLogFlush return once their commit
+     * is durable, like a getLastError with j:true.  Must be called without
+     * any locks held.
+     */
+    static void waitForLogFlushIfRequested(DbMessage& d) {
+        // Outside a multi-statement transaction the write has committed by
+        // now, and with a zero logFlushPeriod that commit synced the log.
+        if ((d.reservedField() & Reserved_WaitForLogFlush) &&
+            cmdLine.logFlushPeriod != 0 && !cc().hasTxn()) {
+            storage::wait_for_log_flush();
+        }
+    }
+
     void receivedUpdate(Message& m, CurOp& op) {
         DbMessage d(m);
         const char *ns = d.getns();
@@ -570,15 +679,27 @@ namespace mongo {
             return;
         }
 
-        LOCK_REASON(lockReason, "update");
-        try {
-            Lock::DBRead lk(ns, lockReason);
-            lockedReceivedUpdate(ns, m, op, updateobj, query, upsert, multi);
-        }
-        catch (RetryWithWriteLock &e) {
-            Lock::DBWrite lk(ns, lockReason);
-            lockedReceivedUpdate(ns, m, op, updateobj, query, upsert, multi);
-        }
+        runWithLockRetries(ns, op, boost::bind(lockAndReceiveUpdate, ns, boost::ref(m), boost::ref(op),
+                                                updateobj, query, upsert, multi));
+        waitForLogFlushIfRequested(d);
+    }
+
+    static void lockAndReceiveDelete(const char *ns, CurOp &op, const BSONObj &pattern, const bool justOne) {
+        LOCK_REASON(lockReason, "delete");
+        Lock::DBRead lk(ns, lockReason);
+
+        // writelock is used to synchronize stepdowns w/ writes
+        uassert(10056, "not master", isMasterNs(ns));
+
+        Client::Context ctx(ns);
+        long long n;
+        scoped_ptr<Client::AlternateTransactionStack> altStack(opNeedsAltTxn(ns) ? new Client::AlternateTransactionStack : NULL);
+        Client::Transaction transaction(DB_SERIALIZABLE);
+        n = deleteObjects(ns, pattern, justOne, true);
+        transaction.commit();
+
+        lastError.getSafe()->recordDelete( n );
+        op.debug().ndeleted = n;
     }
 
     void receivedDelete(Message& m, CurOp& op) {
@@ -609,21 +730,8 @@ namespace mongo {
             return;
         }
 
-        LOCK_REASON(lockReason, "delete");
-        Lock::DBRead lk(ns, lockReason);
-
-        // writelock is used to synchronize stepdowns w/ writes
-        uassert(10056, "not master", isMasterNs(ns));
-
-        Client::Context ctx(ns);
-        long long n;
-        scoped_ptr<Client::AlternateTransactionStack> altStack(opNeedsAltTxn(ns) ? new Client::AlternateTransactionStack : NULL);
-        Client::Transaction transaction(DB_SERIALIZABLE);
-        n = deleteObjects(ns, pattern, justOne, true);
-        transaction.commit();
-
-        lastError.getSafe()->recordDelete( n );
-        op.debug().ndeleted = n;
+        runWithLockRetries(ns, op, boost::bind(lockAndReceiveDelete, ns, boost::ref(op), pattern, justOne));
+        waitForLogFlushIfRequested(d);
     }
 
     QueryResult* emptyMoreResult(long long);
@@ -656,6 +764,9 @@ namespace mongo {
         QueryResult* msgdata = 0;
         GTID last;
         bool isOplog = false;
+        // for tailable collections other than the oplog
+        TailableNotifier *notifier = NULL;
+        unsigned long long notifierVersion = 0;
         while( 1 ) {
             bool isCursorAuthorized = false;
             try {
@@ -740,11 +851,27 @@ namespace mongo {
                             pass = 10000;
                         }
                     }
-                    if (debug) {
-                        sleepmillis(20);
+                    if (str::startsWith(ns, "local.oplog.")) {
+                        // an oplog without a replica set isn't notified, poll it
+                        if (debug) {
+                            sleepmillis(20);
+                        }
+                        else {
+                            sleepmillis(2);
+                        }
                     }
-                    else {
-                        sleepmillis(2);
+                    else if (pass < 10000) {
+                        // Capped collections notify us when a commit makes more
+                        // data visible. The first time round, start listening and
+                        // look again right away, in case a commit came in before.
+                        if (notifier == NULL) {
+                            notifier = TailableNotifier::get(ns);
+                        }
+                        else {
+                            notifier->waitForChange(notifierVersion,
+                                                    std::max(4000 - timer->millis(), 1));
+                        }
+                        notifierVersion = notifier->version();
                     }
                 }
                 else {
@@ -914,6 +1041,18 @@ namespace mongo {
         op.debug().ninserted = n;
     }
 
+    static void lockAndReceiveInsert(const char *ns, Message &m, const vector<BSONObj> &objs, CurOp &op, const bool keepGoing) {
+        LOCK_REASON(lockReason, "insert");
+        try {
+            Lock::DBRead lk(ns, lockReason);
+            lockedReceivedInsert(ns, m, objs, op, keepGoing);
+        }
+        catch (RetryWithWriteLock &e) {
+            Lock::DBWrite lk(ns, lockReason);
+            lockedReceivedInsert(ns, m, objs, op, keepGoing);
+        }
+    }
+
     void receivedInsert(Message& m, CurOp& op) {
         DbMessage d(m);
         const char *ns = d.getns();
@@ -958,15 +1097,9 @@ namespace mongo {
             }
         }
 
-        LOCK_REASON(lockReason, "insert");
-        try {
-            Lock::DBRead lk(ns, lockReason);
-            lockedReceivedInsert(ns, m, objs, op, keepGoing);
-        }
-        catch (RetryWithWriteLock &e) {
-            Lock::DBWrite lk(ns, lockReason);
-            lockedReceivedInsert(ns, m, objs, op, keepGoing);
-        }
+        runWithLockRetries(ns, op, boost::bind(lockAndReceiveInsert, ns, boost::ref(m), boost::cref(objs),
+                                                boost::ref(op), keepGoing));
+        waitForLogFlushIfRequested(d);
     }
 
     struct getDatabaseNamesExtra {
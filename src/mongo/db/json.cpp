@@ -15,6 +15,10 @@
 
 #include "mongo/db/json.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "mongo/db/jsobj.h"
 #include "mongo/platform/cstdint.h"
 #include "mongo/util/base64.h"
@@ -35,18 +39,26 @@ namespace mongo {
 #define CONTROL "\a\b\f\n\r\t\v"
 #define JOPTIONS "gims"
 
-    // Size hints given to char vectors
+    // Size hints given to char vectors.  Field names and string values are
+    // parsed for every element, so those start small and grow as needed.
     enum {
         ID_RESERVE_SIZE = 64,
         PAT_RESERVE_SIZE = 4096,
         OPT_RESERVE_SIZE = 64,
-        FIELD_RESERVE_SIZE = 4096,
-        STRINGVAL_RESERVE_SIZE = 4096,
+        FIELD_RESERVE_SIZE = 64,
+        STRINGVAL_RESERVE_SIZE = 64,
         BINDATA_RESERVE_SIZE = 4096,
         BINDATATYPE_RESERVE_SIZE = 4096,
         NS_RESERVE_SIZE = 64
     };
 
+    // Bounds on the initial size of the builder fromjson() uses, which is
+    // otherwise the length of the JSON text.
+    enum {
+        OBJ_MIN_RESERVE_SIZE = 512,
+        OBJ_MAX_RESERVE_SIZE = 64 * 1024
+    };
+
     static const char* LBRACE = "{",
                  *RBRACE = "}",
                  *LBRACKET = "[",
@@ -62,6 +74,48 @@ namespace mongo {
     JParse::JParse(const char* str)
         : _buf(str), _input(str), _input_end(str + strlen(str)) {}
 
+    JParse::JParse(const char* str, const char* end)
+        : _buf(str), _input(str), _input_end(end) {
+        dassert(*end == '\0');
+    }
+
+    namespace {
+
+        inline bool isControlChar(char c) {
+            return static_cast<unsigned char>(c) <= 0x1F;
+        }
+
+        /**
+         * @return the first character in [p, end) that is the terminal
+         * character, a backslash or a control character.  Everything before
+         * it can be copied into a string value as is.
+         */
+        const char* skipPlainChars(const char* p, const char* end, char terminal) {
+#if defined(__SSE2__)
+            const __m128i term = _mm_set1_epi8(terminal);
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i maxControl = _mm_set1_epi8(0x1F);
+            for (; end - p >= 16; p += 16) {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i special = _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(block, term),
+                                     _mm_cmpeq_epi8(block, backslash)),
+                        // unsigned block <= 0x1F
+                        _mm_cmpeq_epi8(_mm_min_epu8(block, maxControl), block));
+                const unsigned mask = _mm_movemask_epi8(special);
+                if (mask) {
+                    return p + __builtin_ctz(mask);
+                }
+            }
+#endif
+            while (p < end && *p != terminal && *p != '\\' && !isControlChar(*p)) {
+                ++p;
+            }
+            return p;
+        }
+
+    } // namespace
+
     Status JParse::parseError(const StringData& msg) {
         std::ostringstream ossmsg;
         ossmsg << msg;
@@ -72,7 +126,21 @@ namespace mongo {
 
     Status JParse::value(const StringData& fieldName, BSONObjBuilder& builder) {
         MONGO_JSON_DEBUG("fieldName: " << fieldName);
-        if (accept(LBRACE, false)) {
+        // Numbers and strings are most values; recognize them before trying
+        // each of the keywords and extensions.
+        if (peekNumber()) {
+            return number(fieldName, builder);
+        }
+        if (accept(DOUBLEQUOTE, false) || accept(SINGLEQUOTE, false)) {
+            std::string valueString;
+            valueString.reserve(STRINGVAL_RESERVE_SIZE);
+            Status ret = quotedString(&valueString);
+            if (ret != Status::OK()) {
+                return ret;
+            }
+            builder.append(fieldName, valueString);
+        }
+        else if (accept(LBRACE, false)) {
             Status ret = object(fieldName, builder);
             if (ret != Status::OK()) {
                 return ret;
@@ -120,15 +188,6 @@ namespace mongo {
                 return ret;
             }
         }
-        else if (accept(DOUBLEQUOTE, false) || accept(SINGLEQUOTE, false)) {
-            std::string valueString;
-            valueString.reserve(STRINGVAL_RESERVE_SIZE);
-            Status ret = quotedString(&valueString);
-            if (ret != Status::OK()) {
-                return ret;
-            }
-            builder.append(fieldName, valueString);
-        }
         else if (accept("true")) {
             builder.append(fieldName, true);
         }
@@ -713,7 +772,51 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool JParse::peekNumber() const {
+        const char* p = _input;
+        while (p < _input_end && isspace(*p)) {
+            ++p;
+        }
+        if (p < _input_end && *p == '-') {
+            ++p;
+        }
+        return p < _input_end && isdigit(*p);
+    }
+
     Status JParse::number(const StringData& fieldName, BSONObjBuilder& builder) {
+        // Plain decimal integers short enough not to overflow are parsed
+        // here; anything else goes through both strtod and strtoll below.
+        {
+            const char* p = _input;
+            while (p < _input_end && isspace(*p)) {
+                ++p;
+            }
+            const bool negative = (p < _input_end && *p == '-');
+            if (negative) {
+                ++p;
+            }
+            const char* digits = p;
+            long long retll = 0;
+            while (p < _input_end && isdigit(*p) && p - digits < 18) {
+                retll = retll * 10 + (*p - '0');
+                ++p;
+            }
+            if (p > digits && p < _input_end && !isdigit(*p) &&
+                    *p != '.' && *p != 'e' && *p != 'E' && *p != 'x' && *p != 'X') {
+                if (negative) {
+                    retll = -retll;
+                }
+                if (retll == static_cast<int>(retll)) {
+                    builder.append(fieldName, static_cast<int>(retll));
+                }
+                else {
+                    builder.append(fieldName, retll);
+                }
+                _input = p;
+                return Status::OK();
+            }
+        }
+
         char* endptrll;
         char* endptrd;
         long long retll;
@@ -812,15 +915,27 @@ namespace mongo {
             return parseError("Unexpected end of input");
         }
         const char* q = _input;
+        // Quoted strings and regexes end at a single character; copy the runs
+        // between escapes in bulk.
+        const bool singleTerminal = (allowedSet == NULL && terminalSet[0] != '\0' &&
+                                     terminalSet[1] == '\0');
         while (q < _input_end && !match(*q, terminalSet)) {
             MONGO_JSON_DEBUG("q: " << q);
+            if (singleTerminal) {
+                const char* run = skipPlainChars(q, _input_end, *terminalSet);
+                result->append(q, run - q);
+                q = run;
+                if (q >= _input_end || *q == *terminalSet) {
+                    break;
+                }
+            }
             if (allowedSet != NULL) {
                 if (!match(*q, allowedSet)) {
                     _input = q;
                     return Status::OK();
                 }
             }
-            if (0x00 <= *q && *q <= 0x1F) {
+            if (isControlChar(*q)) {
                 return parseError("Invalid control character");
             }
             if (*q == '\\' && q + 1 < _input_end) {
@@ -968,13 +1083,20 @@ namespace mongo {
     }
 
     BSONObj fromjson(const char* jsonString, int* len) {
+        return fromjson(jsonString, jsonString + strlen(jsonString), len);
+    }
+
+    BSONObj fromjson(const char* jsonString, const char* end, int* len) {
         MONGO_JSON_DEBUG("jsonString: " << jsonString);
         if (jsonString[0] == '\0') {
             if (len) *len = 0;
             return BSONObj();
         }
-        JParse jparse(jsonString);
-        BSONObjBuilder builder;
+        JParse jparse(jsonString, end);
+        const int initsize = std::max<ptrdiff_t>(OBJ_MIN_RESERVE_SIZE,
+                                                 std::min<ptrdiff_t>(end - jsonString,
+                                                                     OBJ_MAX_RESERVE_SIZE));
+        BSONObjBuilder builder(initsize);
         Status ret = jparse.object("UNUSED", builder, false);
         if (ret != Status::OK()) {
             ostringstream message;
@@ -982,7 +1104,13 @@ namespace mongo {
             throw MsgAssertionException(16619, message.str());
         }
         if (len) *len = jparse.offset();
-        return builder.obj();
+        BSONObj obj = builder.obj();
+        // The builder was sized from all the text up to end, which may hold many more
+        // objects (mongoimport --jsonArray), so don't keep a mostly unused buffer alive.
+        if (initsize > OBJ_MIN_RESERVE_SIZE && obj.objsize() < initsize / 2) {
+            return obj.copy();
+        }
+        return obj;
     }
 
     BSONObj fromjson(const std::string& str) {
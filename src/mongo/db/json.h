@@ -41,6 +41,13 @@ namespace mongo {
     /** @param len will be size of JSON object in text chars. */
     BSONObj fromjson(const char* str, int* len=NULL);
 
+    /**
+     * Same as fromjson(str, len), for callers that already know where str
+     * ends, such as when parsing many objects out of one large buffer.
+     * @param end must point to the null byte terminating str.
+     */
+    BSONObj fromjson(const char* str, const char* end, int* len);
+
     /**
      * Parser class.  A BSONObj is constructed incrementally by passing a
      * BSONObjBuilder to the recursive parsing methods.  The grammar for the
@@ -50,6 +57,9 @@ namespace mongo {
         public:
             explicit JParse(const char*);
 
+            /** @param end must point to the null byte terminating str */
+            JParse(const char* str, const char* end);
+
             /*
              * Notation: All-uppercase symbols denote non-terminals; all other
              * symbols are literals.
@@ -314,6 +324,13 @@ namespace mongo {
              */
             Status chars(std::string* result, const char* terminalSet, const char* allowedSet=NULL);
 
+            /**
+             * @return true if the next non whitespace characters start a
+             * number that value() can hand straight to number(), without
+             * trying each of the keywords first.
+             */
+            bool peekNumber() const;
+
             /**
              * Converts the two byte Unicode code point to its UTF8 character
              * encoding representation.  This function returns a string because
@@ -578,6 +578,50 @@ namespace mongo {
         while ( i.more() ) {
             parseMatchExpressionElement( i.next(), nested );
         }
+        initBasicFields();
+    }
+
+    void Matcher::initBasicFields() {
+        // Key matchers look fields up by index position instead, and a
+        // single predicate gains nothing from a separate extraction pass.
+        if ( !_constrainIndexKey.isEmpty() || _basics.size() < 2 ) {
+            return;
+        }
+        vector<string> fields;
+        vector<unsigned> fieldIndex;
+        for ( unsigned i = 0; i < _basics.size(); i++ ) {
+            const char *fieldName = _basics[i]._toMatch.fieldName();
+            const char *p = strchr( fieldName, '.' );
+            const string top = p ? string( fieldName, p - fieldName ) : string( fieldName );
+            vector<string>::const_iterator it = std::find( fields.begin(), fields.end(), top );
+            if ( it == fields.end() ) {
+                if ( fields.size() == maxBasicFields ) {
+                    return;
+                }
+                it = fields.insert( fields.end(), top );
+            }
+            fieldIndex.push_back( it - fields.begin() );
+        }
+        _basicFields.swap( fields );
+        _basicFieldIndex.swap( fieldIndex );
+    }
+
+    void Matcher::extractBasicFields(const BSONObj &obj, BSONElement *out) const {
+        const size_t n = _basicFields.size();
+        size_t remaining = n;
+        BSONObjIterator it( obj );
+        while ( remaining > 0 && it.more() ) {
+            BSONElement e = it.next();
+            const char *name = e.fieldName();
+            for ( size_t i = 0; i < n; i++ ) {
+                // Like getField(), the first of several fields with the same name wins.
+                if ( out[i].eoo() && _basicFields[i] == name ) {
+                    out[i] = e;
+                    remaining--;
+                    break;
+                }
+            }
+        }
     }
 
     Matcher::Matcher( const Matcher &docMatcher, const BSONObj &key ) :
@@ -707,8 +751,8 @@ namespace mongo {
         return (op & z);
     }
 
-    int Matcher::inverseMatch(const char *fieldName, const BSONElement &toMatch, const BSONObj &obj, const ElementMatcher& bm , MatchDetails * details ) const {
-        int inverseRet = matchesDotted( fieldName, toMatch, obj, bm.inverseOfNegativeCompareOp(), bm , false , details );
+    int Matcher::inverseMatch(const char *fieldName, const BSONElement &toMatch, const BSONObj &obj, const ElementMatcher& bm , MatchDetails * details , const BSONElement *topLevel ) const {
+        int inverseRet = matchesDotted( fieldName, toMatch, obj, bm.inverseOfNegativeCompareOp(), bm , false , details , topLevel );
         if ( bm.negativeCompareOpContainsNull() ) {
             return ( inverseRet <= 0 ) ? 1 : 0;
         }
@@ -738,7 +782,7 @@ namespace mongo {
         0 missing element
         1 match
     */
-    int Matcher::matchesDotted(const char *fieldName, const BSONElement& toMatch, const BSONObj& obj, int compareOp, const ElementMatcher& em , bool isArr, MatchDetails * details ) const {
+    int Matcher::matchesDotted(const char *fieldName, const BSONElement& toMatch, const BSONObj& obj, int compareOp, const ElementMatcher& em , bool isArr, MatchDetails * details , const BSONElement *topLevel ) const {
         DEBUGMATCHER( "\t matchesDotted : " << fieldName << " hasDetails: " << ( details ? "yes" : "no" ) );
 
         if ( compareOp == BSONObj::opALL ) {
@@ -746,7 +790,7 @@ namespace mongo {
             if ( em._allMatchers.size() ) {
                 // $all query matching will not be performed against indexes, so the field
                 // to match is always extracted from the full document.
-                BSONElement e = obj.getFieldDotted( fieldName );
+                BSONElement e = ( topLevel && !strchr( fieldName, '.' ) ) ? *topLevel : obj.getFieldDotted( fieldName );
                 // The $all/$elemMatch operator only matches arrays.
                 if ( e.type() != Array ) {
                     return -1;
@@ -807,7 +851,7 @@ namespace mongo {
         } // end opALL
 
         if ( compareOp == BSONObj::NE || compareOp == BSONObj::NIN ) {
-            return inverseMatch( fieldName, toMatch, obj, em , details );
+            return inverseMatch( fieldName, toMatch, obj, em , details , topLevel );
         }
 
         BSONElement e;
@@ -825,9 +869,14 @@ namespace mongo {
 
             const char *p = strchr(fieldName, '.');
             if ( p ) {
-                string left(fieldName, p-fieldName);
-
-                BSONElement se = obj.getField(left.c_str());
+                BSONElement se;
+                if ( topLevel ) {
+                    se = *topLevel;
+                }
+                else {
+                    string left(fieldName, p-fieldName);
+                    se = obj.getField(left.c_str());
+                }
                 if ( se.eoo() )
                     ;
                 else if ( se.type() != Object && se.type() != Array )
@@ -880,7 +929,7 @@ namespace mongo {
                 return 0;
             }
             else {
-                e = obj.getField(fieldName);
+                e = topLevel ? *topLevel : obj.getField(fieldName);
             }
         }
 
@@ -952,12 +1001,21 @@ namespace mongo {
         /* assuming there is usually only one thing to match.  if more this
            could be slow sometimes. */
 
+        // With several predicates, find all the top level fields they need
+        // in one walk of the document rather than one scan per predicate.
+        BSONElement topLevel[maxBasicFields];
+        const bool extracted = !_basicFields.empty();
+        if ( extracted ) {
+            extractBasicFields( jsobj, topLevel );
+        }
+
         // check normal non-regex cases:
         for ( unsigned i = 0; i < _basics.size(); i++ ) {
             const ElementMatcher& bm = _basics[i];
             const BSONElement& m = bm._toMatch;
             // -1=mismatch. 0=missing element. 1=match
-            int cmp = matchesDotted(m.fieldName(), m, jsobj, bm._compareOp, bm , false , details );
+            int cmp = matchesDotted(m.fieldName(), m, jsobj, bm._compareOp, bm , false , details ,
+                                    extracted ? &topLevel[_basicFieldIndex[i]] : NULL );
             if ( cmp == 0 && bm._compareOp == BSONObj::opEXISTS ) {
                 // If missing, match cmp is opposite of $exists spec.
                 cmp = -retExistsFound(bm);
@@ -245,10 +245,15 @@ namespace mongo {
        TODO: we should rewrite the matcher to be more an AST style.
     */
     class Matcher : boost::noncopyable {
+        /**
+         * @param topLevel if non-NULL, the element of obj named by the first component of
+         * fieldName, already looked up by the caller (eoo if obj has no such field).
+         */
         int matchesDotted(
             const char *fieldName,
             const BSONElement& toMatch, const BSONObj& obj,
-            int compareOp, const ElementMatcher& bm, bool isArr , MatchDetails * details ) const;
+            int compareOp, const ElementMatcher& bm, bool isArr , MatchDetails * details,
+            const BSONElement *topLevel = NULL ) const;
 
         /**
          * Perform a NE or NIN match by returning the inverse of the opposite matching operation.
@@ -257,7 +262,8 @@ namespace mongo {
         int inverseMatch(
             const char *fieldName,
             const BSONElement &toMatch, const BSONObj &obj,
-            const ElementMatcher&bm, MatchDetails * details ) const;
+            const ElementMatcher&bm, MatchDetails * details,
+            const BSONElement *topLevel = NULL ) const;
 
     public:
         static int opDirection(int op) {
@@ -337,6 +343,14 @@ namespace mongo {
 
         int valuesMatch(const BSONElement& l, const BSONElement& r, int op, const ElementMatcher& bm) const;
 
+        /**
+         * Set up _basicFields so matches() can find every top level field the
+         * basic predicates need in a single walk of the document.
+         */
+        void initBasicFields();
+        /** Fill out[i] with the first field of obj named _basicFields[i], or eoo. */
+        void extractBasicFields(const BSONObj &obj, BSONElement *out) const;
+
         bool parseClause( const BSONElement &e );
         void parseExtractedClause( const BSONElement &e, list< shared_ptr< Matcher > > &matchers );
 
@@ -347,6 +361,11 @@ namespace mongo {
         BSONObj _jsobj;                  // the query pattern.  e.g., { name: "joe" }
         BSONObj _constrainIndexKey;
         vector<ElementMatcher> _basics;
+        // distinct top level field names used by _basics, and for each of
+        // _basics the index of its field; empty if not worth extracting
+        static const size_t maxBasicFields = 16;
+        vector<string> _basicFields;
+        vector<unsigned> _basicFieldIndex;
         bool _haveSize;
         bool _all;
         bool _hasArray;
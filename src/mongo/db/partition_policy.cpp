@@ -0,0 +1,267 @@
+// partition_policy.cpp
+
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/partition_policy.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/db/collection.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/databaseholder.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/replutil.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/assert_ids.h"
+#include "mongo/util/background.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    PartitionPolicy::PartitionPolicy() :
+        _maxDocs(0),
+        _maxSize(0),
+        _maxAgeMillis(0),
+        _maxPartitions(0),
+        _expireMillis(0) {
+    }
+
+    PartitionPolicy::PartitionPolicy(const BSONElement &e) :
+        _maxDocs(0),
+        _maxSize(0),
+        _maxAgeMillis(0),
+        _maxPartitions(0),
+        _expireMillis(0) {
+        if (e.eoo()) {
+            return;
+        }
+        uassert(17375, "partitionPolicy must be an object", e.type() == Object);
+        for (BSONObjIterator it(e.Obj()); it.more(); ) {
+            const BSONElement rule = it.next();
+            const StringData name(rule.fieldName());
+            uassert(17376, mongoutils::str::stream() << "partitionPolicy " << name
+                           << " must be a positive number",
+                    rule.isNumber() && rule.numberLong() > 0);
+            const long long value = rule.numberLong();
+            if (name == "maxDocs") {
+                _maxDocs = value;
+            } else if (name == "maxSize") {
+                _maxSize = value;
+            } else if (name == "maxAgeSeconds") {
+                _maxAgeMillis = value * 1000;
+            } else if (name == "maxPartitions") {
+                _maxPartitions = value;
+            } else if (name == "expireAfterSeconds") {
+                _expireMillis = value * 1000;
+            } else {
+                uasserted(17377, mongoutils::str::stream() << "unknown partitionPolicy field " << name);
+            }
+        }
+    }
+
+    bool PartitionPolicy::empty() const {
+        return _maxDocs == 0 && _maxSize == 0 && _maxAgeMillis == 0 &&
+               _maxPartitions == 0 && _expireMillis == 0;
+    }
+
+    bool PartitionPolicy::shouldRollOver(uint64_t docs, uint64_t size, long long createTime, long long now) const {
+        if (docs == 0) {
+            // an empty partition cannot be capped
+            return false;
+        }
+        return (_maxDocs > 0 && docs >= (uint64_t) _maxDocs) ||
+               (_maxSize > 0 && size >= (uint64_t) _maxSize) ||
+               (_maxAgeMillis > 0 && now - createTime >= _maxAgeMillis);
+    }
+
+    bool PartitionPolicy::shouldDrop(uint64_t numPartitions, long long nextCreateTime, long long now) const {
+        if (numPartitions <= 1) {
+            return false;
+        }
+        return (_maxPartitions > 0 && numPartitions > (uint64_t) _maxPartitions) ||
+               (_expireMillis > 0 && now - nextCreateTime >= _expireMillis);
+    }
+
+    Counter64 partitionPolicyPasses;
+    Counter64 partitionPolicyAdded;
+    Counter64 partitionPolicyDropped;
+
+    ServerStatusMetricField<Counter64> partitionPolicyPassesDisplay("partitionPolicy.passes", &partitionPolicyPasses);
+    ServerStatusMetricField<Counter64> partitionPolicyAddedDisplay("partitionPolicy.partitionsAdded", &partitionPolicyAdded);
+    ServerStatusMetricField<Counter64> partitionPolicyDroppedDisplay("partitionPolicy.partitionsDropped", &partitionPolicyDropped);
+
+    MONGO_EXPORT_SERVER_PARAMETER(partitionPolicyMonitorEnabled, bool, true);
+    // how long the monitor sleeps between passes
+    MONGO_EXPORT_SERVER_PARAMETER(partitionPolicyMonitorSleepSecs, int, 60);
+
+    class PartitionPolicyMonitor : public BackgroundJob {
+    public:
+        PartitionPolicyMonitor() { }
+        virtual ~PartitionPolicyMonitor() { }
+
+        virtual string name() const { return "PartitionPolicyMonitor"; }
+
+        void doPolicyForDB(const string &dbName) {
+            // partitions are only added and dropped on the primary,
+            // secondaries replay the commands it logs
+            if (!isMasterNs(dbName.c_str())) {
+                return;
+            }
+
+            Client::GodScope god;
+
+            vector<string> namespaces;
+            {
+                auto_ptr<DBClientCursor> cursor =
+                    db.query(getSisterNS(dbName, "system.namespaces"),
+                             BSON("options.partitionPolicy" << BSON("$exists" << true)));
+                if (cursor.get()) {
+                    while (cursor->more()) {
+                        namespaces.push_back(cursor->next()["name"].String());
+                    }
+                }
+            }
+
+            for (vector<string>::const_iterator it = namespaces.begin(); it != namespaces.end(); ++it) {
+                try {
+                    doPolicyForCollection(*it);
+                }
+                catch (DBException &e) {
+                    error() << "error applying partition policy for " << *it << " " << e << endl;
+                }
+            }
+        }
+
+        void doPolicyForCollection(const string &ns) {
+            const string dbName = nsToDatabase(ns);
+            const string coll = nsToCollectionSubstring(ns).toString();
+
+            bool rollOver = false;
+            {
+                LOCK_REASON(lockReason, "partition policy: checking last partition");
+                Client::ReadContext ctx(ns, lockReason);
+                Client::Transaction transaction(DB_TXN_SNAPSHOT | DB_TXN_READ_ONLY);
+                Collection *cl = getCollection(ns);
+                if (cl == NULL || !cl->isPartitioned()) {
+                    // collection was dropped
+                    return;
+                }
+                PartitionedCollection *pc = cl->as<PartitionedCollection>();
+                const uint64_t last = pc->numPartitions() - 1;
+                CollectionData::Stats stats;
+                pc->getPartition(last)->fillCollectionStats(stats, NULL, 1);
+                const long long createTime = pc->getPartitionMetadata(last)["createTime"]._numberLong();
+                rollOver = pc->partitionPolicy().shouldRollOver(stats.count, stats.size,
+                                                                createTime, curTimeMillis64());
+                transaction.commit();
+            }
+            if (rollOver) {
+                BSONObj res;
+                if (db.runCommand(dbName, BSON("addPartition" << coll), res)) {
+                    LOG(1) << "partition policy: added a partition to " << ns << endl;
+                    partitionPolicyAdded.increment();
+                } else if (res["code"].numberInt() == storage::ASSERT_IDS::CapPartitionFailed) {
+                    // the stats overestimated, the last partition is empty
+                    LOG(1) << "partition policy: could not cap the last partition of " << ns << endl;
+                } else {
+                    error() << "partition policy: adding a partition to " << ns << " failed: " << res << endl;
+                }
+            }
+
+            vector<long long> toDrop;
+            {
+                LOCK_REASON(lockReason, "partition policy: checking oldest partitions");
+                Client::ReadContext ctx(ns, lockReason);
+                Client::Transaction transaction(DB_TXN_SNAPSHOT | DB_TXN_READ_ONLY);
+                Collection *cl = getCollection(ns);
+                if (cl == NULL || !cl->isPartitioned()) {
+                    return;
+                }
+                PartitionedCollection *pc = cl->as<PartitionedCollection>();
+                const PartitionPolicy &policy = pc->partitionPolicy();
+                const long long now = curTimeMillis64();
+                const uint64_t n = pc->numPartitions();
+                for (uint64_t i = 0; i + 1 < n; i++) {
+                    const BSONObj next = pc->getPartitionMetadata(i + 1);
+                    if (!policy.shouldDrop(n - i, next["createTime"]._numberLong(), now)) {
+                        break;
+                    }
+                    toDrop.push_back(pc->getPartitionMetadata(i)["_id"].numberLong());
+                }
+                transaction.commit();
+            }
+            for (vector<long long>::const_iterator it = toDrop.begin(); it != toDrop.end(); ++it) {
+                BSONObj res;
+                if (!db.runCommand(dbName, BSON("dropPartition" << coll << "id" << *it), res)) {
+                    error() << "partition policy: dropping partition " << *it << " of " << ns
+                            << " failed: " << res << endl;
+                    break;
+                }
+                LOG(1) << "partition policy: dropped partition " << *it << " of " << ns << endl;
+                partitionPolicyDropped.increment();
+            }
+        }
+
+        virtual void run() {
+            Client::initThread(name().c_str());
+
+            while (!inShutdown()) {
+                sleepsecs(std::max(partitionPolicyMonitorSleepSecs, 1));
+
+                LOG(3) << "PartitionPolicyMonitor thread awake" << endl;
+
+                if (!partitionPolicyMonitorEnabled || cmdLine.gdb) {
+                    LOG(1) << "PartitionPolicyMonitor is disabled" << endl;
+                    continue;
+                }
+
+                // if part of replSet but not in a readable state (e.g. during initial sync), skip.
+                if (theReplSet && !theReplSet->state().readable()) {
+                    continue;
+                }
+
+                set<string> dbs;
+                {
+                    LOCK_REASON(lockReason, "partition policy: getting list of dbs");
+                    Lock::DBRead lk("local", lockReason);
+                    dbHolder().getAllShortNames(dbs);
+                }
+
+                partitionPolicyPasses.increment();
+
+                for (set<string>::const_iterator i = dbs.begin(); i != dbs.end(); ++i) {
+                    const string &dbName = *i;
+                    try {
+                        doPolicyForDB(dbName);
+                    }
+                    catch (DBException &e) {
+                        error() << "error applying partition policies for db: " << dbName << " " << e << endl;
+                    }
+                }
+            }
+        }
+
+        DBDirectClient db;
+    };
+
+    void startPartitionPolicyBackgroundJob() {
+        PartitionPolicyMonitor *monitor = new PartitionPolicyMonitor();
+        monitor->go();
+    }
+
+} // namespace mongo
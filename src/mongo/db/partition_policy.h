@@ -0,0 +1,65 @@
+// partition_policy.h
+
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    // When a partitioned collection's last partition is capped and a new
+    // one appended, and when its oldest partitions are dropped, as given
+    // by the partitionPolicy option at creation. For example
+    //
+    //   { maxDocs: 1000000, maxAgeSeconds: 86400, maxPartitions: 30 }
+    //
+    // rolls over once the last partition holds a million documents or is
+    // a day old, and keeps the newest 30 partitions. The rules are applied
+    // by a background job on the primary, through the addPartition and
+    // dropPartition commands, so they replicate like manual changes do.
+    class PartitionPolicy {
+    public:
+        // no policy, nothing happens automatically
+        PartitionPolicy();
+        // uasserts if e is neither EOO nor a valid policy
+        explicit PartitionPolicy(const BSONElement &e);
+
+        bool empty() const;
+
+        // Whether the last partition, holding about docs documents taking
+        // about size bytes and created at createTime, should be capped.
+        bool shouldRollOver(uint64_t docs, uint64_t size, long long createTime, long long now) const;
+        // Whether the oldest of numPartitions partitions should be dropped,
+        // given when the one after it was created, which is about when the
+        // oldest stopped receiving new documents.
+        bool shouldDrop(uint64_t numPartitions, long long nextCreateTime, long long now) const;
+
+    private:
+        // zero when not given
+        long long _maxDocs;
+        long long _maxSize;
+        long long _maxAgeMillis;
+        long long _maxPartitions;
+        long long _expireMillis;
+    };
+
+    void startPartitionPolicyBackgroundJob();
+
+} // namespace mongo
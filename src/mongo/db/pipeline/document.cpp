@@ -28,7 +28,55 @@
 namespace mongo {
     using namespace mongoutils;
 
+    DocumentStorage::DocumentStorage(const BSONObj& ownedBson)
+        : _buffer(NULL)
+        , _bufferEnd(NULL)
+        , _usedBytes(0)
+        , _numFields(0)
+        , _hashTabMask(0)
+        , _fromBson(true)
+        , _modified(false)
+        , _bsonNext(NULL)
+        , _bson(ownedBson)
+    {
+        verify(_bson.isOwned());
+        if (!_bson.isEmpty())
+            _bsonNext = _bson.objdata() + sizeof(int); // skip the length prefix
+    }
+
     Position DocumentStorage::findField(StringData requested) const {
+        const Position pos = findLoadedField(requested);
+        if (pos.found())
+            return pos;
+
+        // Not converted yet (or not there at all). Convert fields in order until we hit it.
+        while (_bsonNext) {
+            const Position loaded = loadNextField();
+            if (getField(loaded).nameSD() == requested)
+                return loaded;
+        }
+
+        return Position();
+    }
+
+    Position DocumentStorage::loadNextField() const {
+        dassert(_bsonNext);
+        const BSONElement elem(_bsonNext);
+
+        // Converting a field doesn't change the logical contents of this document, so this is
+        // allowed even though the storage may be shared by several Documents.
+        DocumentStorage* self = const_cast<DocumentStorage*>(this);
+        const Position pos = getNextPosition();
+        self->appendFieldImpl(elem.fieldName()) = Value(elem);
+
+        _bsonNext += elem.size();
+        if (*_bsonNext == EOO)
+            _bsonNext = NULL;
+
+        return pos;
+    }
+
+    Position DocumentStorage::findLoadedField(StringData requested) const {
         int reqSize = requested.size(); // get size calculation out of the way if needed
 
         if (_numFields >= HASH_TAB_MIN) { // hash lookup
@@ -47,7 +95,7 @@ namespace mongo {
             }
         }
         else { // linear scan
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+            for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance()) {
                 if (it->nameLen == reqSize
                     && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
                     return it.position();
@@ -59,7 +107,7 @@ namespace mongo {
         return Position();
     }
 
-    Value& DocumentStorage::appendField(StringData name) {
+    Value& DocumentStorage::appendFieldImpl(StringData name) {
         Position pos = getNextPosition();
         const int nameSize = name.size();
 
@@ -185,8 +233,14 @@ namespace mongo {
         out->_numFields = _numFields;
         out->_hashTabMask = _hashTabMask;
 
+        // The clone continues converting from the same (shared) BSON where we left off
+        out->_fromBson = _fromBson;
+        out->_modified = _modified;
+        out->_bsonNext = _bsonNext;
+        out->_bson = _bson;
+
         // Tell values that they have been memcpyed (updates ref counts)
-        for (DocumentStorageIterator it = out->iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = out->loadedIteratorAll(); !it.atEnd(); it.advance()) {
             it->val.memcpyed();
         }
 
@@ -196,7 +250,7 @@ namespace mongo {
     DocumentStorage::~DocumentStorage() {
         boost::scoped_array<char> deleteBufferAtScopeEnd (_buffer);
 
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance()) {
             it->val.~Value(); // explicit destructor call
         }
     }
@@ -213,6 +267,13 @@ namespace mongo {
         *this = md.freeze();
     }
 
+    Document Document::fromBsonLazy(const BSONObj& bson) {
+        if (bson.isEmpty())
+            return Document();
+
+        return Document(new DocumentStorage(bson.getOwned()));
+    }
+
     BSONObjBuilder& operator << (BSONObjBuilderValueStream& builder, const Document& doc) {
         BSONObjBuilder subobj(builder.subobjStart());
         doc.toBson(&subobj);
@@ -221,6 +282,12 @@ namespace mongo {
     }
 
     void Document::toBson(BSONObjBuilder* pBuilder) const {
+        if (storage().bsonIsCurrent()) {
+            // Unmodified lazy Document: no need to convert fields back from Values
+            pBuilder->appendElements(storage().bson());
+            return;
+        }
+
         for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
             *pBuilder << it->nameSD() << it->val;
         }
@@ -304,7 +371,8 @@ namespace mongo {
         size_t size = sizeof(DocumentStorage);
         size += storage().allocatedBytes();
 
-        for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
+        // Fields still in BSON are accounted for by allocatedBytes()
+        for (DocumentStorageIterator it = storage().loadedIterator(); !it.atEnd(); it.advance()) {
             size += it->val.getApproximateSize();
             size -= sizeof(Value); // already accounted for above
         }
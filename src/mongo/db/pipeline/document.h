@@ -60,6 +60,15 @@ namespace mongo {
         /// Create a new Document deep-converted from the given BSONObj.
         explicit Document(const BSONObj& bson);
 
+        /** Create a new Document that converts top-level fields from the given BSONObj only
+         *  when they are first looked up. Looking up a field converts all fields before it, and
+         *  anything that needs every field (iteration, compare, etc) converts the rest.
+         *
+         *  Use this when only a few fields of wide documents are likely to be read. The
+         *  BSONObj is copied if it isn't owned.
+         */
+        static Document fromBsonLazy(const BSONObj& bson);
+
         void swap(Document& rhs) { _storage.swap(rhs._storage); }
 
         /// Look up a field by key name. Returns Value() if no such field. O(1)
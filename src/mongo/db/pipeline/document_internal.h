@@ -154,7 +154,16 @@ namespace mongo {
                           , _usedBytes(0)
                           , _numFields(0)
                           , _hashTabMask(0)
+                          , _fromBson(false)
+                          , _modified(false)
+                          , _bsonNext(NULL)
         {}
+
+        /** Storage that converts the fields of an owned BSONObj into Values on first access.
+         *  Fields are converted in order, so iteration order always matches the BSONObj.
+         */
+        explicit DocumentStorage(const BSONObj& ownedBson);
+
         ~DocumentStorage();
 
         static const DocumentStorage& emptyDoc() {
@@ -173,7 +182,9 @@ namespace mongo {
         /// Returns the position of the next field to be inserted
         Position getNextPosition() const { return Position(_usedBytes); }
 
-        /// Returns the position of the named field (may be missing) or Position()
+        /** Returns the position of the named field (may be missing) or Position()
+         *  If this storage is backed by BSON, this converts fields up to the named one.
+         */
         Position findField(StringData name) const;
 
         // Document uses these
@@ -191,6 +202,7 @@ namespace mongo {
         // MutableDocument uses these
         ValueElement& getField(Position pos) {
             verify(pos.found());
+            _modified = true;
             return *(_firstElement->plusBytes(pos.index));
         }
         Value& getField(StringData name) {
@@ -201,7 +213,11 @@ namespace mongo {
         }
 
         /// Adds a new field with missing Value at the end of the document
-        Value& appendField(StringData name);
+        Value& appendField(StringData name) {
+            loadAllFields(); // new fields must go after any still in the BSON
+            _modified = true;
+            return appendFieldImpl(name);
+        }
 
         /** Preallocates space for fields. Use this to attempt to prevent buffer growth.
          *  This is only valid to call before anything is added to the document.
@@ -210,23 +226,58 @@ namespace mongo {
 
         /// This skips missing values
         DocumentStorageIterator iterator() const {
+            loadAllFields();
             return DocumentStorageIterator(_firstElement, end(), false);
         }
 
         /// This includes missing values
         DocumentStorageIterator iteratorAll() const {
+            loadAllFields();
             return DocumentStorageIterator(_firstElement, end(), true);
         }
 
+        /// Like iterator() but only visits fields that have already been converted from BSON
+        DocumentStorageIterator loadedIterator() const {
+            return DocumentStorageIterator(_firstElement, end(), false);
+        }
+
         /// Shallow copy of this. Caller owns memory.
         intrusive_ptr<DocumentStorage> clone() const;
 
         size_t allocatedBytes() const {
-            return !_buffer ? 0 : (_bufferEnd - _buffer + hashTabBytes());
+            return (!_buffer ? 0 : (_bufferEnd - _buffer + hashTabBytes()))
+                 + (_fromBson ? _bson.objsize() : 0);
         }
 
+        /** True if this storage was created from BSON and has not been written to since.
+         *  In that case bson() has exactly the same fields and can be used instead of
+         *  converting the Values back.
+         */
+        bool bsonIsCurrent() const { return _fromBson && !_modified; }
+        const BSONObj& bson() const { return _bson; }
+
     private:
 
+        /// Iterates over already converted fields (including missing) without loading more
+        DocumentStorageIterator loadedIteratorAll() const {
+            return DocumentStorageIterator(_firstElement, end(), true);
+        }
+
+        /// Converts all remaining BSON fields. No-op unless created from BSON.
+        void loadAllFields() const {
+            while (MONGO_unlikely(_bsonNext != NULL))
+                loadNextField();
+        }
+
+        /// Converts the next BSON field and returns its Position
+        Position loadNextField() const;
+
+        /// findField without converting any more BSON fields
+        Position findLoadedField(StringData name) const;
+
+        /// appendField without the bookkeeping needed for BSON-backed storage
+        Value& appendFieldImpl(StringData name);
+
         /// Same as lastElement->next() or firstElement() if empty.
         const ValueElement* end() const { return _firstElement->plusBytes(_usedBytes); }
 
@@ -260,7 +311,7 @@ namespace mongo {
         /// Adds all fields to the hash table
         void rehash() {
             hashTabInit();
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance())
+            for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance())
                 addFieldToHashTable(it.position());
         }
 
@@ -293,6 +344,13 @@ namespace mongo {
         unsigned _usedBytes; // position where next field would start
         unsigned _numFields; // this includes removed fields
         unsigned _hashTabMask; // equal to hashTabBuckets()-1 but used more often
+
+        // Only used when created from BSON. Fields of _bson before _bsonNext have been appended
+        // to _buffer; _bsonNext is NULL once all of them have been.
+        bool _fromBson;
+        bool _modified; // set by any non-const access, after which _bson is stale
+        mutable const char* _bsonNext;
+        BSONObj _bson;
         // When adding a field, make sure to update clone() method
     };
 }
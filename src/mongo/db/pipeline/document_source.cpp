@@ -51,11 +51,25 @@ namespace mongo {
     void DocumentSource::optimize() {
     }
 
+    void DocumentSource::compileExpressions() {
+    }
+
     bool DocumentSource::advance() {
         pExpCtx->checkForInterrupt(); // might not return
         return false;
     }
 
+    const size_t DocumentSource::DefaultBatchSize;
+
+    bool DocumentSource::getNextBatch(vector<Document>* pBatch, size_t maxDocs) {
+        dassert(maxDocs > 0);
+        pBatch->clear();
+        for (bool hasDoc = !eof(); hasDoc && pBatch->size() < maxDocs; hasDoc = advance())
+            pBatch->push_back(getCurrent());
+
+        return !pBatch->empty();
+    }
+
     void DocumentSource::dispose() {
         if ( pSource ) {
             // This is required for the DocumentSourceCursor to release its read lock, see
@@ -100,6 +100,26 @@ namespace mongo {
          */
         virtual Document getCurrent() = 0;
 
+        /** The number of Documents stages hand to each other per getNextBatch() call. */
+        static const size_t DefaultBatchSize = 256;
+
+        /**
+         * Fetch the next batch of Documents and advance past them.
+         *
+         * The batch starts with what getCurrent() would have returned and holds at most maxDocs
+         * Documents.  Afterwards the source is positioned exactly as if advance() had been called
+         * once per returned Document, so batch and single Document iteration may be mixed.
+         *
+         * The default implementation is built on eof(), getCurrent() and advance().  Stages that
+         * process many Documents override it to avoid a virtual call, and an interrupt check,
+         * per Document.
+         *
+         * @param pBatch cleared, then filled with the batch
+         * @param maxDocs the maximum number of Documents to return; must be positive
+         * @returns false if there were no more Documents, in which case pBatch is empty
+         */
+        virtual bool getNextBatch(vector<Document>* pBatch, size_t maxDocs);
+
         /**
          * Inform the source that it is no longer needed and may release its resources.  After
          * dispose() is called the source must still be able to handle iteration requests, but may
@@ -160,6 +180,15 @@ namespace mongo {
          */
         virtual void optimize();
 
+        /**
+          Replace this operation's expressions with compiled programs (see
+          ExpressionCompiled).  Called after optimize() for pipelines that
+          asked for compiled expression evaluation.
+
+          The default implementation is to do nothing.
+         */
+        virtual void compileExpressions();
+
         enum GetDepsReturn {
             NOT_SUPPORTED, // This means the set should be ignored
             EXHAUSTIVE, // This means that everything needed should be in the set
@@ -389,6 +418,7 @@ namespace mongo {
         virtual bool eof();
         virtual bool advance();
         virtual Document getCurrent();
+        virtual bool getNextBatch(vector<Document>* pBatch, size_t maxDocs);
         virtual void setSource(DocumentSource *pSource);
 
         /**
@@ -495,6 +525,7 @@ namespace mongo {
         virtual bool eof();
         virtual bool advance();
         virtual Document getCurrent();
+        virtual bool getNextBatch(vector<Document>* pBatch, size_t maxDocs);
 
         /**
           Create a BSONObj suitable for Matcher construction.
@@ -540,8 +571,10 @@ namespace mongo {
         virtual bool advance();
         virtual const char *getSourceName() const;
         virtual Document getCurrent();
+        virtual bool getNextBatch(vector<Document>* pBatch, size_t maxDocs);
         virtual GetDepsReturn getDependencies(set<string>& deps) const;
         virtual void dispose();
+        virtual void compileExpressions();
 
         /**
           Create a new grouping DocumentSource.
@@ -739,7 +772,9 @@ namespace mongo {
         virtual bool advance();
         virtual const char *getSourceName() const;
         virtual Document getCurrent();
+        virtual bool getNextBatch(vector<Document>* pBatch, size_t maxDocs);
         virtual void optimize();
+        virtual void compileExpressions();
 
         virtual GetDepsReturn getDependencies(set<string>& deps) const;
 
@@ -769,6 +804,9 @@ namespace mongo {
     private:
         DocumentSourceProject(const intrusive_ptr<ExpressionContext> &pExpCtx);
 
+        /** Apply the projection to one input Document. */
+        Document project(const Document& input) const;
+
         // configuration state
         intrusive_ptr<ExpressionObject> pEO;
         BSONObj _raw;
@@ -918,6 +956,7 @@ namespace mongo {
         virtual bool eof();
         virtual bool advance();
         virtual Document getCurrent();
+        virtual bool getNextBatch(vector<Document>* pBatch, size_t maxDocs);
         virtual const char *getSourceName() const;
         virtual bool coalesce(const intrusive_ptr<DocumentSource> &pNextSource);
 
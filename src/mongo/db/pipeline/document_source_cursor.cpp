@@ -67,6 +67,22 @@ namespace mongo {
         return pCurrent;
     }
 
+    bool DocumentSourceCursor::getNextBatch(vector<Document>* pBatch, size_t maxDocs) {
+        DocumentSource::advance(); // check for interrupts, once per batch
+
+        /* if we haven't gotten the first one yet, do so now */
+        if (unstarted)
+            findNext();
+
+        pBatch->clear();
+        while (hasCurrent && pBatch->size() < maxDocs) {
+            pBatch->push_back(pCurrent);
+            findNext();
+        }
+
+        return !pBatch->empty();
+    }
+
     void DocumentSourceCursor::dispose() {
         _cursorWithContext.reset();
     }
@@ -113,7 +129,9 @@ namespace mongo {
                     continue;
 
                 if (!_projection) {
-                    pCurrent = Document(next);
+                    // The rest of the pipeline didn't give us an exhaustive set of dependencies,
+                    // so convert fields as they are used rather than all of them up front.
+                    pCurrent = Document::fromBsonLazy(next);
                 }
                 else {
                     pCurrent = documentFromBsonWithDeps(next, _dependencies);
@@ -74,6 +74,35 @@ namespace mongo {
         return pCurrent;
     }
 
+    bool DocumentSourceFilterBase::getNextBatch(vector<Document>* pBatch, size_t maxDocs) {
+        DocumentSource::advance(); // check for interrupts, once per batch
+
+        if (unstarted)
+            findNext();
+
+        pBatch->clear();
+        if (!hasCurrent)
+            return false;
+
+        /* the current document has already been accepted */
+        pBatch->push_back(pCurrent);
+
+        /* filter whole batches from the source until this one is full */
+        vector<Document> input;
+        while (pBatch->size() < maxDocs &&
+               pSource->getNextBatch(&input, maxDocs - pBatch->size())) {
+            const size_t n = input.size();
+            for (size_t i = 0; i < n; ++i) {
+                if (accept(input[i]))
+                    pBatch->push_back(input[i]);
+            }
+        }
+
+        /* position on the first match after the batch, as advance() would */
+        findNext();
+        return true;
+    }
+
     DocumentSourceFilterBase::DocumentSourceFilterBase(
         const intrusive_ptr<ExpressionContext> &pExpCtx):
         DocumentSource(pExpCtx),
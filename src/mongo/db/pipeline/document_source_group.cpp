@@ -67,6 +67,24 @@ namespace mongo {
         return makeDocument(groupsIterator);
     }
 
+    bool DocumentSourceGroup::getNextBatch(vector<Document>* pBatch, size_t maxDocs) {
+        DocumentSource::advance(); // check for interrupts, once per batch
+
+        if (!populated)
+            populate();
+
+        pBatch->clear();
+        while (groupsIterator != groups.end() && pBatch->size() < maxDocs) {
+            pBatch->push_back(makeDocument(groupsIterator));
+            ++groupsIterator;
+        }
+
+        if (groupsIterator == groups.end())
+            dispose();
+
+        return !pBatch->empty();
+    }
+
     void DocumentSourceGroup::dispose() {
         GroupsType().swap(groups);
         groupsIterator = groups.end();
@@ -107,6 +125,18 @@ namespace mongo {
         return EXHAUSTIVE;
     }
 
+    void DocumentSourceGroup::compileExpressions() {
+        /*
+          $group doesn't optimize its expressions otherwise, so fold
+          constants here before compiling.
+         */
+        pIdExpression = ExpressionCompiled::compileTree(pIdExpression->optimize());
+
+        const size_t n = vpExpression.size();
+        for(size_t i = 0; i < n; ++i)
+            vpExpression[i] = ExpressionCompiled::compileTree(vpExpression[i]->optimize());
+    }
+
     intrusive_ptr<DocumentSourceGroup> DocumentSourceGroup::create(
         const intrusive_ptr<ExpressionContext> &pExpCtx) {
         intrusive_ptr<DocumentSourceGroup> pSource(
@@ -291,39 +321,43 @@ namespace mongo {
         const size_t numAccumulators = vpAccumulatorFactory.size();
         dassert(numAccumulators == vpExpression.size());
 
-        for (bool hasNext = !pSource->eof(); hasNext; hasNext = pSource->advance()) {
-            Document input  = pSource->getCurrent();
+        vector<Document> batch;
+        while (pSource->getNextBatch(&batch, DefaultBatchSize)) {
+            const size_t nDocs = batch.size();
+            for (size_t iDoc = 0; iDoc < nDocs; ++iDoc) {
+                const Document& input = batch[iDoc];
 
-            /* get the _id value */
-            Value id = pIdExpression->evaluate(input);
+                /* get the _id value */
+                Value id = pIdExpression->evaluate(input);
 
-            /* treat missing values the same as NULL SERVER-4674 */
-            if (id.missing())
-                id = Value(BSONNULL);
+                /* treat missing values the same as NULL SERVER-4674 */
+                if (id.missing())
+                    id = Value(BSONNULL);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-
-            if (numAccumulators == 0)
-                continue; // we are basically building a set
-
-            if (group.empty()) {
-                /* add the accumulators */
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    intrusive_ptr<Accumulator> accum = (*vpAccumulatorFactory[i])(pExpCtx);
-                    accum->addOperand(vpExpression[i]);
-                    group.push_back(accum);
+                /*
+                  Look for the _id value in the map; if it's not there, add a
+                  new entry with a blank accumulator.
+                */
+                vector<intrusive_ptr<Accumulator> >& group = groups[id];
+
+                if (numAccumulators == 0)
+                    continue; // we are basically building a set
+
+                if (group.empty()) {
+                    /* add the accumulators */
+                    group.reserve(numAccumulators);
+                    for (size_t i = 0; i < numAccumulators; i++) {
+                        intrusive_ptr<Accumulator> accum = (*vpAccumulatorFactory[i])(pExpCtx);
+                        accum->addOperand(vpExpression[i]);
+                        group.push_back(accum);
+                    }
                 }
-            }
 
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
-            for (size_t i = 0; i < numAccumulators; i++)
-                group[i]->evaluate(input);
+                /* tickle all the accumulators for the group we found */
+                dassert(numAccumulators == group.size());
+                for (size_t i = 0; i < numAccumulators; i++)
+                    group[i]->evaluate(input);
+            }
         }
 
         /* start the group iterator */
@@ -79,6 +79,29 @@ namespace mongo {
         return pSource->getCurrent();
     }
 
+    bool DocumentSourceLimit::getNextBatch(vector<Document>* pBatch, size_t maxDocs) {
+        DocumentSource::advance(); // check for interrupts, once per batch
+
+        if (count >= limit) {
+            pBatch->clear();
+            return false;
+        }
+
+        const long long remaining = limit - count;
+        if (static_cast<long long>(maxDocs) > remaining)
+            maxDocs = static_cast<size_t>(remaining);
+
+        if (!pSource->getNextBatch(pBatch, maxDocs))
+            return false;
+
+        count += pBatch->size();
+        if (count >= limit) {
+            // As in advance(), release the cursor's read lock as soon as possible.
+            pSource->dispose();
+        }
+        return true;
+    }
+
     void DocumentSourceLimit::sourceToBson(
         BSONObjBuilder *pBuilder, bool explain) const {
         pBuilder->append("$limit", limit);
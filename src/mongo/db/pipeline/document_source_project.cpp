@@ -49,7 +49,23 @@ namespace mongo {
     }
 
     Document DocumentSourceProject::getCurrent() {
-        Document pInDocument(pSource->getCurrent());
+        return project(pSource->getCurrent());
+    }
+
+    bool DocumentSourceProject::getNextBatch(vector<Document>* pBatch, size_t maxDocs) {
+        DocumentSource::advance(); // check for interrupts, once per batch
+
+        if (!pSource->getNextBatch(pBatch, maxDocs))
+            return false;
+
+        const size_t n = pBatch->size();
+        for (size_t i = 0; i < n; ++i)
+            (*pBatch)[i] = project((*pBatch)[i]);
+
+        return true;
+    }
+
+    Document DocumentSourceProject::project(const Document& pInDocument) const {
 
         /* create the result document */
         const size_t sizeHint = pEO->getSizeHint();
@@ -68,7 +84,7 @@ namespace mongo {
             // Make sure we return the same results as Projection class
 
             BSONObjBuilder inputBuilder;
-            pSource->getCurrent()->toBson(&inputBuilder);
+            pInDocument->toBson(&inputBuilder);
             BSONObj input = inputBuilder.done();
 
             BSONObjBuilder outputBuilder;
@@ -95,6 +111,10 @@ namespace mongo {
         pEO = dynamic_pointer_cast<ExpressionObject>(pE);
     }
 
+    void DocumentSourceProject::compileExpressions() {
+        pEO->compileFields();
+    }
+
     void DocumentSourceProject::sourceToBson(
         BSONObjBuilder *pBuilder, bool explain) const {
         BSONObjBuilder insides;
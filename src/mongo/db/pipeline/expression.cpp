@@ -22,6 +22,7 @@
 #include "db/pipeline/builder.h"
 #include "db/pipeline/document.h"
 #include "db/pipeline/expression_context.h"
+#include "db/pipeline/expression_program.h"
 #include "db/pipeline/value.h"
 #include "util/mongoutils/str.h"
 
@@ -34,6 +35,91 @@ namespace mongo {
         verify(false && "Expression::toMatcherBson()");
     }
 
+    bool Expression::compile(ExpressionProgram *pProgram) const {
+        pProgram->emitEvaluate(this);
+        return false;
+    }
+
+    /*
+      Compile an operator that combines all of its evaluated operands with
+      a single instruction.  The interpreted operators stop at the first
+      nullish operand, so the remaining operands may only be evaluated
+      eagerly if that can't throw; otherwise keep the interpreted form.
+     */
+    static bool compileEagerNary(const Expression *pExpression,
+                                 const vector<intrusive_ptr<Expression> > &operands,
+                                 ExpressionProgram::OpCode op,
+                                 ExpressionProgram *pProgram) {
+        const size_t start = pProgram->here();
+        const size_t n = operands.size();
+        for (size_t i = 0; i < n; ++i) {
+            const bool nothrow = pProgram->compileOperand(operands[i]);
+            if (i > 0 && !nothrow) {
+                pProgram->rewind(start);
+                pProgram->emitEvaluate(pExpression);
+                return false;
+            }
+        }
+
+        pProgram->emit(op, n);
+        return false; // the operator itself rejects unsupported types
+    }
+
+    /*
+      Compile an operator that always evaluates exactly two operands and
+      then combines them with a single instruction.  Anything else is left
+      to the interpreted form, which reports the argument count error.
+     */
+    static bool compileBinary(const Expression *pExpression,
+                              const vector<intrusive_ptr<Expression> > &operands,
+                              ExpressionProgram::OpCode op, unsigned arg,
+                              ExpressionProgram *pProgram) {
+        if (operands.size() != 2)
+            return pExpression->Expression::compile(pProgram);
+
+        bool nothrow = pProgram->compileOperand(operands[0]);
+        nothrow = pProgram->compileOperand(operands[1]) && nothrow;
+        pProgram->emit(op, arg);
+        return nothrow;
+    }
+
+    /*
+      Operand sources for the n-ary operators below.  LazyOperands
+      evaluates each operand only when it is reached, so an early result
+      skips evaluation of the rest; EvaluatedOperands reads values a
+      compiled program has already computed.
+     */
+    class LazyOperands {
+    public:
+        LazyOperands(const vector<intrusive_ptr<Expression> > &operands,
+                     const Document &input):
+            _operands(operands),
+            _input(input) {
+        }
+
+        size_t size() const { return _operands.size(); }
+        Value operator[](size_t i) const { return _operands[i]->evaluate(_input); }
+
+    private:
+        const vector<intrusive_ptr<Expression> > &_operands;
+        const Document &_input;
+    };
+
+    class EvaluatedOperands {
+    public:
+        EvaluatedOperands(const Value *pValues, size_t nValues):
+            _pValues(pValues),
+            _nValues(nValues) {
+        }
+
+        size_t size() const { return _nValues; }
+        const Value &operator[](size_t i) const { return _pValues[i]; }
+
+    private:
+        const Value *_pValues;
+        size_t _nValues;
+    };
+
     Expression::ObjectCtx::ObjectCtx(int theOptions)
         : options(theOptions)
     {}
@@ -328,7 +414,8 @@ namespace mongo {
         return pExpression;
     }
 
-    Value ExpressionAdd::evaluate(const Document& pDocument) const {
+    template <class Operands>
+    static Value addOperands(const Operands &operands) {
 
         /*
           We'll try to return the narrowest possible result value.  To do that
@@ -341,9 +428,9 @@ namespace mongo {
         BSONType totalType = NumberInt;
         bool haveDate = false;
 
-        const size_t n = vpOperand.size();
+        const size_t n = operands.size();
         for (size_t i = 0; i < n; ++i) {
-            Value val = vpOperand[i]->evaluate(pDocument);
+            Value val = operands[i];
 
             if (val.numeric()) {
                 totalType = Value::getWidestNumeric(totalType, val.getType());
@@ -389,6 +476,18 @@ namespace mongo {
         }
     }
 
+    Value ExpressionAdd::evaluate(const Document& pDocument) const {
+        return addOperands(LazyOperands(vpOperand, pDocument));
+    }
+
+    Value ExpressionAdd::apply(const Value* pOperands, size_t nOperands) {
+        return addOperands(EvaluatedOperands(pOperands, nOperands));
+    }
+
+    bool ExpressionAdd::compile(ExpressionProgram *pProgram) const {
+        return compileEagerNary(this, vpOperand, ExpressionProgram::ADD, pProgram);
+    }
+
     const char *ExpressionAdd::getOpName() const {
         return "$add";
     }
@@ -479,6 +578,24 @@ namespace mongo {
         return Value(true);
     }
 
+    bool ExpressionAnd::compile(ExpressionProgram *pProgram) const {
+        bool nothrow = true;
+        vector<size_t> falseJumps;
+        const size_t n = vpOperand.size();
+        for(size_t i = 0; i < n; ++i) {
+            nothrow = pProgram->compileOperand(vpOperand[i]) && nothrow;
+            falseJumps.push_back(pProgram->emit(ExpressionProgram::JUMP_IF_FALSE));
+        }
+
+        pProgram->emitConstant(Value(true));
+        const size_t endJump = pProgram->emit(ExpressionProgram::JUMP);
+        for(size_t i = 0; i < falseJumps.size(); ++i)
+            pProgram->setJumpTarget(falseJumps[i]);
+        pProgram->emitConstant(Value(false));
+        pProgram->setJumpTarget(endJump);
+        return nothrow;
+    }
+
     const char *ExpressionAnd::getOpName() const {
         return "$and";
     }
@@ -545,6 +662,12 @@ namespace mongo {
         return Value(false);
     }
 
+    bool ExpressionCoerceToBool::compile(ExpressionProgram *pProgram) const {
+        const bool nothrow = pProgram->compileOperand(pExpression);
+        pProgram->emit(ExpressionProgram::TO_BOOL);
+        return nothrow;
+    }
+
     void ExpressionCoerceToBool::addToBsonObj(BSONObjBuilder *pBuilder,
                                               StringData fieldName,
                                               bool requireExpression) const {
@@ -703,7 +826,10 @@ namespace mongo {
         checkArgCount(2);
         Value pLeft(vpOperand[0]->evaluate(pDocument));
         Value pRight(vpOperand[1]->evaluate(pDocument));
+        return apply(cmpOp, pLeft, pRight);
+    }
 
+    Value ExpressionCompare::apply(CmpOp cmpOp, const Value& pLeft, const Value& pRight) {
         int cmp = signum(Value::compare(pLeft, pRight));
 
         if (cmpOp == CMP) {
@@ -722,10 +848,67 @@ namespace mongo {
         return Value(returnValue);
     }
 
+    bool ExpressionCompare::compile(ExpressionProgram *pProgram) const {
+        return compileBinary(this, vpOperand, ExpressionProgram::COMPARE, cmpOp, pProgram);
+    }
+
     const char *ExpressionCompare::getOpName() const {
         return cmpLookup[cmpOp].name;
     }
 
+    /* ----------------------- ExpressionCompiled -------------------------- */
+
+    ExpressionCompiled::~ExpressionCompiled() {
+    }
+
+    ExpressionCompiled::ExpressionCompiled(const intrusive_ptr<Expression> &pExpression):
+        _pExpression(pExpression),
+        _pProgram(new ExpressionProgram(pExpression)) {
+    }
+
+    intrusive_ptr<Expression> ExpressionCompiled::compileTree(
+        const intrusive_ptr<Expression> &pExpression) {
+        Expression *pE = pExpression.get();
+        if (ExpressionObject *pObject = dynamic_cast<ExpressionObject *>(pE)) {
+            pObject->compileFields();
+            return pExpression;
+        }
+
+        if (dynamic_cast<ExpressionFieldPath *>(pE) ||
+            dynamic_cast<ExpressionConstant *>(pE) ||
+            dynamic_cast<ExpressionCompiled *>(pE))
+            return pExpression;
+
+        return new ExpressionCompiled(pExpression);
+    }
+
+    intrusive_ptr<Expression> ExpressionCompiled::optimize() {
+        /* the wrapped tree was optimized before it was compiled */
+        return intrusive_ptr<Expression>(this);
+    }
+
+    void ExpressionCompiled::addDependencies(set<string>& deps, vector<string>* path) const {
+        _pExpression->addDependencies(deps, path);
+    }
+
+    Value ExpressionCompiled::evaluate(const Document& pDocument) const {
+        return _pProgram->evaluate(pDocument);
+    }
+
+    bool ExpressionCompiled::compile(ExpressionProgram *pProgram) const {
+        return _pExpression->compile(pProgram);
+    }
+
+    void ExpressionCompiled::addToBsonObj(BSONObjBuilder *pBuilder,
+                                          StringData fieldName,
+                                          bool requireExpression) const {
+        _pExpression->addToBsonObj(pBuilder, fieldName, requireExpression);
+    }
+
+    void ExpressionCompiled::addToBsonArray(BSONArrayBuilder *pBuilder) const {
+        _pExpression->addToBsonArray(pBuilder);
+    }
+
     /* ------------------------- ExpressionConcat ----------------------------- */
 
     ExpressionConcat::~ExpressionConcat() {
@@ -735,12 +918,13 @@ namespace mongo {
         return new ExpressionConcat();
     }
 
-    Value ExpressionConcat::evaluate(const Document& input) const {
-        const size_t n = vpOperand.size();
+    template <class Operands>
+    static Value concatOperands(const Operands &operands) {
+        const size_t n = operands.size();
 
         StringBuilder result;
         for (size_t i = 0; i < n; ++i) {
-            Value val = vpOperand[i]->evaluate(input);
+            Value val = operands[i];
             if (val.nullish())
                 return Value(BSONNULL);
 
@@ -754,6 +938,18 @@ namespace mongo {
         return Value::createString(result.str());
     }
 
+    Value ExpressionConcat::evaluate(const Document& input) const {
+        return concatOperands(LazyOperands(vpOperand, input));
+    }
+
+    Value ExpressionConcat::apply(const Value* pOperands, size_t nOperands) {
+        return concatOperands(EvaluatedOperands(pOperands, nOperands));
+    }
+
+    bool ExpressionConcat::compile(ExpressionProgram *pProgram) const {
+        return compileEagerNary(this, vpOperand, ExpressionProgram::CONCAT, pProgram);
+    }
+
     const char *ExpressionConcat::getOpName() const {
         return "$concat";
     }
@@ -785,6 +981,20 @@ namespace mongo {
         return vpOperand[idx]->evaluate(pDocument);
     }
 
+    bool ExpressionCond::compile(ExpressionProgram *pProgram) const {
+        if (vpOperand.size() != 3)
+            return Expression::compile(pProgram);
+
+        bool nothrow = pProgram->compileOperand(vpOperand[0]);
+        const size_t elseJump = pProgram->emit(ExpressionProgram::JUMP_IF_FALSE);
+        nothrow = pProgram->compileOperand(vpOperand[1]) && nothrow;
+        const size_t endJump = pProgram->emit(ExpressionProgram::JUMP);
+        pProgram->setJumpTarget(elseJump);
+        nothrow = pProgram->compileOperand(vpOperand[2]) && nothrow;
+        pProgram->setJumpTarget(endJump);
+        return nothrow;
+    }
+
     const char *ExpressionCond::getOpName() const {
         return "$cond";
     }
@@ -826,6 +1036,11 @@ namespace mongo {
         return pValue;
     }
 
+    bool ExpressionConstant::compile(ExpressionProgram *pProgram) const {
+        pProgram->emitConstant(pValue);
+        return true;
+    }
+
     void ExpressionConstant::addToBsonObj(BSONObjBuilder *pBuilder,
                                           StringData fieldName,
                                           bool requireExpression) const {
@@ -988,7 +1203,15 @@ namespace mongo {
         checkArgCount(2);
         Value lhs = vpOperand[0]->evaluate(pDocument);
         Value rhs = vpOperand[1]->evaluate(pDocument);
+        return apply(lhs, rhs);
+    }
 
+    bool ExpressionDivide::compile(ExpressionProgram *pProgram) const {
+        compileBinary(this, vpOperand, ExpressionProgram::DIVIDE, 0, pProgram);
+        return false; // division by zero
+    }
+
+    Value ExpressionDivide::apply(const Value& lhs, const Value& rhs) {
         if (lhs.numeric() && rhs.numeric()) {
             double numer = lhs.coerceToDouble();
             double denom = rhs.coerceToDouble();
@@ -1034,6 +1257,13 @@ namespace mongo {
         return intrusive_ptr<Expression>(this);
     }
 
+    void ExpressionObject::compileFields() {
+        for (ExpressionMap::iterator it(_expressions.begin()); it!=_expressions.end(); ++it) {
+            if (it->second)
+                it->second = ExpressionCompiled::compileTree(it->second);
+        }
+    }
+
     bool ExpressionObject::isSimple() {
         for (ExpressionMap::iterator it(_expressions.begin()); it!=_expressions.end(); ++it) {
             if (it->second && !it->second->isSimple())
@@ -1393,6 +1623,11 @@ namespace mongo {
         return evaluatePath(0, pDocument);
     }
 
+    bool ExpressionFieldPath::compile(ExpressionProgram *pProgram) const {
+        pProgram->emitFieldPath(this);
+        return true;
+    }
+
     void ExpressionFieldPath::addToBsonObj(BSONObjBuilder *pBuilder,
                                            StringData fieldName,
                                            bool requireExpression) const {
@@ -1442,11 +1677,27 @@ namespace mongo {
         /* get the value of the specified field */
         Value pValue(pFieldPath->evaluate(pDocument));
 
+        return Value(contains(pValue));
+    }
+
+    bool ExpressionFieldRange::contains(const Value& pValue) const {
+        /* if there's no range, there can't be a match */
+        if (!pRange.get())
+            return false;
+
         /* see if it fits within any of the ranges */
-        if (pRange->contains(pValue))
-            return Value(true);
+        return pRange->contains(pValue);
+    }
 
-        return Value(false);
+    bool ExpressionFieldRange::compile(ExpressionProgram *pProgram) const {
+        if (!pRange.get()) {
+            pProgram->emitConstant(Value(false));
+            return true;
+        }
+
+        pProgram->emitFieldPath(pFieldPath.get());
+        pProgram->emitFieldRange(this);
+        return true;
     }
 
     void ExpressionFieldRange::addToBson(Builder *pBuilder) const {
@@ -1803,7 +2054,15 @@ namespace mongo {
         checkArgCount(2);
         Value lhs = vpOperand[0]->evaluate(pDocument);
         Value rhs = vpOperand[1]->evaluate(pDocument);
+        return apply(lhs, rhs);
+    }
+
+    bool ExpressionMod::compile(ExpressionProgram *pProgram) const {
+        compileBinary(this, vpOperand, ExpressionProgram::MOD, 0, pProgram);
+        return false; // modulo by zero
+    }
 
+    Value ExpressionMod::apply(const Value& lhs, const Value& rhs) {
         BSONType leftType = lhs.getType();
         BSONType rightType = rhs.getType();
 
@@ -1894,7 +2153,8 @@ namespace mongo {
         ExpressionNary() {
     }
 
-    Value ExpressionMultiply::evaluate(const Document& pDocument) const {
+    template <class Operands>
+    static Value multiplyOperands(const Operands &operands) {
         /*
           We'll try to return the narrowest possible result value.  To do that
           without creating intermediate Values, do the arithmetic for double
@@ -1905,9 +2165,9 @@ namespace mongo {
         long long longProduct = 1;
         BSONType productType = NumberInt;
 
-        const size_t n = vpOperand.size();
+        const size_t n = operands.size();
         for(size_t i = 0; i < n; ++i) {
-            Value val = vpOperand[i]->evaluate(pDocument);
+            Value val = operands[i];
 
             if (val.numeric()) {
                 productType = Value::getWidestNumeric(productType, val.getType());
@@ -1934,6 +2194,18 @@ namespace mongo {
             massert(16418, "$multiply resulted in a non-numeric type", false);
     }
 
+    Value ExpressionMultiply::evaluate(const Document& pDocument) const {
+        return multiplyOperands(LazyOperands(vpOperand, pDocument));
+    }
+
+    Value ExpressionMultiply::apply(const Value* pOperands, size_t nOperands) {
+        return multiplyOperands(EvaluatedOperands(pOperands, nOperands));
+    }
+
+    bool ExpressionMultiply::compile(ExpressionProgram *pProgram) const {
+        return compileEagerNary(this, vpOperand, ExpressionProgram::MULTIPLY, pProgram);
+    }
+
     const char *ExpressionMultiply::getOpName() const {
     return "$multiply";
     }
@@ -2003,6 +2275,17 @@ namespace mongo {
         return pRight;
     }
 
+    bool ExpressionIfNull::compile(ExpressionProgram *pProgram) const {
+        if (vpOperand.size() != 2)
+            return Expression::compile(pProgram);
+
+        bool nothrow = pProgram->compileOperand(vpOperand[0]);
+        const size_t endJump = pProgram->emit(ExpressionProgram::JUMP_IF_NOT_NULLISH);
+        nothrow = pProgram->compileOperand(vpOperand[1]) && nothrow;
+        pProgram->setJumpTarget(endJump);
+        return nothrow;
+    }
+
     const char *ExpressionIfNull::getOpName() const {
         return "$ifNull";
     }
@@ -2225,6 +2508,15 @@ namespace mongo {
         return Value(!b);
     }
 
+    bool ExpressionNot::compile(ExpressionProgram *pProgram) const {
+        if (vpOperand.size() != 1)
+            return Expression::compile(pProgram);
+
+        const bool nothrow = pProgram->compileOperand(vpOperand[0]);
+        pProgram->emit(ExpressionProgram::NOT);
+        return nothrow;
+    }
+
     const char *ExpressionNot::getOpName() const {
         return "$not";
     }
@@ -2254,6 +2546,24 @@ namespace mongo {
         return Value(false);
     }
 
+    bool ExpressionOr::compile(ExpressionProgram *pProgram) const {
+        bool nothrow = true;
+        vector<size_t> trueJumps;
+        const size_t n = vpOperand.size();
+        for(size_t i = 0; i < n; ++i) {
+            nothrow = pProgram->compileOperand(vpOperand[i]) && nothrow;
+            trueJumps.push_back(pProgram->emit(ExpressionProgram::JUMP_IF_TRUE));
+        }
+
+        pProgram->emitConstant(Value(false));
+        const size_t endJump = pProgram->emit(ExpressionProgram::JUMP);
+        for(size_t i = 0; i < trueJumps.size(); ++i)
+            pProgram->setJumpTarget(trueJumps[i]);
+        pProgram->emitConstant(Value(true));
+        pProgram->setJumpTarget(endJump);
+        return nothrow;
+    }
+
     void ExpressionOr::toMatcherBson(
         BSONObjBuilder *pBuilder) const {
         BSONObjBuilder opArray;
@@ -2474,7 +2784,15 @@ namespace mongo {
         checkArgCount(2);
         Value lhs = vpOperand[0]->evaluate(pDocument);
         Value rhs = vpOperand[1]->evaluate(pDocument);
-            
+        return apply(lhs, rhs);
+    }
+
+    bool ExpressionSubtract::compile(ExpressionProgram *pProgram) const {
+        compileBinary(this, vpOperand, ExpressionProgram::SUBTRACT, 0, pProgram);
+        return false; // unsupported types
+    }
+
+    Value ExpressionSubtract::apply(const Value& lhs, const Value& rhs) {            
         BSONType diffType = Value::getWidestNumeric(rhs.getType(), lhs.getType());
 
         if (diffType == NumberDouble) {
@@ -33,6 +33,7 @@ namespace mongo {
     class MutableDocument;
     class DocumentSource;
     class ExpressionContext;
+    class ExpressionProgram;
     class Value;
 
 
@@ -80,6 +81,21 @@ namespace mongo {
         */
         virtual Value evaluate(const Document& pDocument) const = 0;
 
+        /*
+          Append instructions that evaluate this Expression to a program.
+          The emitted code must leave exactly one value, the result of
+          evaluate(), on the program's stack.
+
+          The default implementation emits a call back to evaluate(), so
+          every Expression can take part in a compiled program; frequently
+          used operators override this with native instructions.
+
+          @param pProgram the program under construction
+          @returns true if the emitted code can never throw; callers use
+            this to decide whether operands may be evaluated eagerly
+         */
+        virtual bool compile(ExpressionProgram *pProgram) const;
+
         /*
           Add the Expression (and any descendant Expressions) into a BSON
           object that is under construction.
@@ -315,6 +331,7 @@ namespace mongo {
         // virtuals from Expression
         virtual ~ExpressionAdd();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
 
         // virtuals from ExpressionNary
@@ -326,6 +343,12 @@ namespace mongo {
           @returns addition expression
          */
         static intrusive_ptr<ExpressionNary> create();
+
+        /*
+          Combine already evaluated operands the way evaluate() does.  Used
+          by compiled programs, which evaluate operands themselves.
+         */
+        static Value apply(const Value* pOperands, size_t nOperands);
     };
 
 
@@ -336,6 +359,7 @@ namespace mongo {
         virtual ~ExpressionAnd();
         virtual intrusive_ptr<Expression> optimize();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void toMatcherBson(BSONObjBuilder *pBuilder) const;
 
@@ -366,6 +390,7 @@ namespace mongo {
         virtual intrusive_ptr<Expression> optimize();
         virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual void addToBsonObj(BSONObjBuilder *pBuilder,
                                   StringData fieldName,
                                   bool requireExpression) const;
@@ -388,6 +413,7 @@ namespace mongo {
         virtual ~ExpressionCompare();
         virtual intrusive_ptr<Expression> optimize();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
@@ -407,6 +433,12 @@ namespace mongo {
         static intrusive_ptr<ExpressionNary> createLt();
         static intrusive_ptr<ExpressionNary> createLte();
 
+        /*
+          Compare already evaluated operands the way evaluate() does.  Used
+          by compiled programs, which evaluate operands themselves.
+         */
+        static Value apply(CmpOp cmpOp, const Value& lhs, const Value& rhs);
+
     private:
         friend class ExpressionFieldRange;
         ExpressionCompare(CmpOp cmpOp);
@@ -415,14 +447,67 @@ namespace mongo {
     };
 
 
+    /*
+      Wraps an Expression tree together with its compiled ExpressionProgram.
+
+      evaluate() runs the program; everything else is delegated to the
+      original tree, so dependency analysis, explain output and the
+      specification sent to shards are unchanged by compilation.
+     */
+    class ExpressionCompiled :
+        public Expression {
+    public:
+        // virtuals from Expression
+        virtual ~ExpressionCompiled();
+        virtual intrusive_ptr<Expression> optimize();
+        virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
+        virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
+        virtual void addToBsonObj(BSONObjBuilder *pBuilder,
+                                  StringData fieldName,
+                                  bool requireExpression) const;
+        virtual void addToBsonArray(BSONArrayBuilder *pBuilder) const;
+
+        /*
+          Compile an (optimized) Expression tree.
+
+          ExpressionObjects are compiled field by field in place and
+          returned as is, since DocumentSources rely on their type.  Field
+          paths and constants are already as cheap as they can be and are
+          also returned unchanged.  Anything else is wrapped in an
+          ExpressionCompiled.
+
+          @param pExpression the expression to compile
+          @returns the expression to use in place of pExpression
+         */
+        static intrusive_ptr<Expression> compileTree(
+            const intrusive_ptr<Expression> &pExpression);
+
+        const ExpressionProgram& getProgram() const { return *_pProgram; }
+
+    private:
+        ExpressionCompiled(const intrusive_ptr<Expression> &pExpression);
+
+        intrusive_ptr<Expression> _pExpression;
+        scoped_ptr<ExpressionProgram> _pProgram;
+    };
+
+
     class ExpressionConcat : public ExpressionNary {
     public:
         // virtuals from ExpressionNary
         virtual ~ExpressionConcat();
         virtual Value evaluate(const Document& input) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
 
         static intrusive_ptr<ExpressionNary> create();
+
+        /*
+          Combine already evaluated operands the way evaluate() does.  Used
+          by compiled programs, which evaluate operands themselves.
+         */
+        static Value apply(const Value* pOperands, size_t nOperands);
     };
 
 
@@ -431,6 +516,7 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual ~ExpressionCond();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
@@ -449,6 +535,7 @@ namespace mongo {
         virtual intrusive_ptr<Expression> optimize();
         virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void addToBsonObj(BSONObjBuilder *pBuilder,
                                   StringData fieldName,
@@ -528,11 +615,18 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual ~ExpressionDivide();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
         static intrusive_ptr<ExpressionNary> create();
 
+        /*
+          Combine already evaluated operands the way evaluate() does.  Used
+          by compiled programs, which evaluate operands themselves.
+         */
+        static Value apply(const Value& lhs, const Value& rhs);
+
     private:
         ExpressionDivide();
     };
@@ -546,6 +640,7 @@ namespace mongo {
         virtual intrusive_ptr<Expression> optimize();
         virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual void addToBsonObj(BSONObjBuilder *pBuilder,
                                   StringData fieldName,
                                   bool requireExpression) const;
@@ -615,6 +710,7 @@ namespace mongo {
         virtual intrusive_ptr<Expression> optimize();
         virtual void addDependencies(set<string>& deps, vector<string>* path=NULL) const;
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual void addToBsonObj(BSONObjBuilder *pBuilder,
                                   StringData fieldName,
                                   bool requireExpression) const;
@@ -660,6 +756,15 @@ namespace mongo {
          */
         void intersect(CmpOp cmpOp, const Value& pValue);
 
+        /*
+          Test an already extracted field value against the range.  Used
+          by compiled programs, which extract field values themselves.
+
+          @param pValue the value of the field
+          @returns whether the value lies within the range
+         */
+        bool contains(const Value& pValue) const;
+
     private:
         ExpressionFieldRange(const intrusive_ptr<ExpressionFieldPath> &pFieldPath,
                              CmpOp cmpOp,
@@ -721,6 +826,7 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual ~ExpressionIfNull();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
@@ -769,11 +875,18 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual ~ExpressionMod();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
         static intrusive_ptr<ExpressionNary> create();
 
+        /*
+          Combine already evaluated operands the way evaluate() does.  Used
+          by compiled programs, which evaluate operands themselves.
+         */
+        static Value apply(const Value& lhs, const Value& rhs);
+
     private:
         ExpressionMod();
     };
@@ -785,6 +898,7 @@ namespace mongo {
         // virtuals from Expression
         virtual ~ExpressionMultiply();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
 
         // virtuals from ExpressionNary
@@ -797,6 +911,12 @@ namespace mongo {
          */
         static intrusive_ptr<ExpressionNary> create();
 
+        /*
+          Combine already evaluated operands the way evaluate() does.  Used
+          by compiled programs, which evaluate operands themselves.
+         */
+        static Value apply(const Value* pOperands, size_t nOperands);
+
     private:
         ExpressionMultiply();
     };
@@ -824,6 +944,7 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual ~ExpressionNot();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
@@ -939,6 +1060,13 @@ namespace mongo {
 
         void excludeId(bool b) { _excludeId = b; }
 
+        /*
+          Replace each computed field's expression with its compiled form.
+          Nested ExpressionObjects are compiled in place, so inclusion and
+          field ordering behave exactly as before.  See ExpressionCompiled.
+         */
+        void compileFields();
+
     private:
         ExpressionObject();
 
@@ -961,6 +1089,7 @@ namespace mongo {
         virtual ~ExpressionOr();
         virtual intrusive_ptr<Expression> optimize();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void toMatcherBson(BSONObjBuilder *pBuilder) const;
 
@@ -1037,11 +1166,18 @@ namespace mongo {
         // virtuals from ExpressionNary
         virtual ~ExpressionSubtract();
         virtual Value evaluate(const Document& pDocument) const;
+        virtual bool compile(ExpressionProgram *pProgram) const;
         virtual const char *getOpName() const;
         virtual void addOperand(const intrusive_ptr<Expression> &pExpression);
 
         static intrusive_ptr<ExpressionNary> create();
 
+        /*
+          Combine already evaluated operands the way evaluate() does.  Used
+          by compiled programs, which evaluate operands themselves.
+         */
+        static Value apply(const Value& lhs, const Value& rhs);
+
     private:
         ExpressionSubtract();
     };
@@ -0,0 +1,234 @@
+/**
+ * Copyright (C) 2013 Tokutek Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pch.h"
+
+#include "db/pipeline/expression_program.h"
+
+#include "db/pipeline/document.h"
+#include "db/pipeline/expression.h"
+
+namespace mongo {
+
+    ExpressionProgram::ExpressionProgram(const intrusive_ptr<const Expression>& pRoot):
+        _pRoot(pRoot),
+        _generation(0) {
+        _pRoot->compile(this);
+
+        /* fields referenced only once gain nothing from being cached */
+        vector<unsigned> fieldUses(_fields.size(), 0);
+        for (size_t i = 0; i < _code.size(); ++i) {
+            if (_code[i].op == PUSH_FIELD)
+                ++fieldUses[_code[i].arg];
+        }
+        for (size_t i = 0; i < _code.size(); ++i) {
+            if (_code[i].op == PUSH_FIELD && fieldUses[_code[i].arg] == 1)
+                _code[i].op = PUSH_FIELD_UNCACHED;
+        }
+
+        /* every value on the stack was pushed by one of these instructions */
+        size_t maxDepth = 0;
+        for (size_t i = 0; i < _code.size(); ++i) {
+            const OpCode op = _code[i].op;
+            if (op == PUSH_CONSTANT || op == PUSH_FIELD || op == PUSH_FIELD_UNCACHED ||
+                op == EVALUATE)
+                ++maxDepth;
+        }
+        _stack.resize(maxDepth);
+        _slotValues.resize(_fields.size());
+        _slotGeneration.resize(_fields.size(), 0);
+    }
+
+    size_t ExpressionProgram::emit(OpCode op, unsigned arg) {
+        _code.push_back(Instruction(op, arg));
+        return _code.size() - 1;
+    }
+
+    void ExpressionProgram::setJumpTarget(size_t jumpAddr) {
+        dassert(jumpAddr < _code.size());
+        _code[jumpAddr].arg = _code.size();
+    }
+
+    void ExpressionProgram::rewind(size_t addr) {
+        /*
+          Constants, fallbacks and field slots emitted by the discarded code
+          are left in place; they are harmless, and field slots may already
+          be shared with code that is kept.
+         */
+        verify(addr <= _code.size());
+        _code.erase(_code.begin() + addr, _code.end());
+    }
+
+    void ExpressionProgram::emitConstant(const Value& value) {
+        _constants.push_back(value);
+        emit(PUSH_CONSTANT, _constants.size() - 1);
+    }
+
+    void ExpressionProgram::emitFieldPath(const ExpressionFieldPath* pFieldPath) {
+        const string path = pFieldPath->getFieldPath(false);
+        map<string, unsigned>::const_iterator it = _fieldSlots.find(path);
+        unsigned slot;
+        if (it != _fieldSlots.end()) {
+            slot = it->second;
+        }
+        else {
+            slot = _fields.size();
+            _fields.push_back(pFieldPath);
+            _fieldSlots[path] = slot;
+        }
+        emit(PUSH_FIELD, slot);
+    }
+
+    void ExpressionProgram::emitFieldRange(const ExpressionFieldRange* pFieldRange) {
+        _ranges.push_back(pFieldRange);
+        emit(IN_RANGE, _ranges.size() - 1);
+    }
+
+    void ExpressionProgram::emitEvaluate(const Expression* pExpression) {
+        _fallbacks.push_back(pExpression);
+        emit(EVALUATE, _fallbacks.size() - 1);
+    }
+
+    bool ExpressionProgram::compileOperand(const intrusive_ptr<Expression>& pOperand) {
+        return pOperand->compile(this);
+    }
+
+    const Value& ExpressionProgram::fieldValue(unsigned slot, const Document& input) const {
+        if (_slotGeneration[slot] != _generation) {
+            _slotValues[slot] = _fields[slot]->evaluate(input);
+            _slotGeneration[slot] = _generation;
+        }
+        return _slotValues[slot];
+    }
+
+    Value ExpressionProgram::evaluate(const Document& input) const {
+        if (++_generation == 0) {
+            /* wrapped around; make sure no slot looks loaded */
+            std::fill(_slotGeneration.begin(), _slotGeneration.end(), 0);
+            _generation = 1;
+        }
+
+        /*
+          The stack was sized when the program was built; values left over
+          from the previous document are simply overwritten.
+         */
+        Value* const pStack = &_stack[0];
+        size_t sp = 0;
+
+        const Instruction* const pCode = &_code[0];
+        const size_t nCode = _code.size();
+        size_t pc = 0;
+        while (pc < nCode) {
+            const Instruction& ins = pCode[pc++];
+            switch (ins.op) {
+            case PUSH_CONSTANT:
+                pStack[sp++] = _constants[ins.arg];
+                break;
+
+            case PUSH_FIELD:
+                pStack[sp++] = fieldValue(ins.arg, input);
+                break;
+
+            case PUSH_FIELD_UNCACHED:
+                pStack[sp++] = _fields[ins.arg]->evaluate(input);
+                break;
+
+            case EVALUATE:
+                pStack[sp++] = _fallbacks[ins.arg]->evaluate(input);
+                break;
+
+            case JUMP:
+                pc = ins.arg;
+                break;
+
+            case JUMP_IF_FALSE:
+                if (!pStack[--sp].coerceToBool())
+                    pc = ins.arg;
+                break;
+
+            case JUMP_IF_TRUE:
+                if (pStack[--sp].coerceToBool())
+                    pc = ins.arg;
+                break;
+
+            case JUMP_IF_NOT_NULLISH:
+                if (!pStack[sp - 1].nullish())
+                    pc = ins.arg;
+                else
+                    --sp;
+                break;
+
+            case TO_BOOL:
+                pStack[sp - 1] = Value(pStack[sp - 1].coerceToBool());
+                break;
+
+            case NOT:
+                pStack[sp - 1] = Value(!pStack[sp - 1].coerceToBool());
+                break;
+
+            case IN_RANGE:
+                pStack[sp - 1] = Value(_ranges[ins.arg]->contains(pStack[sp - 1]));
+                break;
+
+            case ADD:
+                sp -= ins.arg;
+                pStack[sp] = ExpressionAdd::apply(pStack + sp, ins.arg);
+                ++sp;
+                break;
+
+            case MULTIPLY:
+                sp -= ins.arg;
+                pStack[sp] = ExpressionMultiply::apply(pStack + sp, ins.arg);
+                ++sp;
+                break;
+
+            case CONCAT:
+                sp -= ins.arg;
+                pStack[sp] = ExpressionConcat::apply(pStack + sp, ins.arg);
+                ++sp;
+                break;
+
+            case COMPARE:
+                --sp;
+                pStack[sp - 1] = ExpressionCompare::apply(static_cast<Expression::CmpOp>(ins.arg),
+                                                          pStack[sp - 1], pStack[sp]);
+                break;
+
+            case SUBTRACT:
+                --sp;
+                pStack[sp - 1] = ExpressionSubtract::apply(pStack[sp - 1], pStack[sp]);
+                break;
+
+            case DIVIDE:
+                --sp;
+                pStack[sp - 1] = ExpressionDivide::apply(pStack[sp - 1], pStack[sp]);
+                break;
+
+            case MOD:
+                --sp;
+                pStack[sp - 1] = ExpressionMod::apply(pStack[sp - 1], pStack[sp]);
+                break;
+
+            default:
+                verify(false);
+            }
+        }
+
+        dassert(sp == 1);
+        return pStack[0];
+    }
+
+}
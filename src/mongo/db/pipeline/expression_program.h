@@ -0,0 +1,145 @@
+/**
+ * Copyright (C) 2013 Tokutek Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include "db/pipeline/value.h"
+#include "util/intrusive_counter.h"
+
+namespace mongo {
+
+    class Document;
+    class Expression;
+    class ExpressionFieldPath;
+    class ExpressionFieldRange;
+
+    /**
+     * A flattened, stack-based form of an Expression tree.
+     *
+     * Expressions compile themselves into the program through
+     * Expression::compile().  Constants become literal pushes, each distinct
+     * field path gets a slot that is resolved at most once per input
+     * document, and the common operators ($and, $or, $cond, $ifNull,
+     * comparisons and arithmetic) become opcodes operating on a value
+     * stack.  Anything without a native opcode is emitted as an EVALUATE
+     * instruction that calls back into the interpreted Expression, so every
+     * tree can be compiled and produces exactly the same results.
+     *
+     * evaluate() reuses scratch space held by the program, so a program may
+     * only be used by one thread at a time, like the pipeline that owns it.
+     */
+    class ExpressionProgram :
+        boost::noncopyable {
+    public:
+        enum OpCode {
+            PUSH_CONSTANT,       // push _constants[arg]
+            PUSH_FIELD,          // push the value of field slot arg, loading it once
+            PUSH_FIELD_UNCACHED, // push the value of field slot arg, which is used only once
+            EVALUATE,            // push _fallbacks[arg]->evaluate(doc)
+            JUMP,                // pc = arg
+            JUMP_IF_FALSE,       // pop; if !coerceToBool, pc = arg
+            JUMP_IF_TRUE,        // pop; if coerceToBool, pc = arg
+            JUMP_IF_NOT_NULLISH, // if top is not nullish pc = arg, else pop
+            TO_BOOL,             // replace top with its boolean coercion
+            NOT,                 // replace top with its negated boolean coercion
+            IN_RANGE,            // replace top with whether _ranges[arg] contains it
+            COMPARE,             // pop rhs, lhs; push comparison; arg is the CmpOp
+            ADD,                 // pop arg operands; push their $add
+            MULTIPLY,            // pop arg operands; push their $multiply
+            CONCAT,              // pop arg operands; push their $concat
+            SUBTRACT,            // pop rhs, lhs; push lhs - rhs
+            DIVIDE,              // pop rhs, lhs; push lhs / rhs
+            MOD,                 // pop rhs, lhs; push lhs % rhs
+        };
+
+        struct Instruction {
+            Instruction(OpCode theOp, unsigned theArg): op(theOp), arg(theArg) {}
+            OpCode op;
+            unsigned arg;
+        };
+
+        /**
+         * Compile the given expression.  The expression should already have
+         * been optimized; it is kept alive by the program since interpreted
+         * fallbacks and field slots point into it.
+         */
+        explicit ExpressionProgram(const intrusive_ptr<const Expression>& pRoot);
+
+        /** Evaluate the program against a document. */
+        Value evaluate(const Document& input) const;
+
+        /* builder interface used by Expression::compile() */
+
+        /** Append an instruction; returns its address. */
+        size_t emit(OpCode op, unsigned arg = 0);
+
+        /** The address of the next instruction to be emitted. */
+        size_t here() const { return _code.size(); }
+
+        /** Point the jump at address jumpAddr to the next instruction. */
+        void setJumpTarget(size_t jumpAddr);
+
+        /** Discard all instructions emitted at or after addr. */
+        void rewind(size_t addr);
+
+        void emitConstant(const Value& value);
+        void emitFieldPath(const ExpressionFieldPath* pFieldPath);
+
+        /** Emit a test of the value on top of the stack against a field range. */
+        void emitFieldRange(const ExpressionFieldRange* pFieldRange);
+
+        /** Emit a call back to the interpreted form of pExpression. */
+        void emitEvaluate(const Expression* pExpression);
+
+        /**
+         * Compile an operand of the expression being compiled.
+         *
+         * @returns true if the emitted code can never throw.
+         */
+        bool compileOperand(const intrusive_ptr<Expression>& pOperand);
+
+        /* introspection, mostly for tests */
+        size_t instructionCount() const { return _code.size(); }
+        size_t fieldSlotCount() const { return _fields.size(); }
+        size_t fallbackCount() const { return _fallbacks.size(); }
+        const vector<Instruction>& instructions() const { return _code; }
+
+    private:
+        const Value& fieldValue(unsigned slot, const Document& input) const;
+
+        intrusive_ptr<const Expression> _pRoot;
+
+        vector<Instruction> _code;
+        vector<Value> _constants;
+        vector<const Expression*> _fallbacks;
+        vector<const ExpressionFieldRange*> _ranges;
+
+        /* field slots, deduplicated by path */
+        vector<const ExpressionFieldPath*> _fields;
+        map<string, unsigned> _fieldSlots;
+
+        /* per-evaluation scratch space */
+        mutable vector<Value> _stack;
+        mutable vector<Value> _slotValues;
+
+        /* a slot holds the current document's value if its generation matches */
+        mutable vector<unsigned> _slotGeneration;
+        mutable unsigned _generation;
+    };
+
+}
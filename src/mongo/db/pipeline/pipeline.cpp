@@ -33,6 +33,7 @@ namespace mongo {
     const char Pipeline::explainName[] = "explain";
     const char Pipeline::fromRouterName[] = "fromRouter";
     const char Pipeline::splitMongodPipelineName[] = "splitMongodPipeline";
+    const char Pipeline::compileExpressionsName[] = "compileExpressions";
     const char Pipeline::serverPipelineName[] = "serverPipeline";
     const char Pipeline::mongosPipelineName[] = "mongosPipeline";
 
@@ -42,6 +43,7 @@ namespace mongo {
     Pipeline::Pipeline(const intrusive_ptr<ExpressionContext> &pTheCtx):
         collectionName(),
         explain(false),
+        compileExpressions(false),
         splitMongodPipeline(false),
         pCtx(pTheCtx) {
     }
@@ -124,6 +126,12 @@ namespace mongo {
                 continue;
             }
 
+            /* check for compiled expression evaluation */
+            if (!strcmp(pFieldName, compileExpressionsName)) {
+                pPipeline->compileExpressions = cmdElement.trueValue();
+                continue;
+            }
+
             /* if the request came from the router, we're in a shard */
             if (!strcmp(pFieldName, fromRouterName)) {
                 pCtx->setInShard(cmdElement.Bool());
@@ -293,6 +301,16 @@ namespace mongo {
             (*iter)->optimize();
         }
 
+        /* compile expressions only once the sources are in their final form */
+        if (pPipeline->compileExpressions) {
+            for(SourceContainer::iterator iter(sources.begin()),
+                                          listEnd(sources.end());
+                                        iter != listEnd;
+                                        ++iter) {
+                (*iter)->compileExpressions();
+            }
+        }
+
         return pPipeline;
     }
 
@@ -301,6 +319,7 @@ namespace mongo {
         intrusive_ptr<Pipeline> pShardPipeline(new Pipeline(pCtx));
         pShardPipeline->collectionName = collectionName;
         pShardPipeline->explain = explain;
+        pShardPipeline->compileExpressions = compileExpressions;
 
         /*
           Run through the pipeline, looking for points to split it into
@@ -371,6 +390,10 @@ namespace mongo {
             pBuilder->append(explainName, explain);
         }
 
+        if (compileExpressions) {
+            pBuilder->append(compileExpressionsName, compileExpressions);
+        }
+
         bool btemp;
         if ((btemp = getSplitMongodPipeline())) {
             pBuilder->append(splitMongodPipelineName, btemp);
@@ -416,18 +439,20 @@ namespace mongo {
             // cant use subArrayStart() due to error handling
             BSONArrayBuilder resultArray;
             DocumentSource* finalSource = sources.back().get();
-            for (bool hasDoc = !finalSource->eof(); hasDoc; hasDoc = finalSource->advance()) {
-                Document pDocument(finalSource->getCurrent());
-
-                /* add the document to the result set */
-                BSONObjBuilder documentBuilder (resultArray.subobjStart());
-                pDocument->toBson(&documentBuilder);
-                documentBuilder.doneFast();
-                // object will be too large, assert. the extra 1KB is for headers
-                uassert(16389,
-                        str::stream() << "aggregation result exceeds maximum document size ("
-                                      << BSONObjMaxUserSize / (1024 * 1024) << "MB)",
-                        resultArray.len() < BSONObjMaxUserSize - 1024);
+            vector<Document> batch;
+            while (finalSource->getNextBatch(&batch, DocumentSource::DefaultBatchSize)) {
+                const size_t n = batch.size();
+                for (size_t i = 0; i < n; ++i) {
+                    /* add the document to the result set */
+                    BSONObjBuilder documentBuilder (resultArray.subobjStart());
+                    batch[i]->toBson(&documentBuilder);
+                    documentBuilder.doneFast();
+                    // object will be too large, assert. the extra 1KB is for headers
+                    uassert(16389,
+                            str::stream() << "aggregation result exceeds maximum document size ("
+                                          << BSONObjMaxUserSize / (1024 * 1024) << "MB)",
+                            resultArray.len() < BSONObjMaxUserSize - 1024);
+                }
             }
 
             resultArray.done();
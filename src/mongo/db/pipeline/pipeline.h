@@ -152,6 +152,7 @@ namespace mongo {
         static const char explainName[];
         static const char fromRouterName[];
         static const char splitMongodPipelineName[];
+        static const char compileExpressionsName[];
         static const char serverPipelineName[];
         static const char mongosPipelineName[];
 
@@ -197,6 +198,9 @@ namespace mongo {
         SourceContainer sources;
         bool explain;
 
+        /* evaluate expressions through compiled ExpressionPrograms */
+        bool compileExpressions;
+
         bool splitMongodPipeline;
         intrusive_ptr<ExpressionContext> pCtx;
     };
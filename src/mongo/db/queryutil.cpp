@@ -1377,6 +1377,22 @@ namespace mongo {
         }
         return false;
     }
+
+    bool FieldRangeVector::singlePointsOn(uint64_t positions) const {
+        for (size_t i = 0; i < 64 && (positions >> i) != 0; i++) {
+            if (!((positions >> i) & 1)) {
+                continue;
+            }
+            // The last bit stands for every position from there on.
+            const size_t end = (i == 63 ? _ranges.size() : i + 1);
+            for (size_t j = i; j < std::max(end, i + 1); j++) {
+                if (j >= _ranges.size() || !_ranges[j].equality()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
     
     FieldRange *FieldRangeSet::__universalRange = 0;
     const FieldRange &FieldRangeSet::universalRange() const {
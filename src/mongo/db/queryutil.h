@@ -535,6 +535,9 @@ namespace mongo {
 
         // True if the first FieldRange in _ranges is a point interval.
         bool prefixedByPointInterval() const;
+
+        // True if every FieldRange whose position is set in the mask is a single point.
+        bool singlePointsOn(uint64_t positions) const;
         
     private:
         int matchingLowElement( const BSONElement &e, int i, bool direction, bool &lowEquality ) const;
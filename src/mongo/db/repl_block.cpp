@@ -115,7 +115,7 @@ namespace mongo {
                 theReplSet->ghost->updateSlave(ident.obj["_id"].OID(), gtid);
             }
 
-            _threadsWaitingForReplication.notify_all();
+            _wakeWaiters_locked(gtid);
         }
 
         OP_REPL_STATUS opReplicatedEnough( const GTID& gtid, BSONElement w ) {
@@ -123,8 +123,40 @@ namespace mongo {
                 REPLDEBUG( "looking for : " << op << " w=" << w );
             }
 
+            scoped_lock mylk(_mutex);
+            return _opReplicatedEnough_locked(gtid, w);
+        }
+
+        OP_REPL_STATUS waitForReplication( const GTID& gtid, BSONElement w, int maxMillis ) {
+            scoped_lock mylk(_mutex);
+            OP_REPL_STATUS s = _opReplicatedEnough_locked(gtid, w);
+            if (s != REPL_WAITING || maxMillis <= 0) {
+                return s;
+            }
+
+            Waiter waiter(gtid, w);
+            waiter.pos = _waiters.insert(make_pair(gtid, &waiter));
+            const boost::system_time deadline = boost::get_system_time() +
+                                                boost::posix_time::milliseconds(maxMillis);
+            while (waiter.registered) {
+                if (!waiter.cond.timed_wait(mylk.boost(), deadline)) {
+                    break;
+                }
+            }
+            if (waiter.registered) {
+                _waiters.erase(waiter.pos);
+                waiter.registered = false;
+            }
+            else if (waiter.status != REPL_WAITING) {
+                return waiter.status;
+            }
+            // timed out, or update() couldn't tell
+            return _opReplicatedEnough_locked(gtid, w);
+        }
+
+        OP_REPL_STATUS _opReplicatedEnough_locked( const GTID& gtid, BSONElement w ) {
             if (w.isNumber()) {
-                return replicatedToNum(gtid, w.numberInt());
+                return _replicatedToNum_locked(gtid, w.numberInt());
             }
 
             uassert( 16250 , "w has to be a string or a number" , w.type() == String );
@@ -135,7 +167,7 @@ namespace mongo {
             if (wStr == "majority") {
                 // use the entire set, including arbiters, to prevent writing
                 // to a majority of the set but not a majority of voters
-                return replicatedToNum(gtid, theReplSet->config().getMajority());
+                return _replicatedToNum_locked(gtid, theReplSet->config().getMajority());
             }
 
             map<string,ReplSetConfig::TagRule*>::const_iterator it = theReplSet->config().rules.find(wStr);
@@ -146,11 +178,15 @@ namespace mongo {
         }
 
         OP_REPL_STATUS replicatedToNum(const GTID& gtid, int w) {
+            scoped_lock mylk(_mutex);
+            return _replicatedToNum_locked( gtid, w );
+        }
+
+        OP_REPL_STATUS _replicatedToNum_locked(const GTID& gtid, int w) {
             if ( w <= 1 )
                 return REPL_SUCCESS;
 
             w--; // now this is the # of slaves i need
-            scoped_lock mylk(_mutex);
             return _replicatedToNum_slaves_locked( gtid, w );
         }
 
@@ -197,10 +233,53 @@ namespace mongo {
 
         // need to be careful not to deadlock with this
         mutable mongo::mutex _mutex;
-        boost::condition _threadsWaitingForReplication;
 
         map<Ident,GTID> _slaves;
 
+    private:
+        /**
+         * A thread in waitForReplication(), registered in _waiters by the GTID it waits for
+         * until update() finds it satisfied and wakes it.
+         */
+        struct Waiter {
+            Waiter(const GTID& g, BSONElement theW) :
+                gtid(g), w(theW), registered(true), status(REPL_WAITING) {}
+            const GTID gtid;
+            const BSONElement w;
+            multimap<GTID, Waiter*, GTIDCmp>::iterator pos;
+            bool registered;
+            OP_REPL_STATUS status;
+            boost::condition cond;
+        };
+
+        void _wakeWaiters_locked(const GTID& reported) {
+            // Only waiters for GTIDs up to the reported one can have been satisfied by it.
+            typedef multimap<GTID, Waiter*, GTIDCmp>::iterator Iter;
+            const Iter end = _waiters.upper_bound(reported);
+            for (Iter it = _waiters.begin(); it != end; ) {
+                Waiter& waiter = *it->second;
+                bool wake;
+                try {
+                    waiter.status = _opReplicatedEnough_locked(waiter.gtid, waiter.w);
+                    wake = waiter.status != REPL_WAITING;
+                }
+                catch (DBException&) {
+                    // e.g. the tag rule went away in a reconfig; wake the waiter so that it
+                    // gets the error itself
+                    wake = true;
+                }
+                if (!wake) {
+                    ++it;
+                    continue;
+                }
+                _waiters.erase(it++);
+                waiter.registered = false;
+                waiter.cond.notify_one();
+            }
+        }
+
+        multimap<GTID, Waiter*, GTIDCmp> _waiters;
+
     } slaveTracking;
 
     void updateSlaveLocation( CurOp& curop, const char * ns , GTID lastGTID ) {
@@ -238,6 +317,10 @@ namespace mongo {
         return slaveTracking.opReplicatedEnough( gtid, w );
     }
 
+    OP_REPL_STATUS waitForReplication( GTID gtid, BSONElement w, int maxMillis ) {
+        return slaveTracking.waitForReplication( gtid, w, maxMillis );
+    }
+
     // TODO: THIS IS ONLY CALLED IN SHARDING,
     // make this better
     bool opReplicatedEnough( GTID gtid, int w ) {
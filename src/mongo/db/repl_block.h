@@ -42,6 +42,13 @@ namespace mongo {
     bool opReplicatedEnough( GTID gtid , int w );
     OP_REPL_STATUS opReplicatedEnough( GTID gtid , BSONElement w );
 
+    /**
+     * Wait up to maxMillis for opReplicatedEnough( gtid , w ) to stop being REPL_WAITING.
+     * Rather than polling, the waiter is registered by gtid and woken by updateSlaveLocation()
+     * once a member reports a position that satisfies it.
+     */
+    OP_REPL_STATUS waitForReplication( GTID gtid , BSONElement w , int maxMillis );
+
     std::vector<BSONObj> getHostsWrittenTo(GTID gtid);
 
     void resetSlaveCache();
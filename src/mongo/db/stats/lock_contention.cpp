@@ -0,0 +1,227 @@
+// lock_contention.cpp
+
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/lock_contention.h"
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/cmdline.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/env.h"
+#include "mongo/util/background.h"
+
+namespace mongo {
+
+    // Number of key ranges tracked by the sketch.
+    MONGO_EXPORT_SERVER_PARAMETER(lockContentionTopK, int, 128);
+
+    // How often, in milliseconds, the pending lock requests are sampled.  0 turns sampling off.
+    MONGO_EXPORT_SERVER_PARAMETER(lockContentionSampleInterval, int, 100);
+
+    LockContention LockContention::global;
+
+    LockContention::LockContention() : _mutex("LockContention"), _events(0), _timeouts(0), _evictions(0) {}
+
+    void LockContention::record(const StringData &dname, const BSONObj &bounds, bool timedOut) {
+        string key;
+        key.reserve(dname.size() + 1 + bounds.objsize());
+        key.append(dname.rawData(), dname.size());
+        key.push_back('\0');
+        key.append(bounds.objdata(), bounds.objsize());
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        _events++;
+        if (timedOut) {
+            _timeouts++;
+        }
+
+        EntryMap::iterator it = _entries.find(key);
+        if (it == _entries.end()) {
+            long long inherited = 0;
+            const size_t k = std::max(lockContentionTopK, 1);
+            while (_entries.size() >= k) {
+                // The new range may have been seen up to as many times as the
+                // least frequent one we forget, while it wasn't being tracked.
+                EntryMap::iterator victim = _entries.begin();
+                for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+                    if (i->second.count < victim->second.count) {
+                        victim = i;
+                    }
+                }
+                inherited = victim->second.count;
+                _entries.erase(victim);
+                _evictions++;
+            }
+            it = _entries.insert(make_pair(key, Entry())).first;
+            Entry &e = it->second;
+            e.dname = dname.toString();
+            e.bounds = bounds.getOwned();
+            e.count = inherited;
+            e.error = inherited;
+        }
+
+        Entry &e = it->second;
+        e.count++;
+        if (timedOut) {
+            e.timeouts++;
+        }
+        e.lastSeen = jsTime();
+    }
+
+    static bool moreContended(const pair<long long, const void *> &a, const pair<long long, const void *> &b) {
+        return a.first > b.first;
+    }
+
+    void LockContention::appendTop(BSONArrayBuilder &b, size_t limit) const {
+        SimpleMutex::scoped_lock lk(_mutex);
+
+        vector<pair<long long, const void *> > ranked;
+        ranked.reserve(_entries.size());
+        for (EntryMap::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            ranked.push_back(make_pair(it->second.count, static_cast<const void *>(&it->second)));
+        }
+        const size_t n = std::min(limit, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + n, ranked.end(), moreContended);
+
+        for (size_t i = 0; i < n; ++i) {
+            const Entry &e = *static_cast<const Entry *>(ranked[i].second);
+            BSONObjBuilder eb(b.subobjStart());
+            // Index dictionaries are named "<ns>.$<index name>".
+            const size_t sep = e.dname.find(".$");
+            if (sep != string::npos) {
+                eb.append("ns", e.dname.substr(0, sep));
+                eb.append("index", e.dname.substr(sep + 2));
+            }
+            else {
+                eb.append("index", e.dname);
+            }
+            eb.append("bounds", e.bounds);
+            eb.appendNumber("count", e.count);
+            eb.appendNumber("maxError", e.error);
+            eb.appendNumber("timeouts", e.timeouts);
+            eb.appendDate("lastSeen", e.lastSeen);
+            eb.doneFast();
+        }
+    }
+
+    void LockContention::append(BSONObjBuilder &b, size_t limit) const {
+        {
+            SimpleMutex::scoped_lock lk(_mutex);
+            b.appendNumber("events", _events);
+            b.appendNumber("timeouts", _timeouts);
+            b.appendNumber("tracked", (long long) _entries.size());
+            b.appendNumber("evictions", _evictions);
+        }
+        b.append("sampleInterval", lockContentionSampleInterval);
+        BSONArrayBuilder ab(b.subarrayStart("top"));
+        appendTop(ab, limit);
+        ab.doneFast();
+    }
+
+    void LockContention::reset() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _entries.clear();
+        _events = 0;
+        _timeouts = 0;
+        _evictions = 0;
+    }
+
+    class LockContentionSampler : public BackgroundJob {
+    public:
+        virtual string name() const { return "LockContentionSampler"; }
+
+        virtual void run() {
+            while (!inShutdown()) {
+                const int interval = lockContentionSampleInterval;
+                if (interval <= 0) {
+                    sleepsecs(1);
+                    continue;
+                }
+                try {
+                    vector<BSONObj> requests;
+                    storage::get_pending_lock_request_status(requests);
+                    for (vector<BSONObj>::const_iterator it = requests.begin(); it != requests.end(); ++it) {
+                        LockContention::global.record(it->getStringField("index"), (*it)["bounds"].Obj(), false);
+                    }
+                }
+                catch (const std::exception &e) {
+                    LOG(1) << "lock contention sampler: " << e.what() << endl;
+                }
+                sleepmillis(interval);
+            }
+        }
+    };
+
+    void startLockContentionSampler() {
+        LockContentionSampler *sampler = new LockContentionSampler();
+        sampler->go();
+    }
+
+    class LockContentionSSS : public ServerStatusSection {
+    public:
+        LockContentionSSS() : ServerStatusSection("lockContention") {}
+        virtual bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(const BSONElement &configElement) const {
+            if (cmdLine.isMongos()) {
+                return BSONObj();
+            }
+            BSONObjBuilder b;
+            LockContention::global.append(b, 5);
+            return b.obj();
+        }
+    } lockContentionSSS;
+
+    class CmdShowLockContention : public WebInformationCommand {
+    public:
+        CmdShowLockContention() : WebInformationCommand("showLockContention") {}
+
+        virtual void help( stringstream& help ) const {
+            help << "the document-level lock ranges most often waited on since startup or the last reset\n"
+                 << "{ showLockContention : 1, limit : <n, default 20>, reset : <bool> }";
+        }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::showLockContention);
+            out->push_back(Privilege(AuthorizationManager::SERVER_RESOURCE_NAME, actions));
+        }
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            long long limit = 20;
+            if (cmdObj["limit"].isNumber()) {
+                limit = cmdObj["limit"].numberLong();
+                if (limit <= 0) {
+                    errmsg = "limit must be positive";
+                    return false;
+                }
+            }
+            LockContention::global.append(result, limit);
+            if (cmdObj["reset"].trueValue()) {
+                LockContention::global.reset();
+            }
+            return true;
+        }
+    } cmdShowLockContention;
+
+} // namespace mongo
@@ -0,0 +1,83 @@
+// lock_contention.h
+
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    /**
+     * Finds the row locks that are most often waited on.
+     *
+     * Blocked lock requests are counted by index and key range in a top-K
+     * "space saving" sketch: the K most frequent ranges are tracked exactly
+     * enough to rank them, and a range that is not tracked replaces the least
+     * frequent one, inheriting its count as an upper bound on the error.
+     * Memory is bounded by K no matter how many distinct ranges are seen.
+     *
+     * Events come from two places: the ydb's lock-not-granted callback, for
+     * requests that timed out, and a background sampler that periodically
+     * walks the pending lock requests, so a range is counted about once per
+     * sample interval for as long as someone waits on it.
+     */
+    class LockContention : boost::noncopyable {
+    public:
+        LockContention();
+
+        /**
+         * Count one blocked request for bounds (as built by the ydb lock
+         * iterators) in the index dictionary dname.
+         */
+        void record(const StringData &dname, const BSONObj &bounds, bool timedOut);
+
+        /** Append up to limit of the most contended ranges, most contended first. */
+        void appendTop(BSONArrayBuilder &b, size_t limit) const;
+
+        /** Append the totals and the most contended ranges. */
+        void append(BSONObjBuilder &b, size_t limit) const;
+
+        void reset();
+
+        static LockContention global;
+
+    private:
+        struct Entry {
+            Entry() : count(0), error(0), timeouts(0) {}
+            string dname;
+            BSONObj bounds;
+            long long count;    // may overcount by up to error
+            long long error;
+            long long timeouts;
+            Date_t lastSeen;
+        };
+        typedef map<string, Entry> EntryMap;
+
+        mutable SimpleMutex _mutex;
+        EntryMap _entries;
+        long long _events;
+        long long _timeouts;
+        long long _evictions;
+    };
+
+    void startLockContentionSampler();
+
+} // namespace mongo
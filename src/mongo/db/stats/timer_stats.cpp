@@ -46,6 +46,53 @@ namespace mongo {
         return millis;
     }
 
+    TimerHistogramStats::TimerHistogramStats()
+        : _num( 0 ), _totalMicros( 0 ) {
+        for ( int i = 0; i < numBuckets; i++ ) {
+            _buckets[i] = 0;
+        }
+    }
+
+    void TimerHistogramStats::recordMicros( long long micros ) {
+        int bucket = 0;
+        for ( long long upper = 1LL << smallestBucketBits;
+              bucket < numBuckets - 1 && micros >= upper;
+              upper <<= 1 ) {
+            bucket++;
+        }
+
+        scoped_spinlock lk( _lock );
+        _num++;
+        _totalMicros += micros;
+        _buckets[bucket]++;
+    }
+
+    BSONObj TimerHistogramStats::getReport() const {
+        long long n, t;
+        long long buckets[numBuckets];
+        {
+            scoped_spinlock lk( _lock );
+            n = _num;
+            t = _totalMicros;
+            for ( int i = 0; i < numBuckets; i++ ) {
+                buckets[i] = _buckets[i];
+            }
+        }
+        BSONObjBuilder b;
+        b.appendNumber( "num", n );
+        b.appendNumber( "totalMicros", t );
+        {
+            // each bucket is named by its lower bound in micros
+            BSONObjBuilder bb( b.subobjStart( "micros" ) );
+            for ( int i = 0; i < numBuckets; i++ ) {
+                const int lower = i == 0 ? 0 : 1 << ( smallestBucketBits + i - 1 );
+                bb.appendNumber( BSONObjBuilder::numStr( lower ), buckets[i] );
+            }
+            bb.done();
+        }
+        return b.obj();
+    }
+
     BSONObj TimerStats::getReport() const {
         long long n, t;
         {
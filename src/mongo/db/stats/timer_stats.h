@@ -52,6 +52,31 @@ namespace mongo {
         long long _totalMillis;
     };
 
+    /**
+     * Holds the distribution of timings in microseconds
+     * counts how many fall in each power of two bucket, from under 128 micros
+     * to 2^25 micros (about 33 seconds) and over, along with the number and
+     * total as in TimerStats
+     */
+    class TimerHistogramStats {
+    public:
+        TimerHistogramStats();
+
+        void recordMicros( long long micros );
+
+        BSONObj getReport() const;
+        operator BSONObj() const { return getReport(); }
+
+    private:
+        static const int smallestBucketBits = 7; // first bucket is [0, 128) micros
+        static const int numBuckets = 20; // last bucket is [2^25, inf) micros
+
+        mutable SpinLock _lock;
+        long long _num;
+        long long _totalMicros;
+        long long _buckets[numBuckets];
+    };
+
     /**
      * Holds an instance of a Timer such that we the time is recorded
      * when the TimerHolder goes out of scope
@@ -68,6 +93,11 @@ namespace mongo {
          */
         int millis() const { return _t.millis(); }
 
+        /**
+         * returns elapsed micros from internal timer
+         */
+        long long micros() const { return _t.micros(); }
+
         /**
          * records the time in the TimerStats and marks that we've
          * already recorded so the destructor doesn't
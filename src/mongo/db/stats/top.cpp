@@ -44,7 +44,9 @@ namespace mongo {
           insert( older.insert , newer.insert ) ,
           update( older.update , newer.update ) ,
           remove( older.remove , newer.remove ),
-          commands( older.commands , newer.commands ) {
+          commands( older.commands , newer.commands ) ,
+          lockNotGranted( older.lockNotGranted , newer.lockNotGranted ) ,
+          lockRetries( older.lockRetries , newer.lockRetries ) {
 
     }
 
@@ -65,6 +67,18 @@ namespace mongo {
         _record( _global , op , lockType , micros , command );
     }
 
+    void Top::recordLockNotGranted( const StringData& ns , long long micros ) {
+        SimpleMutex::scoped_lock lk(_lock);
+        _usage[ns].lockNotGranted.inc( micros );
+        _global.lockNotGranted.inc( micros );
+    }
+
+    void Top::recordLockRetry( const StringData& ns , long long backoffMicros ) {
+        SimpleMutex::scoped_lock lk(_lock);
+        _usage[ns].lockRetries.inc( backoffMicros );
+        _global.lockRetries.inc( backoffMicros );
+    }
+
     void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command ) {
         c.total.inc( micros );
 
@@ -150,6 +164,8 @@ namespace mongo {
             _appendStatsEntry( b , "update" , coll.update );
             _appendStatsEntry( b , "remove" , coll.remove );
             _appendStatsEntry( b , "commands" , coll.commands );
+            _appendStatsEntry( b , "lockNotGranted" , coll.lockNotGranted );
+            _appendStatsEntry( b , "lockRetries" , coll.lockRetries );
 
             bb.done();
         }
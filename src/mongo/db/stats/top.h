@@ -61,12 +61,19 @@ namespace mongo {
             UsageData update;
             UsageData remove;
             UsageData commands;
+
+            // writes that hit a row lock conflict, with the time spent in the failed attempt,
+            // and the retries of those writes, with the time spent backing off
+            UsageData lockNotGranted;
+            UsageData lockRetries;
         };
 
         typedef StringMap<CollectionData> UsageMap;
 
     public:
         void record( const StringData& ns , int op , int lockType , long long micros , bool command );
+        void recordLockNotGranted( const StringData& ns , long long micros );
+        void recordLockRetry( const StringData& ns , long long backoffMicros );
         void append( BSONObjBuilder& b );
         void cloneMap(UsageMap& out) const;
         CollectionData getGlobalData() const { return _global; }
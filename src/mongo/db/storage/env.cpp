@@ -29,7 +29,10 @@
 #include <toku_os.h>
 #include <partitioned_counter.h>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
 #ifdef _WIN32
 # error "Doesn't support windows."
 #endif
@@ -40,11 +43,15 @@
 #include "mongo/db/cmdline.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/descriptor.h"
+#include "mongo/db/stats/lock_contention.h"
+#include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/assert_ids.h"
 #include "mongo/db/storage/dbt.h"
 #include "mongo/db/storage/exception.h"
 #include "mongo/db/storage/key.h"
+#include "mongo/base/counter.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -175,12 +182,17 @@ namespace mongo {
                     const Key sKey(*i, &pk);
                     dbt_array_push(dest_keys, sKey.buf(), sKey.size());
                 }
-                // Set the multiKey bool if it's provided and we generated multiple keys.
+                // Note the multikey paths if a tracker is provided and we generated multiple keys.
                 // See CollectionBase::IndexerBase::Indexer()
                 if (dest_db->app_private != NULL && keys.size() > 1) {
-                    bool *multiKey = reinterpret_cast<bool *>(dest_db->app_private);
-                    if (!*multiKey) {
-                        *multiKey = true;
+                    AtomicUInt64 *multiKeyPaths = reinterpret_cast<AtomicUInt64 *>(dest_db->app_private);
+                    const uint64_t paths = Descriptor::multiKeyPaths(keys);
+                    for (uint64_t old = multiKeyPaths->load(); (old | paths) != old; ) {
+                        const uint64_t prev = multiKeyPaths->compareAndSwap(old, old | paths);
+                        if (prev == old) {
+                            break;
+                        }
+                        old = prev;
                     }
                 }
             } catch (const DBException &ex) {
@@ -943,16 +955,19 @@ namespace mongo {
         static void lock_not_granted_callback(DB *db, uint64_t requesting_txnid,
                                               const DBT *left_key, const DBT *right_key,
                                               uint64_t blocking_txnid) {
+            BSONObjBuilder info;
+            info.append("index", get_index_name(db));
+            info.appendNumber("requestingTxnid", requesting_txnid);
+            info.appendNumber("blockingTxnid", blocking_txnid);
+            BSONArrayBuilder bounds(info.subarrayStart("bounds"));
+            pretty_bounds(db, left_key, right_key, bounds);
+            bounds.done();
+            const BSONObj infoObj = info.obj();
+            LockContention::global.record(get_index_name(db), infoObj["bounds"].Obj(), true);
+
             CurOp *op = cc().curop();
             if (op != NULL) {
-                BSONObjBuilder info;
-                info.append("index", get_index_name(db));
-                info.appendNumber("requestingTxnid", requesting_txnid);
-                info.appendNumber("blockingTxnid", blocking_txnid);
-                BSONArrayBuilder bounds(info.subarrayStart("bounds"));
-                pretty_bounds(db, left_key, right_key, bounds);
-                bounds.done();
-                op->debug().lockNotGrantedInfo = info.obj();
+                op->debug().lockNotGrantedInfo = infoObj;
             }
         }
 
@@ -1049,6 +1064,105 @@ namespace mongo {
             }
         }
 
+        // Group commit: transactions commit without syncing the log and bump
+        // _committed.  Callers that need durability register the sequence
+        // number they need and a single flusher thread fsyncs the log on
+        // behalf of everyone waiting, so concurrent waiters share one fsync.
+        static Counter64 groupCommitFlushes;
+        static Counter64 groupCommitCommits;
+        static Counter64 groupCommitWaiters;
+        static TimerStats groupCommitWaitStats;
+
+        class GroupCommitFlusher : boost::noncopyable {
+          public:
+            GroupCommitFlusher() : _started(false), _requested(0), _flushed(0) {}
+
+            void noteCommit() {
+                _committed.fetchAndAdd(1);
+            }
+
+            void waitForFlush() {
+                // Everything committed before this point must be durable.
+                const unsigned long long target = _committed.load();
+                boost::mutex::scoped_lock lk(_mutex);
+                if (target <= _flushed) {
+                    return;
+                }
+                if (!_started) {
+                    boost::thread t(boost::bind(&GroupCommitFlusher::run, this));
+                    _started = true;
+                }
+                TimerHolder timer(&groupCommitWaitStats);
+                if (target > _requested) {
+                    _requested = target;
+                    _requestCond.notify_one();
+                }
+                while (_flushed < target) {
+                    _flushedCond.wait(lk);
+                }
+                groupCommitWaiters.increment();
+            }
+
+          private:
+            void run() {
+                setThreadName("groupCommitFlusher");
+                boost::mutex::scoped_lock lk(_mutex);
+                while (true) {
+                    while (_requested <= _flushed) {
+                        _requestCond.wait(lk);
+                    }
+                    // Commits that land while the previous flush was running are
+                    // picked up here, so they all ride on this one fsync.
+                    const unsigned long long target = _committed.load();
+                    lk.unlock();
+                    try {
+                        log_flush();
+                    }
+                    catch (DBException &e) {
+                        LOG(LL_ERROR) << "group commit log flush failed, retrying: " << e.what() << endl;
+                        sleepmillis(10);
+                        lk.lock();
+                        continue;
+                    }
+                    lk.lock();
+                    groupCommitFlushes.increment();
+                    groupCommitCommits.increment(target - _flushed);
+                    _flushed = target;
+                    _flushedCond.notify_all();
+                }
+            }
+
+            AtomicUInt64 _committed;
+            boost::mutex _mutex;
+            boost::condition_variable _requestCond;
+            boost::condition_variable _flushedCond;
+            bool _started;
+            unsigned long long _requested;
+            unsigned long long _flushed;
+        };
+
+        // Leaked so that it outlives any thread waiting on it at exit.
+        static GroupCommitFlusher &groupCommitFlusher = *new GroupCommitFlusher();
+
+        // flushes and commits give the average number of commits sharing an
+        // fsync, flushes and waiters the average number of waiters woken by one
+        static ServerStatusMetricField<Counter64> displayGroupCommitFlushes(
+                "logFlush.groupCommit.flushes", &groupCommitFlushes);
+        static ServerStatusMetricField<Counter64> displayGroupCommitCommits(
+                "logFlush.groupCommit.commits", &groupCommitCommits);
+        static ServerStatusMetricField<Counter64> displayGroupCommitWaiters(
+                "logFlush.groupCommit.waiters", &groupCommitWaiters);
+        static ServerStatusMetricField<TimerStats> displayGroupCommitWait(
+                "logFlush.groupCommit.wait", &groupCommitWaitStats);
+
+        void note_log_commit() {
+            groupCommitFlusher.noteCommit();
+        }
+
+        void wait_for_log_flush() {
+            groupCommitFlusher.waitForFlush();
+        }
+
         void checkpoint() {
             // Run a checkpoint. The zeros mean nothing (bdb-API artifacts).
             int r = env->txn_checkpoint(env, 0, 0, 0);
@@ -59,6 +59,13 @@ namespace mongo {
         void get_pending_lock_request_status(vector<BSONObj> &pendingLockRequests);
         void get_live_transaction_status(vector<BSONObj> &liveTransactions);
         void log_flush();
+        /** Record that a root transaction committed, possibly without syncing the log. */
+        void note_log_commit();
+        /**
+         * Wait until the log is synced past every transaction committed before the call.
+         * Concurrent callers share a single fsync done by a background flusher thread.
+         */
+        void wait_for_log_flush();
         void checkpoint();
 
         void set_log_flush_interval(uint32_t period_ms);
@@ -0,0 +1,184 @@
+// zone_map.cpp
+
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/zone_map.h"
+
+#include "mongo/db/keygenerator.h"
+#include "mongo/db/queryutil.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    ZoneMap::ZoneMap(const vector<string> &fields) :
+        _known(true),
+        _fields(fields),
+        _ranges(fields.size()) {
+    }
+
+    ZoneMap::ZoneMap(const vector<string> &fields, const BSONElement &e) :
+        _known(e.type() == Object),
+        _fields(fields),
+        _ranges(fields.size()) {
+        if (!_known) {
+            return;
+        }
+        const BSONObj zones = e.Obj();
+        for (size_t i = 0; i < _fields.size(); i++) {
+            const BSONElement range = zones[_fields[i]];
+            if (range.type() == Object) {
+                _ranges[i].add(range.Obj()["min"], range.Obj()["max"]);
+            }
+        }
+    }
+
+    bool ZoneMap::Range::add(const BSONElement &lo, const BSONElement &hi) {
+        bool changed = false;
+        if (min.isEmpty() || lo.woCompare(min.firstElement(), false) < 0) {
+            BSONObjBuilder b;
+            b.appendAs(lo, "");
+            min = b.obj();
+            changed = true;
+        }
+        if (max.isEmpty() || hi.woCompare(max.firstElement(), false) > 0) {
+            BSONObjBuilder b;
+            b.appendAs(hi, "");
+            max = b.obj();
+            changed = true;
+        }
+        return changed;
+    }
+
+    int ZoneMap::fieldIndex(const StringData &field) const {
+        for (size_t i = 0; i < _fields.size(); i++) {
+            if (field == _fields[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool ZoneMap::add(const BSONObj &obj) {
+        if (!_known) {
+            return false;
+        }
+        bool changed = false;
+        for (size_t i = 0; i < _fields.size(); i++) {
+            // the same keys a non-sparse index on just this field would get,
+            // so a document missing the field counts as null
+            vector<const char *> fieldNames(1, _fields[i].c_str());
+            BSONObjSet keys;
+            KeyGenerator::getKeys(obj, fieldNames, false, keys);
+            dassert(!keys.empty());
+            if (_ranges[i].add(keys.begin()->firstElement(), keys.rbegin()->firstElement())) {
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    bool ZoneMap::add(const StringData &field, const BSONElement &min, const BSONElement &max) {
+        const int i = fieldIndex(field);
+        if (!_known || i < 0) {
+            return false;
+        }
+        return _ranges[i].add(min, max);
+    }
+
+    bool ZoneMap::addModified(const BSONObj &updateObj) {
+        if (!_known) {
+            return false;
+        }
+        // Only compares the first component of each path, which is
+        // enough to stay safe in the presence of positional operators.
+        set<string> touched;
+        for (BSONObjIterator ops(updateObj); ops.more(); ) {
+            const BSONElement op = ops.next();
+            if (op.type() != Object) {
+                continue;
+            }
+            for (BSONObjIterator mods(op.Obj()); mods.more(); ) {
+                const BSONElement mod = mods.next();
+                touched.insert(mongoutils::str::before(mod.fieldName(), '.'));
+                if (mod.type() == String) {
+                    // $rename's target
+                    touched.insert(mongoutils::str::before(mod.valuestr(), '.'));
+                }
+            }
+        }
+        bool changed = false;
+        for (size_t i = 0; i < _fields.size(); i++) {
+            if (touched.count(mongoutils::str::before(_fields[i], '.')) &&
+                _ranges[i].add(minKey.firstElement(), maxKey.firstElement())) {
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    bool ZoneMap::excludes(const FieldRangeSet &frs) const {
+        if (!_known) {
+            return false;
+        }
+        for (size_t i = 0; i < _fields.size(); i++) {
+            if (_ranges[i].min.isEmpty()) {
+                // every document has a key for every field, so there are none
+                return true;
+            }
+        }
+        for (size_t i = 0; i < _fields.size(); i++) {
+            const FieldRange &fr = frs.range(_fields[i].c_str());
+            if (fr.universal()) {
+                continue;
+            }
+            const Range &range = _ranges[i];
+            const BSONElement min = range.min.firstElement();
+            const BSONElement max = range.max.firstElement();
+            bool overlaps = false;
+            for (vector<FieldInterval>::const_iterator it = fr.intervals().begin();
+                 !overlaps && it != fr.intervals().end(); ++it) {
+                const int lo = it->_lower._bound.woCompare(max, false);
+                const int hi = it->_upper._bound.woCompare(min, false);
+                overlaps = (lo < 0 || (lo == 0 && it->_lower._inclusive)) &&
+                           (hi > 0 || (hi == 0 && it->_upper._inclusive));
+            }
+            if (!overlaps) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    BSONObj ZoneMap::toBSON() const {
+        verify(_known);
+        BSONObjBuilder b;
+        for (size_t i = 0; i < _fields.size(); i++) {
+            const Range &range = _ranges[i];
+            if (range.min.isEmpty()) {
+                continue;
+            }
+            BSONObjBuilder rb(b.subobjStart(_fields[i]));
+            rb.appendAs(range.min.firstElement(), "min");
+            rb.appendAs(range.max.firstElement(), "max");
+            rb.done();
+        }
+        return b.obj();
+    }
+
+} // namespace mongo
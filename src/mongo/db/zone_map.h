@@ -0,0 +1,78 @@
+// zone_map.h
+
+/**
+*    Copyright (C) 2013 Tokutek Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "mongo/pch.h"
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    class FieldRangeSet;
+
+    // The smallest and largest index key the documents of one partition
+    // have produced for each of a few fields. A query whose bounds on one
+    // of those fields fall entirely outside that range cannot match
+    // anything in the partition. Zone maps only ever grow, deleting
+    // documents does not shrink them.
+    class ZoneMap {
+    public:
+        // a zone map we know nothing about, which rules nothing out
+        ZoneMap() : _known(false) { }
+        // the zone map of a partition with no documents
+        explicit ZoneMap(const vector<string> &fields);
+        // read back what toBSON() wrote, an EOO element gives an unknown zone map
+        ZoneMap(const vector<string> &fields, const BSONElement &e);
+
+        bool known() const { return _known; }
+
+        // include the keys obj generates for each field
+        // @return true if the zone map changed
+        bool add(const BSONObj &obj);
+        // include the keys of a range of documents whose field is
+        // in [min, max], as read from the first and last key of an index
+        // @return true if the zone map changed
+        bool add(const StringData &field, const BSONElement &min, const BSONElement &max);
+        // any field updateObj's mods touch may now hold anything
+        // @return true if the zone map changed
+        bool addModified(const BSONObj &updateObj);
+
+        // @return true if no document described by this zone map can match frs,
+        // which should be the multikey FieldRangeSet of the query
+        bool excludes(const FieldRangeSet &frs) const;
+
+        // { field: { min: ..., max: ... }, ... } with fields that no document
+        // has generated a key for left out
+        BSONObj toBSON() const;
+
+    private:
+        struct Range {
+            // single element objects, both empty until a key is added
+            BSONObj min;
+            BSONObj max;
+            bool add(const BSONElement &lo, const BSONElement &hi);
+        };
+        int fieldIndex(const StringData &field) const;
+
+        bool _known;
+        vector<string> _fields;
+        vector<Range> _ranges;
+    };
+
+} // namespace mongo
@@ -218,6 +218,81 @@ namespace DocumentSourceTests {
             }
         };
 
+        /** Iterate a DocumentSourceCursor in batches, mixed with single Document iteration. */
+        class IterateBatches : public Base {
+        public:
+            void run() {
+                for( int i = 1; i <= 5; ++i ) {
+                    client.insert( ns, BSON( "a" << i ) );
+                }
+                createSource();
+                vector<Document> batch;
+                // The first batch is limited to the requested size.
+                ASSERT( source()->getNextBatch( &batch, 2 ) );
+                ASSERT_EQUALS( 2U, batch.size() );
+                ASSERT_EQUALS( 1, batch[ 0 ]->getValue( "a" ).coerceToInt() );
+                ASSERT_EQUALS( 2, batch[ 1 ]->getValue( "a" ).coerceToInt() );
+                // The source is positioned after the batch.
+                ASSERT( !source()->eof() );
+                ASSERT_EQUALS( 3, source()->getCurrent()->getValue( "a" ).coerceToInt() );
+                ASSERT( source()->advance() );
+                // The last batch holds the remaining results.
+                ASSERT( source()->getNextBatch( &batch, 10 ) );
+                ASSERT_EQUALS( 2U, batch.size() );
+                ASSERT_EQUALS( 4, batch[ 0 ]->getValue( "a" ).coerceToInt() );
+                ASSERT_EQUALS( 5, batch[ 1 ]->getValue( "a" ).coerceToInt() );
+                // Exhausting the source releases the read lock.
+                ASSERT( !Lock::isReadLocked() );
+                ASSERT( !source()->getNextBatch( &batch, 10 ) );
+                ASSERT( batch.empty() );
+                ASSERT( source()->eof() );
+            }
+        };
+
+        /**
+         * Iterate 100-field documents reading only two fields from each, then again converting
+         * every field (the cost of the old eager conversion), and report both timings.
+         */
+        class WideDocumentsBenchmark : public Base {
+        public:
+            void run() {
+                const int nDocs = 5000;
+                const int nFields = 100;
+                for( int i = 0; i < nDocs; ++i ) {
+                    BSONObjBuilder bob;
+                    bob.append( "_id", i );
+                    for( int j = 1; j < nFields; ++j ) {
+                        bob.append( string( mongoutils::str::stream() << "f" << j ), i + j );
+                    }
+                    client.insert( ns, bob.obj() );
+                }
+
+                createSource();
+                long long sum = 0;
+                Timer twoFields;
+                for( bool more = !source()->eof(); more; more = source()->advance() ) {
+                    const Document doc = source()->getCurrent();
+                    sum += doc[ "f1" ].coerceToInt() + doc[ "f2" ].coerceToInt();
+                }
+                const int twoFieldsMillis = twoFields.millis();
+                // sum of (i + 1) + (i + 2) over all documents
+                ASSERT_EQUALS( (long long)nDocs * ( nDocs - 1 ) + 3LL * nDocs, sum );
+
+                createSource();
+                size_t nConverted = 0;
+                Timer allFields;
+                for( bool more = !source()->eof(); more; more = source()->advance() ) {
+                    nConverted += source()->getCurrent().getFieldCount();
+                }
+                const int allFieldsMillis = allFields.millis();
+                ASSERT_EQUALS( (size_t)nDocs * nFields, nConverted );
+
+                log() << "DocumentSourceCursor over " << nDocs << " documents with " << nFields
+                      << " fields: reading 2 fields took " << twoFieldsMillis
+                      << "ms, converting all fields took " << allFieldsMillis << "ms" << endl;
+            }
+        };
+
         /** Set a value or await an expected value. */
         class PendingValue {
         public:
@@ -342,6 +417,62 @@ namespace DocumentSourceTests {
             }
         };
 
+        /** A batch from a DocumentSourceLimit stops at the limit and disposes of the source. */
+        class Batch : public Base {
+        public:
+            void run() {
+                for( int i = 1; i <= 5; ++i ) {
+                    client.insert( ns, BSON( "a" << i ) );
+                }
+                createSource();
+                createLimit( 3 );
+                limit()->setSource( source() );
+                vector<Document> batch;
+                ASSERT( limit()->getNextBatch( &batch, 10 ) );
+                ASSERT_EQUALS( 3U, batch.size() );
+                ASSERT_EQUALS( 3, batch[ 2 ]->getValue( "a" ).coerceToInt() );
+                // The limit disposes the source, releasing the read lock.
+                ASSERT( !Lock::isReadLocked() );
+                ASSERT( limit()->eof() );
+                ASSERT( !limit()->getNextBatch( &batch, 10 ) );
+            }
+        };
+
+        /** Batches pass through a DocumentSourceMatch, which filters them. */
+        class BatchCascade : public Base {
+        public:
+            void run() {
+                int values[] = { 2, 1, 2, 1, 1, 2, 1 };
+                for( size_t i = 0; i < sizeof( values ) / sizeof( values[ 0 ] ); ++i ) {
+                    client.insert( ns, BSON( "_id" << static_cast<int>( i ) << "a" << values[ i ] ) );
+                }
+                createSource();
+
+                // Create a DocumentSourceMatch.
+                BSONObj spec = BSON( "$match" << BSON( "a" << 1 ) );
+                BSONElement specElement = spec.firstElement();
+                intrusive_ptr<DocumentSource> match =
+                        DocumentSourceMatch::createFromBson( &specElement, ctx() );
+                match->setSource( source() );
+
+                createLimit( 3 );
+                limit()->setSource( match.get() );
+                vector<Document> batch;
+                // Smaller batches than the limit are filled with matching documents only.
+                ASSERT( limit()->getNextBatch( &batch, 2 ) );
+                ASSERT_EQUALS( 2U, batch.size() );
+                ASSERT_EQUALS( 1, batch[ 0 ]->getValue( "_id" ).coerceToInt() );
+                ASSERT_EQUALS( 3, batch[ 1 ]->getValue( "_id" ).coerceToInt() );
+                // Single document iteration resumes at the next match.
+                ASSERT( !limit()->eof() );
+                ASSERT_EQUALS( 4, limit()->getCurrent()->getValue( "_id" ).coerceToInt() );
+                ASSERT( !limit()->advance() );
+                // The limit disposes the match, which disposes the source and releases the read
+                // lock.
+                ASSERT( !Lock::isReadLocked() );
+            }
+        };
+
         /** A limit does not introduce any dependencies. */
         class Dependencies : public Base {
         public:
@@ -1035,6 +1166,26 @@ namespace DocumentSourceTests {
             }
         };
 
+        /** Documents are projected a batch at a time. */
+        class Batch : public Base {
+        public:
+            void run() {
+                client.insert( ns, BSON( "a" << 1 << "b" << 2 ) );
+                client.insert( ns, BSON( "a" << 3 << "b" << 4 ) );
+                createSource();
+                createProject();
+                vector<Document> batch;
+                ASSERT( project()->getNextBatch( &batch, 10 ) );
+                ASSERT_EQUALS( 2U, batch.size() );
+                ASSERT_EQUALS( 1, batch[ 0 ]->getField( "a" ).getInt() );
+                ASSERT( batch[ 0 ]->getField( "b" ).missing() );
+                ASSERT_EQUALS( 3, batch[ 1 ]->getField( "a" ).getInt() );
+                ASSERT( batch[ 1 ]->getField( "b" ).missing() );
+                ASSERT( !project()->getNextBatch( &batch, 10 ) );
+                assertExhausted();
+            }
+        };
+
         /** List of dependent field paths. */
         class Dependencies : public Base {
         public:
@@ -1750,9 +1901,13 @@ namespace DocumentSourceTests {
             add<DocumentSourceCursor::Iterate>();
             add<DocumentSourceCursor::Dispose>();
             add<DocumentSourceCursor::IterateDispose>();
+            add<DocumentSourceCursor::IterateBatches>();
+            add<DocumentSourceCursor::WideDocumentsBenchmark>();
 
             add<DocumentSourceLimit::DisposeSource>();
             add<DocumentSourceLimit::DisposeSourceCascade>();
+            add<DocumentSourceLimit::Batch>();
+            add<DocumentSourceLimit::BatchCascade>();
             add<DocumentSourceLimit::Dependencies>();
 
             add<DocumentSourceGroup::NonObject>();
@@ -1803,6 +1958,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceProject::TopLevelDollar>();
             add<DocumentSourceProject::InvalidSpec>();
             add<DocumentSourceProject::TwoDocuments>();
+            add<DocumentSourceProject::Batch>();
             add<DocumentSourceProject::Dependencies>();
 
             add<DocumentSourceSort::EofInit>();
@@ -335,6 +335,51 @@ namespace DocumentTests {
             }
         };
 
+        /** A Document that converts fields from BSON on demand. */
+        class LazyFromBson {
+        public:
+            void run() {
+                const BSONObj obj = fromjson( "{a:1,b:'q',c:{z:1},d:[1,2],e:5.5,f:null}" );
+                const Document eager = fromBson( obj );
+
+                // Field lookups, including missing fields and nested documents.
+                Document lazy = Document::fromBsonLazy( obj );
+                ASSERT_EQUALS( 5.5, lazy["e"].getDouble() );
+                ASSERT_EQUALS( 1, lazy["a"].getInt() );
+                ASSERT_EQUALS( Value(1), lazy.getNestedField( FieldPath( "c.z" ) ) );
+                ASSERT( lazy["x"].missing() );
+
+                // Logically identical to an eagerly converted Document, with fields in order.
+                ASSERT_EQUALS( 6U, lazy.getFieldCount() );
+                ASSERT_EQUALS( "b", getNthField( lazy, 1 ).first.toStdString() );
+                ASSERT_EQUALS( 0, Document::compare( eager, Document::fromBsonLazy( obj ) ) );
+                ASSERT_EQUALS( 0, Document::compare( eager, lazy ) );
+                ASSERT_EQUALS( obj, toBson( Document::fromBsonLazy( obj ) ) );
+                assertRoundTrips( lazy );
+
+                // Modifications see every field and don't affect the original.
+                Document partial = Document::fromBsonLazy( obj );
+                ASSERT_EQUALS( "q", partial["b"].getString() );
+                MutableDocument md( partial );
+                md["a"] = Value( 2 );
+                md.addField( "g", Value( 3 ) );
+                ASSERT_EQUALS( fromjson( "{a:2,b:'q',c:{z:1},d:[1,2],e:5.5,f:null,g:3}" ),
+                               toBson( md.freeze() ) );
+                ASSERT_EQUALS( obj, toBson( partial ) );
+
+                // Appending to unshared storage converts the remaining fields first.
+                MutableDocument appender( Document::fromBsonLazy( obj ) );
+                appender.addField( "g", Value( 3 ) );
+                ASSERT_EQUALS( "g", getNthField( appender.peek(), 6 ).first.toStdString() );
+
+                // Clones continue from where the original left off.
+                Document clonedDocument = Document::fromBsonLazy( obj ).clone();
+                ASSERT_EQUALS( 0, Document::compare( eager, clonedDocument ) );
+
+                ASSERT( Document::fromBsonLazy( BSONObj() ).empty() );
+            }
+        };
+
         class AllTypesDoc {
         public:
             void run() {
@@ -1377,6 +1422,7 @@ namespace DocumentTests {
             add<Document::FieldIteratorEmpty>();
             add<Document::FieldIteratorSingle>();
             add<Document::FieldIteratorMultiple>();
+            add<Document::LazyFromBson>();
             add<Document::AllTypesDoc>();
 
             add<Value::Int>();
@@ -21,6 +21,7 @@
 #include "mongo/db/pipeline/expression.h"
 
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_program.h"
 
 #include "dbtests.h"
 
@@ -846,6 +847,245 @@ namespace ExpressionTests {
         
     } // namespace Compare
     
+    namespace Compiled {
+
+        /** Parse and optimize an operand expression from a json spec. */
+        static intrusive_ptr<Expression> parseOptimized( const string& spec ) {
+            BSONObj specObject = fromjson( "{'':" + spec + "}" );
+            BSONElement specElement = specObject.firstElement();
+            return Expression::parseOperand( &specElement )->optimize();
+        }
+
+        /** The result of evaluating an expression, or the code of the error it threw. */
+        static BSONObj evaluateOrError( const intrusive_ptr<Expression>& expression,
+                                        const Document& document ) {
+            try {
+                return toBson( expression->evaluate( document ) );
+            }
+            catch ( const UserException& e ) {
+                return BSON( "error" << e.getCode() );
+            }
+        }
+
+        /** Compiled and interpreted evaluation agree on every document. */
+        static void assertEquivalent( const string& spec, const vector<BSONObj>& documents ) {
+            intrusive_ptr<Expression> interpreted = parseOptimized( spec );
+            intrusive_ptr<Expression> compiled =
+                    ExpressionCompiled::compileTree( parseOptimized( spec ) );
+            for( vector<BSONObj>::const_iterator i = documents.begin();
+                 i != documents.end(); ++i ) {
+                Document document = fromBson( *i );
+                BSONObj expected = evaluateOrError( interpreted, document );
+                BSONObj actual = evaluateOrError( compiled, document );
+                if ( !expected.binaryEqual( actual ) ) {
+                    log() << "compiled " << spec << " on " << *i << " returned " << actual
+                          << ", expected " << expected << endl;
+                }
+                assertBinaryEqual( expected, actual );
+            }
+        }
+
+        static vector<BSONObj> testDocuments() {
+            vector<BSONObj> documents;
+            documents.push_back( BSONObj() );
+            documents.push_back( BSON( "a" << 1 << "b" << 2 ) );
+            documents.push_back( BSON( "a" << 7 << "b" << 3LL ) );
+            documents.push_back( BSON( "a" << 1.5 << "b" << 0 ) );
+            documents.push_back( BSON( "a" << BSONNULL << "b" << 4 ) );
+            documents.push_back( BSON( "b" << 4 ) );
+            documents.push_back( BSON( "a" << "x" << "b" << "y" ) );
+            documents.push_back( BSON( "a" << true << "b" << false ) );
+            documents.push_back( BSON( "a" << Date_t( 1000 ) << "b" << 10 ) );
+            documents.push_back( BSON( "a" << BSON( "c" << 3 ) << "b" << BSON_ARRAY( 1 << 2 ) ) );
+            return documents;
+        }
+
+        /** Every natively compiled operator, and a few that fall back, agree with evaluate(). */
+        class Equivalence {
+        public:
+            void run() {
+                const char* specs[] = {
+                    "{$add:['$a', 1, '$b']}",
+                    "{$add:['$a', {$concat:['$b']}]}",
+                    "{$add:[]}",
+                    "{$multiply:['$a', '$b', 2]}",
+                    "{$concat:['$a', '$b']}",
+                    "{$concat:['$a', '-', {$toUpper:'$b'}]}",
+                    "{$subtract:['$a', '$b']}",
+                    "{$divide:['$a', '$b']}",
+                    "{$mod:['$a', '$b']}",
+                    "{$and:['$a', '$b']}",
+                    "{$and:['$a', {$divide:['$b', 0]}]}",
+                    "{$or:['$a', {$eq:['$b', 2]}]}",
+                    "{$or:['$a', {$mod:['$b', 0]}]}",
+                    "{$not:'$a'}",
+                    "{$not:[{$and:['$a']}]}",
+                    "{$cond:[{$gt:['$a', '$b']}, '$a', '$b']}",
+                    "{$cond:['$a', {$divide:['$a', '$b']}, 'none']}",
+                    "{$ifNull:['$a', '$b']}",
+                    "{$ifNull:['$a', {$divide:['$b', 0]}]}",
+                    "{$cmp:['$a', '$b']}",
+                    "{$ne:['$a.c', 3]}",
+                    "{$gt:['$a', 1]}",
+                    "{$and:[{$gte:['$a', 1]}, {$lt:['$a', 5]}]}",
+                    "{$or:[{$lte:['$a', 1]}, {$divide:['$a', '$b']}]}",
+                    "{$lte:['$a', {$add:['$b', 1]}]}",
+                    "{$add:[{$multiply:['$a', '$a']}, {$ifNull:['$b', 0]}]}",
+                    "{$toUpper:'$a'}",
+                    "{$substr:['$a', 0, 1]}",
+                    "{$add:[1, 2, 3]}",
+                };
+                vector<BSONObj> documents = testDocuments();
+                for( size_t i = 0; i < sizeof( specs ) / sizeof( specs[ 0 ] ); ++i ) {
+                    assertEquivalent( specs[ i ], documents );
+                }
+            }
+        };
+
+        static const ExpressionProgram& programFor( const intrusive_ptr<Expression>& expression ) {
+            ExpressionCompiled* compiled = dynamic_cast<ExpressionCompiled*>( expression.get() );
+            ASSERT( compiled );
+            return compiled->getProgram();
+        }
+
+        /** Repeated field paths share a slot and operands that can't throw are inlined. */
+        class SharedFieldSlots {
+        public:
+            void run() {
+                intrusive_ptr<Expression> compiled = ExpressionCompiled::compileTree(
+                        parseOptimized( "{$add:['$a', '$a', {$cond:[{$gt:['$a', '$b']}, '$a', '$b']}]}" ) );
+                const ExpressionProgram& program = programFor( compiled );
+                ASSERT_EQUALS( 2U, program.fieldSlotCount() );
+                ASSERT_EQUALS( 0U, program.fallbackCount() );
+                ASSERT_EQUALS( BSON( "" << 5 ),
+                               toBson( compiled->evaluate( fromBson( BSON( "a" << 1 <<
+                                                                           "b" << 3 ) ) ) ) );
+            }
+        };
+
+        /** An operator without a native instruction is evaluated by the interpreter. */
+        class Fallback {
+        public:
+            void run() {
+                intrusive_ptr<Expression> compiled =
+                        ExpressionCompiled::compileTree( parseOptimized( "{$toLower:'$a'}" ) );
+                const ExpressionProgram& program = programFor( compiled );
+                ASSERT_EQUALS( 1U, program.instructionCount() );
+                ASSERT_EQUALS( 1U, program.fallbackCount() );
+                ASSERT_EQUALS( BSON( "" << "abc" ),
+                               toBson( compiled->evaluate( fromBson( BSON( "a" << "ABC" ) ) ) ) );
+            }
+        };
+
+        /**
+         * $add may not eagerly evaluate a later operand that can throw, since a null earlier
+         * operand would have skipped it; the whole $add is interpreted instead.
+         */
+        class EagerOperandMayThrow {
+        public:
+            void run() {
+                intrusive_ptr<Expression> compiled = ExpressionCompiled::compileTree(
+                        parseOptimized( "{$add:['$a', {$divide:['$b', 0]}]}" ) );
+                const ExpressionProgram& program = programFor( compiled );
+                ASSERT_EQUALS( 1U, program.instructionCount() );
+                ASSERT_EQUALS( BSON( "" << BSONNULL ),
+                               toBson( compiled->evaluate( fromBson( BSON( "b" << 1 ) ) ) ) );
+            }
+        };
+
+        /** Constant folding happens before compilation; constants are not wrapped. */
+        class FoldedConstant {
+        public:
+            void run() {
+                intrusive_ptr<Expression> compiled =
+                        ExpressionCompiled::compileTree( parseOptimized( "{$add:[1, 2]}" ) );
+                ASSERT( dynamic_cast<ExpressionConstant*>( compiled.get() ) );
+            }
+        };
+
+        /** A compiled expression serializes exactly like the original. */
+        class Serialization {
+        public:
+            void run() {
+                const string spec = "{$cond:[{$gt:['$a', 1]}, {$add:['$a', 1]}, '$b']}";
+                intrusive_ptr<Expression> interpreted = parseOptimized( spec );
+                intrusive_ptr<Expression> compiled =
+                        ExpressionCompiled::compileTree( parseOptimized( spec ) );
+                ASSERT_EQUALS( expressionToBson( interpreted ), expressionToBson( compiled ) );
+
+                set<string> interpretedDeps;
+                interpreted->addDependencies( interpretedDeps );
+                set<string> compiledDeps;
+                compiled->addDependencies( compiledDeps );
+                ASSERT( interpretedDeps == compiledDeps );
+            }
+        };
+
+        /** ExpressionObject fields are compiled in place, preserving inclusion and order. */
+        class ObjectFields {
+        public:
+            void run() {
+                BSONObj spec = fromjson( "{'':{b:true, x:{$add:['$a', '$b']},"
+                                         "y:{z:{$concat:['$c', '!']}}}}" );
+                BSONElement specElement = spec.firstElement();
+                Expression::ObjectCtx context( Expression::ObjectCtx::DOCUMENT_OK |
+                                               Expression::ObjectCtx::TOP_LEVEL |
+                                               Expression::ObjectCtx::INCLUSION_OK );
+                intrusive_ptr<Expression> interpreted =
+                        Expression::parseObject( &specElement, &context )->optimize();
+                intrusive_ptr<Expression> compiled =
+                        Expression::parseObject( &specElement, &context )->optimize();
+                ASSERT( ExpressionCompiled::compileTree( compiled ) == compiled );
+
+                Document document = fromBson( BSON( "a" << 1 << "b" << 2 << "c" << "hi" ) );
+                assertBinaryEqual( toBson( interpreted->evaluate( document ) ),
+                                   toBson( compiled->evaluate( document ) ) );
+            }
+        };
+
+        /** Compare the speed of compiled and interpreted evaluation. */
+        class Timing {
+        public:
+            void run() {
+                const string spec = "{$cond:[{$gt:['$x.y.z', 50]},"
+                                    "{$subtract:['$x.y.z', '$b']},"
+                                    "{$subtract:['$b', '$x.y.z']}]}";
+                intrusive_ptr<Expression> interpreted = parseOptimized( spec );
+                intrusive_ptr<Expression> compiled =
+                        ExpressionCompiled::compileTree( parseOptimized( spec ) );
+
+                vector<Document> documents;
+                for( int i = 0; i < 100; ++i ) {
+                    documents.push_back( fromBson( BSON( "a" << i << "b" << 50 <<
+                                                         "x" << BSON( "y" << BSON( "z" << i ) ) ) ) );
+                }
+
+                long long interpretedSum = 0;
+                Timer t;
+                for( int i = 0; i < 2000; ++i ) {
+                    for( size_t j = 0; j < documents.size(); ++j ) {
+                        interpretedSum += interpreted->evaluate( documents[ j ] ).coerceToLong();
+                    }
+                }
+                long interpretedMillis = t.millis();
+
+                long long compiledSum = 0;
+                t.reset();
+                for( int i = 0; i < 2000; ++i ) {
+                    for( size_t j = 0; j < documents.size(); ++j ) {
+                        compiledSum += compiled->evaluate( documents[ j ] ).coerceToLong();
+                    }
+                }
+                long compiledMillis = t.millis();
+
+                ASSERT_EQUALS( interpretedSum, compiledSum );
+                log() << "expression evaluation interpreted: " << interpretedMillis
+                      << "ms compiled: " << compiledMillis << "ms" << endl;
+            }
+        };
+
+    } // namespace Compiled
+
     namespace Constant {
 
         /** Create an ExpressionConstant from a Value. */
@@ -3269,6 +3509,15 @@ namespace ExpressionTests {
             add<Compare::OptimizeGte>();
             add<Compare::OptimizeGteReverse>();
 
+            add<Compiled::Equivalence>();
+            add<Compiled::SharedFieldSlots>();
+            add<Compiled::Fallback>();
+            add<Compiled::EagerOperandMayThrow>();
+            add<Compiled::FoldedConstant>();
+            add<Compiled::Serialization>();
+            add<Compiled::ObjectFields>();
+            add<Compiled::Timing>();
+
             add<Constant::Create>();
             add<Constant::CreateFromBsonElement>();
             add<Constant::Optimize>();
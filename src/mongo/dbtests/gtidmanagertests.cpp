@@ -16,8 +16,12 @@
  */
 
 #include "pch.h"
+
+#include <boost/thread/thread.hpp>
+
 #include "dbtests.h"
 #include "mongo/db/gtid.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
     class GTIDManagerTest {
@@ -262,10 +266,107 @@ namespace mongo {
 
         }
 
+        // live GTIDs done out of order, and more GTIDs handed out than fit in the ring
+        void testLiveRing() {
+            GTIDManager mgr(GTID(1,1), 0, 0, 0, 0);
+            mgr.catchUnappliedToLive();
+            GTID p;
+            uint64_t ts;
+            uint64_t hash;
+
+            GTID held;
+            mgr.getGTIDForPrimary(&held, &ts, &hash);
+            ASSERT(GTID::cmp(mgr._minLiveGTID, held) == 0);
+            vector<GTID> others;
+            for (uint64_t i = 0; i < GTIDManager::LIVE_RING_SIZE - 1; i++) {
+                mgr.getGTIDForPrimary(&p, &ts, &hash);
+                others.push_back(p);
+            }
+            // done newest first, the oldest is still live
+            for (vector<GTID>::reverse_iterator it = others.rbegin(); it != others.rend(); ++it) {
+                mgr.noteLiveGTIDDone(*it);
+                ASSERT(GTID::cmp(mgr.getMinLiveGTID(), held) == 0);
+            }
+            mgr.noteLiveGTIDDone(held);
+            GTID next = others.back();
+            next.inc();
+            ASSERT(GTID::cmp(mgr.getMinLiveGTID(), next) == 0);
+            ASSERT(GTID::cmp(mgr._minUnappliedGTID, next) == 0);
+
+            // wrap around the ring a few times
+            for (uint64_t i = 0; i < 3 * GTIDManager::LIVE_RING_SIZE; i++) {
+                GTID a, b;
+                mgr.getGTIDForPrimary(&a, &ts, &hash);
+                mgr.getGTIDForPrimary(&b, &ts, &hash);
+                mgr.noteLiveGTIDDone(b);
+                ASSERT(GTID::cmp(mgr.getMinLiveGTID(), a) == 0);
+                mgr.noteLiveGTIDDone(a);
+                b.inc();
+                ASSERT(GTID::cmp(mgr.getMinLiveGTID(), b) == 0);
+            }
+        }
+
         void run() {
             GTIDtest();
             testGTIDManager();
             simulateElectionRelatedStuff();
+            testLiveRing();
+        }
+    };
+
+    // Commit throughput of the GTIDManager on a primary, with several
+    // threads each getting a GTID and noting it done, as root commits do.
+    // Committers may yield while their GTID is live, as if the commit were
+    // slow to finish, so that GTIDs are done out of order across threads.
+    class GTIDCommitThroughput {
+    public:
+        void run() {
+            measure(1, false);
+            measure(4, false);
+            measure(16, false);
+            measure(4, true);
+            measure(16, true);
+        }
+    private:
+        static const int ITERATIONS = 20000;
+
+        static void committer(GTIDManager *mgr, bool yield) {
+            GTID gtid;
+            uint64_t ts;
+            uint64_t hash;
+            for (int i = 0; i < ITERATIONS; i++) {
+                mgr->getGTIDForPrimary(&gtid, &ts, &hash);
+                if (yield) {
+                    boost::this_thread::yield();
+                }
+                mgr->noteLiveGTIDDone(gtid);
+            }
+        }
+
+        void measure(int nThreads, bool yield) {
+            GTIDManager mgr(GTID(1,1), 0, 0, 0, 0);
+            mgr.catchUnappliedToLive();
+
+            Timer t;
+            vector<shared_ptr<boost::thread> > threads;
+            for (int i = 0; i < nThreads; i++) {
+                threads.push_back(shared_ptr<boost::thread>(
+                        new boost::thread(boost::bind(&GTIDCommitThroughput::committer, &mgr, yield))));
+            }
+            for (int i = 0; i < nThreads; i++) {
+                threads[i]->join();
+            }
+            const long long micros = std::max((long long) t.micros(), 1LL);
+
+            // everything handed out is done
+            GTID last = mgr.getLiveState();
+            ASSERT(GTID::cmp(last, GTID(1, 1 + (uint64_t) nThreads * ITERATIONS)) == 0);
+            last.inc();
+            ASSERT(GTID::cmp(mgr.getMinLiveGTID(), last) == 0);
+
+            log() << "GTIDManager commit throughput, " << nThreads << " threads"
+                  << (yield ? " yielding while live: " : ": ")
+                  << (long long) nThreads * ITERATIONS * 1000000 / micros << " commits/s" << endl;
         }
     };
 }
@@ -278,6 +379,7 @@ namespace GTIDManagerTests {
 
         void setupTests() {
             add<GTIDManagerTest>();
+            add<GTIDCommitThroughput>();
         }
 
     } all;
@@ -1551,6 +1551,122 @@ namespace JsonTests {
             }
         };
 
+        /** Escapes and quotes on either side of the 16 byte blocks scanned at once. */
+        class LongStringEscapes : public Base {
+            virtual BSONObj bson() const {
+                BSONObjBuilder b;
+                b.append( "a", string( 15, 'x' ) + "\"" + string( 16, 'y' ) + "\\" + string( 33, 'z' ) );
+                b.append( "b", string( 40, 'x' ) + "'" + string( 3, 'y' ) );
+                b.append( "c", string( 31, 'x' ) + "\n" );
+                return b.obj();
+            }
+            virtual string json() const {
+                return "{ \"a\" : \"" + string( 15, 'x' ) + "\\\"" + string( 16, 'y' ) + "\\\\" +
+                       string( 33, 'z' ) + "\", " +
+                       "'b' : '" + string( 40, 'x' ) + "\\'" + string( 3, 'y' ) + "', " +
+                       "c : \"" + string( 31, 'x' ) + "\\n\" }";
+            }
+        };
+
+        class LongStringControlCharacter : public Bad {
+            virtual string json() const {
+                return "{ a : \"" + string( 20, 'x' ) + "\x01" + string( 20, 'y' ) + "\" }";
+            }
+        };
+
+        /** Integers around the 18 digits parsed without strtod/strtoll. */
+        class IntegerDigits : public Base {
+            virtual BSONObj bson() const {
+                BSONObjBuilder b;
+                b.append( "a", 123456789012345678LL );
+                b.append( "b", 1234567890123456789LL );
+                b.append( "c", -123456789012345678LL );
+                b.append( "d", 7 );
+                b.append( "e", 2147483648LL );
+                b.append( "f", 12.0 );
+                b.append( "g", 1.5e20 );
+                return b.obj();
+            }
+            virtual string json() const {
+                return "{ a : 123456789012345678, b : 1234567890123456789, c : -123456789012345678, "
+                       "d : 007, e : 2147483648, f : 12.0, g : 150000000000000000000 }";
+            }
+        };
+
+        /**
+         * Parsing throughput in MB/s of JSON text for a few shapes of document, one document at a
+         * time as with mongoimport's default mode, and out of one array as with --jsonArray.
+         */
+        class Throughput {
+        public:
+            void run() {
+                const int nDocs = 2000;
+                measure( "strings", nDocs, &Throughput::stringDoc );
+                measure( "numbers", nDocs, &Throughput::numberDoc );
+                measure( "nested", nDocs, &Throughput::nestedDoc );
+            }
+        private:
+            static BSONObj stringDoc( int i ) {
+                return BSON( "_id" << i <<
+                             "name" << "some user name that is reasonably long" <<
+                             "email" << "someone@example.com" <<
+                             "bio" << string( 200 + i % 100, 'x' ) + "\n\"quoted\"" );
+            }
+            static BSONObj numberDoc( int i ) {
+                BSONObjBuilder b;
+                b.append( "_id", i );
+                for ( int f = 0; f < 20; ++f ) {
+                    b.append( string( "n" ) + BSONObjBuilder::numStr( f ), i * 1000LL + f );
+                }
+                b.append( "d", i / 7.0 );
+                return b.obj();
+            }
+            static BSONObj nestedDoc( int i ) {
+                return BSON( "_id" << i <<
+                             "tags" << BSON_ARRAY( "alpha" << "beta" << "gamma" ) <<
+                             "address" << BSON( "street" << "1 Main St" << "city" << "Springfield" <<
+                                                "geo" << BSON_ARRAY( 1.5 << -2.25 ) ) <<
+                             "when" << Date_t( 1257829200000LL + i ) <<
+                             "flag" << true );
+            }
+            void measure( const char *shape, int nDocs, BSONObj (*makeDoc)( int ) ) {
+                vector<string> lines;
+                string array = "[";
+                long long bytes = 0;
+                for ( int i = 0; i < nDocs; ++i ) {
+                    lines.push_back( makeDoc( i ).jsonString() );
+                    bytes += lines.back().size();
+                    array += ( i ? "," : "" ) + lines.back();
+                }
+                array += "]";
+
+                const int passes = 5;
+                Timer lineTimer;
+                for ( int pass = 0; pass < passes; ++pass ) {
+                    for ( int i = 0; i < nDocs; ++i ) {
+                        ASSERT_EQUALS( i, fromjson( lines[i] )["_id"].numberInt() );
+                    }
+                }
+                const long long lineMicros = std::max( (long long) lineTimer.micros(), 1LL );
+
+                Timer arrayTimer;
+                for ( int pass = 0; pass < passes; ++pass ) {
+                    const char *p = array.c_str() + 1;
+                    const char *end = array.c_str() + array.size();
+                    for ( int i = 0; i < nDocs; ++i ) {
+                        int len;
+                        ASSERT_EQUALS( i, fromjson( p, end, &len )["_id"].numberInt() );
+                        p += len + 1; // and the ','
+                    }
+                }
+                const long long arrayMicros = std::max( (long long) arrayTimer.micros(), 1LL );
+
+                log() << "fromjson throughput (" << shape << "): "
+                      << bytes * passes / lineMicros << " MB/s per line, "
+                      << bytes * passes / arrayMicros << " MB/s from an array" << endl;
+            }
+        };
+
     } // namespace FromJsonTests
 
     class All : public Suite {
@@ -1691,6 +1807,10 @@ namespace JsonTests {
             add< FromJsonTests::EmbeddedDatesFormat3 >();
             add< FromJsonTests::NullString >();
             add< FromJsonTests::NullFieldUnquoted >();
+            add< FromJsonTests::LongStringEscapes >();
+            add< FromJsonTests::LongStringControlCharacter >();
+            add< FromJsonTests::IntegerDigits >();
+            add< FromJsonTests::Throughput >();
         }
     } myall;
 
@@ -276,6 +276,32 @@ namespace MatcherTests {
         
     } // namespace Covered
     
+    /** Several predicates, whose top level fields are extracted in one pass. */
+    class MultipleFields {
+    public:
+        void run() {
+            // plain and dotted predicates sharing a top level field, and a missing field
+            Matcher m( fromjson( "{a:1,'b.c':2,b:{$exists:true},d:{$ne:5},e:{$in:[null]}}" ) );
+            ASSERT( m.matches( fromjson( "{b:{c:2},a:1}" ) ) );
+            ASSERT( m.matches( fromjson( "{z:0,a:1,b:{c:[1,2]},d:4,e:null}" ) ) );
+            ASSERT( !m.matches( fromjson( "{a:1,b:{c:2},d:5}" ) ) );
+            ASSERT( !m.matches( fromjson( "{a:1,b:{c:3}}" ) ) );
+            ASSERT( !m.matches( fromjson( "{a:1}" ) ) );
+            ASSERT( !m.matches( fromjson( "{a:1,b:{c:2},e:1}" ) ) );
+            // the first of duplicate fields is used, as by getField()
+            ASSERT( m.matches( fromjson( "{a:1,a:2,b:{c:2}}" ) ) );
+            ASSERT( !m.matches( fromjson( "{a:2,a:1,b:{c:2}}" ) ) );
+            // arrays below the top level field
+            Matcher arr( fromjson( "{'a.b':1,'a.c':2}" ) );
+            ASSERT( arr.matches( fromjson( "{a:[{b:1},{c:2}]}" ) ) );
+            ASSERT( !arr.matches( fromjson( "{a:[{b:1},{c:3}]}" ) ) );
+            // $all and $elemMatch on an extracted field
+            Matcher all( fromjson( "{x:{$all:[{$elemMatch:{y:1}}]},z:{$elemMatch:{$gt:2}}}" ) );
+            ASSERT( all.matches( fromjson( "{z:[1,3],x:[{y:1}]}" ) ) );
+            ASSERT( !all.matches( fromjson( "{z:[1,2],x:[{y:1}]}" ) ) );
+        }
+    };
+
     class TimingBase {
     public:
         long time( const BSONObj& patt , const BSONObj& obj ) {
@@ -418,6 +444,7 @@ namespace MatcherTests {
             add<Covered::ElemMatchKeyUnindexed>();
             add<Covered::ElemMatchKeyIndexed>();
             add<Covered::ElemMatchKeyIndexedSingleKey>();
+            add<MultipleFields>();
             add<AllTiming>();
             add<Visit>();
             add<WithinBox>();
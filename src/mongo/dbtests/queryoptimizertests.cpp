@@ -1619,6 +1619,75 @@ namespace QueryOptimizerTests {
         }
     };
     
+    /**
+     * Matching many predicates against wide documents, through the query optimizer.  The
+     * document matcher finds all the fields it needs in one walk of each document; compare
+     * with matching each predicate separately, which scans the document once per predicate.
+     */
+    class WideDocumentMatchTiming : public Base {
+    public:
+        void run() {
+            const int nFields = 64;
+            const int nDocs = 2000;
+            for ( int i = 0; i < nDocs; ++i ) {
+                BSONObjBuilder b;
+                b.append( "_id", i );
+                for ( int f = 0; f < nFields; ++f ) {
+                    b.append( string( "f" ) + BSONObjBuilder::numStr( f ), ( i + f ) % 10 );
+                }
+                b.append( "sub", BSON( "x" << i % 2 ) );
+                insertObject( ns(), b.obj() );
+            }
+
+            // Predicates on fields from the back of the document, the worst case for getField().
+            BSONObj query = fromjson( "{f63:{$gte:1},f62:{$ne:3},f61:{$lt:9},f60:{$in:[1,2,3,4,5,6,7]},"
+                                      "f59:{$exists:true},f58:{$gt:0},'sub.x':1,f56:{$nin:[0]}}" );
+
+            vector<shared_ptr<Matcher> > single;
+            BSONObjIterator it( query );
+            while ( it.more() ) {
+                single.push_back( shared_ptr<Matcher>( new Matcher( it.next().wrap() ) ) );
+            }
+
+            const int passes = 20;
+            long long combinedMatches = 0;
+            Timer combinedTimer;
+            for ( int pass = 0; pass < passes; ++pass ) {
+                shared_ptr<Cursor> c = getBestGuessCursor( ns(), query, BSONObj() );
+                for ( ; c->ok(); c->advance() ) {
+                    if ( c->currentMatches() ) {
+                        ++combinedMatches;
+                    }
+                }
+            }
+            const int combinedMillis = combinedTimer.millis();
+
+            long long singleMatches = 0;
+            Timer singleTimer;
+            for ( int pass = 0; pass < passes; ++pass ) {
+                shared_ptr<Cursor> c = getBestGuessCursor( ns(), BSONObj(), BSONObj() );
+                for ( ; c->ok(); c->advance() ) {
+                    const BSONObj doc = c->current();
+                    bool match = true;
+                    for ( size_t i = 0; match && i < single.size(); ++i ) {
+                        match = single[i]->matches( doc );
+                    }
+                    if ( match ) {
+                        ++singleMatches;
+                    }
+                }
+            }
+            const int singleMillis = singleTimer.millis();
+
+            ASSERT_EQUALS( singleMatches, combinedMatches );
+            ASSERT( combinedMatches > 0 );
+            ASSERT( combinedMatches < (long long) nDocs * passes );
+            cerr << "wide document match: " << single.size() << " predicates, " << nFields
+                 << " fields, " << nDocs * passes << " documents: combined " << combinedMillis
+                 << "ms, one matcher per predicate " << singleMillis << "ms" << endl;
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "queryoptimizer" ) {}
@@ -1698,6 +1767,7 @@ namespace QueryOptimizerTests {
             add<MultiPlanScannerTests::ToString>();
             add<MultiPlanScannerTests::PossiblePlans>();
             add<BestGuess>();
+            add<WideDocumentMatchTiming>();
         }
     } myall;
 
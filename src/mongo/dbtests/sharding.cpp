@@ -61,6 +61,116 @@ namespace ShardingTests {
         return max > 0 ? r % max : r;
     }
 
+    namespace mergetests {
+
+        typedef vector< vector<BSONObj> > Streams;
+
+        struct SortOrderLess {
+            BSONObj sortKey;
+            bool operator()( const BSONObj& l, const BSONObj& r ) const {
+                return l.woSortOrder( r, sortKey, true ) < 0;
+            }
+        };
+
+        // { a : <int, sometimes missing>, b : <int> } sorted by { a : 1, b : -1 } in each stream
+        static void makeStreams( int nStreams, int nDocs, Streams& streams ) {
+            streams.assign( nStreams, vector<BSONObj>() );
+            for ( int i = 0; i < nDocs; i++ ) {
+                BSONObjBuilder b;
+                if ( rand( 20 ) != 0 )
+                    b.append( "a", rand( nDocs / 4 + 1 ) );
+                b.append( "b", rand( 8 ) );
+                streams[ rand( nStreams ) ].push_back( b.obj() );
+            }
+            SortOrderLess less = { BSON( "a" << 1 << "b" << -1 ) };
+            for ( int i = 0; i < nStreams; i++ )
+                std::sort( streams[i].begin(), streams[i].end(), less );
+        }
+
+        // What ParallelSortClusteredCursor::next() used to do: look at every stream's head.
+        static void scanMerge( const Streams& streams, const BSONObj& sortKey, vector<BSONObj>& out ) {
+            vector<size_t> pos( streams.size(), 0 );
+            while ( true ) {
+                int bestFrom = -1;
+                for ( size_t i = 0; i < streams.size(); i++ ) {
+                    if ( pos[i] == streams[i].size() )
+                        continue;
+                    if ( bestFrom < 0 ||
+                         streams[bestFrom][pos[bestFrom]].woSortOrder( streams[i][pos[i]], sortKey, true ) >= 0 )
+                        bestFrom = i;
+                }
+                if ( bestFrom < 0 )
+                    return;
+                out.push_back( streams[bestFrom][pos[bestFrom]++] );
+            }
+        }
+
+        static void heapMerge( const Streams& streams, const BSONObj& sortKey, vector<BSONObj>& out ) {
+            vector<size_t> pos( streams.size(), 0 );
+            SortedMergeHeap merge( sortKey );
+            for ( size_t i = 0; i < streams.size(); i++ ) {
+                if ( ! streams[i].empty() )
+                    merge.push( i, streams[i][0] );
+            }
+            while ( ! merge.empty() ) {
+                int from = merge.top();
+                merge.pop();
+                out.push_back( streams[from][pos[from]++] );
+                if ( pos[from] < streams[from].size() )
+                    merge.push( from, streams[from][pos[from]] );
+            }
+        }
+
+        class HeapMergeMatchesScan {
+        public:
+            void run() {
+                BSONObj sortKey = BSON( "a" << 1 << "b" << -1 );
+                for ( int nStreams = 1; nStreams <= 64; nStreams *= 4 ) {
+                    Streams streams;
+                    makeStreams( nStreams, 2000, streams );
+                    vector<BSONObj> scanned, merged;
+                    scanMerge( streams, sortKey, scanned );
+                    heapMerge( streams, sortKey, merged );
+                    ASSERT_EQUALS( scanned.size(), merged.size() );
+                    for ( size_t i = 0; i < merged.size(); i++ ) {
+                        ASSERT_EQUALS( 0, scanned[i].woSortOrder( merged[i], sortKey, true ) );
+                        if ( i > 0 )
+                            ASSERT( merged[i - 1].woSortOrder( merged[i], sortKey, true ) <= 0 );
+                    }
+                }
+            }
+        };
+
+        class HeapMergeBenchmark {
+        public:
+            void run() {
+                BSONObj sortKey = BSON( "a" << 1 << "b" << -1 );
+                const int nDocs = 50000;
+                for ( int nStreams = 4; nStreams <= 256; nStreams *= 4 ) {
+                    Streams streams;
+                    makeStreams( nStreams, nDocs, streams );
+                    vector<BSONObj> out;
+                    out.reserve( nDocs );
+
+                    Timer scanTimer;
+                    scanMerge( streams, sortKey, out );
+                    long long scanMicros = scanTimer.micros();
+                    ASSERT_EQUALS( (size_t) nDocs, out.size() );
+
+                    out.clear();
+                    Timer heapTimer;
+                    heapMerge( streams, sortKey, out );
+                    long long heapMicros = heapTimer.micros();
+                    ASSERT_EQUALS( (size_t) nDocs, out.size() );
+
+                    log() << "merge of " << nDocs << " docs from " << nStreams << " shards: scan "
+                          << scanMicros / 1000 << "ms, heap " << heapMicros / 1000 << "ms" << endl;
+                }
+            }
+        };
+
+    }
+
     //
     // Sets up a basic environment for loading chunks to/from the direct database connection
     // Redirects connections to the direct database for the duration of the test.
@@ -633,6 +743,9 @@ namespace ShardingTests {
         }
 
         void setupTests() {
+            add< mergetests::HeapMergeMatchesScan >();
+            add< mergetests::HeapMergeBenchmark >();
+
             LOG(0) << "sharding tests disabled" << endl;
 #if 0
             add< serverandquerytests::test1 >();
@@ -23,6 +23,7 @@
 #include "mongo/client/distlock.h"
 #include "mongo/db/cmdline.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/namespacestring.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/config.h"
 #include "mongo/s/config_server_checker_service.h"
@@ -40,7 +41,7 @@ namespace mongo {
 
     Balancer balancer;
 
-    Balancer::Balancer() : _balancedLastTime(0), _policy( new BalancerPolicy() ) {}
+    Balancer::Balancer() : _balancedLastTime(0), _policy( new BalancerPolicy() ), _topMutex( "Balancer::top" ) {}
 
     Balancer::~Balancer() {
     }
@@ -183,7 +184,99 @@ namespace mongo {
         }        
     }
 
-    void Balancer::_doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks ) {
+    /**
+     * @param counts (OUT) the total count of operations on each collection, from the shard's top
+     */
+    static void getTopCounts( const Shard& s, map<string,long long>* counts ) {
+        BSONObj res = s.runCommand( "admin" , "top" , true );
+        BSONObjIterator i( res["totals"].Obj() );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            if ( e.type() != Object ) {
+                // the note
+                continue;
+            }
+            (*counts)[e.fieldName()] = e["total"]["count"].numberLong();
+        }
+    }
+
+    /**
+     * @return the storageSize of ns on the shard, 0 if it has none of it
+     */
+    static long long getStorageSize( const Shard& s, const string& ns ) {
+        scoped_ptr<ScopedDbConnection> conn(
+                ScopedDbConnection::getInternalScopedDbConnection( s.getConnString(), 30 ) );
+        BSONObj res;
+        bool ok = conn->get()->runCommand( nsToDatabase( ns ),
+                                           BSON( "collStats" << nsToCollectionSubstring( ns ).toString() ),
+                                           res );
+        conn->done();
+        return ok ? res["storageSize"].numberLong() : 0;
+    }
+
+    void Balancer::_sampleOps( const vector<Shard>& shards, map< string,map<string,double> >* opsPerSec ) {
+        map<string,TopSample> samples;
+        {
+            scoped_lock lk( _topMutex );
+            samples = _lastTop;
+        }
+
+        bool tookFirstSamples = false;
+        for ( vector<Shard>::const_iterator it = shards.begin(); it != shards.end(); ++it ) {
+            if ( samples.count( it->getName() ) )
+                continue;
+            try {
+                TopSample& first = samples[it->getName()];
+                first.millis = curTimeMillis64();
+                getTopCounts( *it, &first.counts );
+                tookFirstSamples = true;
+            }
+            catch ( const DBException& ex ) {
+                samples.erase( it->getName() );
+                warning() << "could not get operation counts of " << it->getName() << causedBy( ex ) << endl;
+            }
+        }
+        if ( tookFirstSamples )
+            sleepsecs( 1 );
+
+        for ( vector<Shard>::const_iterator it = shards.begin(); it != shards.end(); ++it ) {
+            map<string,TopSample>::const_iterator prev = samples.find( it->getName() );
+            if ( prev == samples.end() )
+                continue;
+
+            TopSample now;
+            try {
+                now.millis = curTimeMillis64();
+                getTopCounts( *it, &now.counts );
+            }
+            catch ( const DBException& ex ) {
+                warning() << "could not get operation counts of " << it->getName() << causedBy( ex ) << endl;
+                continue;
+            }
+
+            const double secs = std::max( now.millis - prev->second.millis, 1LL ) / 1000.0;
+            map<string,double>& rates = (*opsPerSec)[it->getName()];
+            for ( map<string,long long>::const_iterator i = now.counts.begin(); i != now.counts.end(); ++i ) {
+                map<string,long long>::const_iterator before = prev->second.counts.find( i->first );
+                long long ops = i->second;
+                if ( before != prev->second.counts.end() )
+                    ops -= before->second;
+                // counts start over when the shard restarts
+                if ( ops < 0 )
+                    ops = i->second;
+                rates[i->first] = ops / secs;
+            }
+
+            scoped_lock lk( _topMutex );
+            _lastTop[it->getName()] = now;
+        }
+    }
+
+    void Balancer::_doBalanceRound( DBClientBase& conn,
+                                    const LoadWeights* weights,
+                                    const string& onlyNs,
+                                    vector<CandidateChunkPtr>* candidateChunks,
+                                    BSONArrayBuilder* dryRunLoad ) {
         verify( candidateChunks );
 
         //
@@ -196,6 +289,9 @@ namespace mongo {
         while ( cursor->more() ) {
             BSONObj col = cursor->nextSafe();
 
+            if ( ! onlyNs.empty() && col[CollectionType::ns()].String() != onlyNs )
+                continue;
+
             // sharded collections will have a shard "key".
             if ( ! col[CollectionType::keyPattern()].eoo() &&
                  ! col[CollectionType::noBalance()].trueValue() ){
@@ -244,6 +340,11 @@ namespace mongo {
 
         OCCASIONALLY warnOnMultiVersion( shardInfo );
 
+        map< string,map<string,double> > opsPerSec;
+        if ( weights ) {
+            _sampleOps( allShards, &opsPerSec );
+        }
+
         //
         // 3. For each collection, check if the balancing policy recommends moving anything around.
         //
@@ -330,6 +431,10 @@ namespace mongo {
                 log() << "ns: " << ns << " need to split on "
                       << min << " because there is a range there" << endl;
 
+                if ( dryRunLoad ) {
+                    break;
+                }
+
                 ChunkPtr c = cm->findIntersectingChunk( min );
 
                 vector<BSONObj> splitPoints;
@@ -350,11 +455,79 @@ namespace mongo {
                 continue;
             }
 
-            CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime );
+            CandidateChunk* p = NULL;
+            if ( weights ) {
+                ShardLoadMap load;
+                for ( vector<Shard>::const_iterator i = allShards.begin(); i != allShards.end(); ++i ) {
+                    long long dataSize = 0;
+                    try {
+                        dataSize = getStorageSize( *i, ns );
+                    }
+                    catch ( const DBException& ex ) {
+                        warning() << "could not get size of " << ns << " on " << i->getName() << causedBy( ex ) << endl;
+                    }
+                    load[i->getName()] = ShardLoad( dataSize, opsPerSec[i->getName()][ns] );
+                }
+
+                if ( dryRunLoad ) {
+                    for ( ShardLoadMap::const_iterator i = load.begin(); i != load.end(); ++i ) {
+                        dryRunLoad->append( BSON( "ns" << ns <<
+                                                  "shard" << i->first <<
+                                                  "chunks" << status.numberOfChunksInShard( i->first ) <<
+                                                  "dataSize" << i->second.dataSize <<
+                                                  "opsPerSec" << i->second.opsPerSec <<
+                                                  "load" << BalancerPolicy::loadScore( i->first, status, load, *weights ) ) );
+                    }
+                }
+
+                p = BalancerPolicy::balanceByLoad( ns, status, load, *weights );
+            }
+            else {
+                p = _policy->balance( ns, status, _balancedLastTime );
+            }
             if ( p ) candidateChunks->push_back( CandidateChunkPtr( p ) );
         }
     }
 
+    void Balancer::dryRun( DBClientBase& conn, const string& ns, const BSONObj& load, BSONObjBuilder* result ) {
+        Shard::reloadShardInfo();
+
+        BSONObj weightsSpec = load;
+        if ( weightsSpec.isEmpty() ) {
+            BSONObj balancerConfig = conn.findOne( SettingsType::ConfigNS,
+                                                   BSON( SettingsType::key( "balancer" ) ) );
+            BSONElement e = balancerConfig[SettingsType::balancerLoad()];
+            if ( e.type() == Object )
+                weightsSpec = e.Obj();
+        }
+
+        scoped_ptr<LoadWeights> weights;
+        if ( ! weightsSpec.isEmpty() )
+            weights.reset( new LoadWeights( weightsSpec ) );
+
+        vector<CandidateChunkPtr> candidateChunks;
+        BSONArrayBuilder loadBuilder;
+        _doBalanceRound( conn, weights.get(), ns, &candidateChunks, &loadBuilder );
+
+        result->append( "mode", weights ? "load" : "chunks" );
+        if ( weights )
+            result->append( "weights", weights->toBSON() );
+
+        BSONArrayBuilder moves( result->subarrayStart( "moves" ) );
+        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks.begin(); it != candidateChunks.end(); ++it ) {
+            const CandidateChunk& chunkInfo = *it->get();
+            moves.append( BSON( "ns" << chunkInfo.ns <<
+                                "from" << chunkInfo.from <<
+                                "to" << chunkInfo.to <<
+                                "min" << chunkInfo.chunk.min <<
+                                "max" << chunkInfo.chunk.max ) );
+        }
+        moves.done();
+
+        if ( weights )
+            result->append( "load", loadBuilder.arr() );
+    }
+
     bool Balancer::_init() {
         try {
 
@@ -467,8 +640,21 @@ namespace mongo {
 
                     LOG(1) << "*** start balancing round" << endl;
 
+                    // balance by load when the settings give valid load weights
+                    scoped_ptr<LoadWeights> weights;
+                    BSONElement load = balancerConfig[SettingsType::balancerLoad()];
+                    if ( load.type() == Object ) {
+                        try {
+                            weights.reset( new LoadWeights( load.Obj() ) );
+                        }
+                        catch ( const DBException& ex ) {
+                            warning() << "invalid balancer load settings " << load
+                                      << ", balancing chunk counts this round" << causedBy( ex ) << endl;
+                        }
+                    }
+
                     vector<CandidateChunkPtr> candidateChunks;
-                    _doBalanceRound( conn.conn() , &candidateChunks );
+                    _doBalanceRound( conn.conn() , weights.get() , "" , &candidateChunks );
                     if ( candidateChunks.size() == 0 ) {
                         LOG(1) << "no need to move any chunk" << endl;
                         _balancedLastTime = 0;
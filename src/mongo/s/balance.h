@@ -27,6 +27,8 @@
 
 namespace mongo {
 
+    class Shard;
+
     /**
      * The balancer is a background task that tries to keep the number of chunks across all servers of the cluster even. Although
      * every mongos will have one balancer running, only one of them will be active at the any given point in time. The balancer
@@ -47,10 +49,28 @@ namespace mongo {
 
         virtual string name() const { return "Balancer"; }
 
+        /**
+         * Decides what a balancing round would move now, without moving anything or splitting
+         * chunks on tag boundaries (a collection that needs such a split gets no moves).
+         *
+         * @param conn is the connection with the config server(s)
+         * @param ns if not empty, the only collection to look at
+         * @param load the load weights to balance by, or empty to use the balancer settings
+         * @param result (OUT) gets the proposed moves and, when balancing by load, each
+         *        collection's load on each shard
+         */
+        void dryRun( DBClientBase& conn, const string& ns, const BSONObj& load, BSONObjBuilder* result );
+
     private:
         typedef MigrateInfo CandidateChunk;
         typedef shared_ptr<CandidateChunk> CandidateChunkPtr;
 
+        // a shard's top counts of operations on each collection, at a point in time
+        struct TopSample {
+            long long millis;
+            map<string,long long> counts;
+        };
+
         // hostname:port of my mongos
         string _myid;
 
@@ -62,6 +82,11 @@ namespace mongo {
 
         // decide which chunks to move; owned here.
         scoped_ptr<BalancerPolicy> _policy;
+
+        // last top sample of each shard, to turn counts into rates when balancing by load
+        // guarded by _topMutex, as dry runs take samples too
+        mongo::mutex _topMutex;
+        map<string,TopSample> _lastTop;
         
         /**
          * Checks that the balancer can connect to all servers it needs to do its job.
@@ -77,9 +102,26 @@ namespace mongo {
          * be moved.
          *
          * @param conn is the connection with the config server(s)
+         * @param weights if not NULL, balance by load with these weights rather than by chunk counts
+         * @param onlyNs if not empty, the only collection to balance
          * @param candidateChunks (IN/OUT) filled with candidate chunks, one per collection, that could possibly be moved
+         * @param dryRunLoad if not NULL, this is a dry run: no chunk is split, and the load of each
+         *        collection on each shard is appended here
+         */
+        void _doBalanceRound( DBClientBase& conn,
+                              const LoadWeights* weights,
+                              const string& onlyNs,
+                              vector<CandidateChunkPtr>* candidateChunks,
+                              BSONArrayBuilder* dryRunLoad = NULL );
+
+        /**
+         * Samples the top counters of all the shards. A shard without an earlier sample is
+         * sampled twice, a second apart.
+         *
+         * @param opsPerSec (OUT) for each shard, the rate of operations on each collection
+         *        since its previous sample
          */
-        void _doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks );
+        void _sampleOps( const vector<Shard>& shards, map< string,map<string,double> >* opsPerSec );
 
         /**
          * Issues chunk migration request, one at a time.
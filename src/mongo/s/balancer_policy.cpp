@@ -221,16 +221,13 @@ namespace mongo {
         }
         return false;
     }
-    MigrateInfo* BalancerPolicy::balance( const string& ns,
-                                          const DistributionStatus& distribution, 
-                                          int balancedLastTime ) {
-
+    MigrateInfo* BalancerPolicy::_balanceRequired( const string& ns,
+                                                   const DistributionStatus& distribution ) {
 
         // 1) check for shards that policy require to us to move off of:
         //    draining only
         // 2) check tag policy violations
-        // 3) then we make sure chunks are balanced for each tag
-        
+
         // ----
 
         // 1) check things we have to move
@@ -324,6 +321,20 @@ namespace mongo {
             }
         }
 
+        return NULL;
+    }
+
+    MigrateInfo* BalancerPolicy::balance( const string& ns,
+                                          const DistributionStatus& distribution, 
+                                          int balancedLastTime ) {
+
+        // 1) and 2) moves we have to make
+        // 3) then we make sure chunks are balanced for each tag
+
+        MigrateInfo* required = _balanceRequired( ns, distribution );
+        if ( required )
+            return required;
+
         // 3) for each tag balance
         
         int threshold = 8;
@@ -406,6 +417,282 @@ namespace mongo {
         return NULL;
     }
 
+    namespace {
+
+        /**
+         * A shard's weighted shares of a collection's chunks, data and operations,
+         * and the sum of the weights of the measures that aren't zero everywhere.
+         * The moved amounts are added to what the shard has, to weigh a migration.
+         */
+        struct WeightedShares {
+            double chunks;
+            double dataSize;
+            double ops;
+            double weight;
+
+            WeightedShares( const string& shard,
+                            const DistributionStatus& distribution,
+                            const ShardLoadMap& load,
+                            const LoadWeights& weights,
+                            double movedChunks = 0,
+                            double movedSize = 0,
+                            double movedOps = 0 )
+                : chunks( 0 ), dataSize( 0 ), ops( 0 ), weight( 0 ) {
+
+                long long totalSize = 0;
+                double totalOps = 0;
+                for ( ShardLoadMap::const_iterator i = load.begin(); i != load.end(); ++i ) {
+                    totalSize += i->second.dataSize;
+                    totalOps += i->second.opsPerSec;
+                }
+
+                ShardLoad mine;
+                ShardLoadMap::const_iterator i = load.find( shard );
+                if ( i != load.end() )
+                    mine = i->second;
+
+                const unsigned totalChunks = distribution.totalChunks();
+                if ( totalChunks > 0 ) {
+                    chunks = weights.chunks *
+                        ( distribution.numberOfChunksInShard( shard ) + movedChunks ) / totalChunks;
+                    weight += weights.chunks;
+                }
+                if ( totalSize > 0 ) {
+                    dataSize = weights.dataSize * ( mine.dataSize + movedSize ) / totalSize;
+                    weight += weights.dataSize;
+                }
+                if ( totalOps > 0 ) {
+                    ops = weights.ops * ( mine.opsPerSec + movedOps ) / totalOps;
+                    weight += weights.ops;
+                }
+            }
+
+            double score() const {
+                if ( weight <= 0 )
+                    return 0;
+                return ( chunks + dataSize + ops ) / weight;
+            }
+        };
+
+        /**
+         * The upper bound of the collection's top chunk, where increasing keys go.
+         */
+        BSONObj topChunkMax( const DistributionStatus& distribution ) {
+            BSONObj top;
+            const set<string>& shards = distribution.shards();
+            for ( set<string>::const_iterator i = shards.begin(); i != shards.end(); ++i ) {
+                const vector<BSONObj>& chunks = distribution.getChunks( *i );
+                for ( unsigned j = 0; j < chunks.size(); j++ ) {
+                    BSONObj max = chunks[j][ChunkType::max()].Obj();
+                    if ( top.isEmpty() || max.woCompare( top ) > 0 )
+                        top = max;
+                }
+            }
+            return top;
+        }
+
+    }
+
+    double BalancerPolicy::loadScore( const string& shard,
+                                      const DistributionStatus& distribution,
+                                      const ShardLoadMap& load,
+                                      const LoadWeights& weights ) {
+        return WeightedShares( shard, distribution, load, weights ).score();
+    }
+
+    MigrateInfo* BalancerPolicy::balanceByLoad( const string& ns,
+                                                const DistributionStatus& distribution,
+                                                const ShardLoadMap& load,
+                                                const LoadWeights& weights ) {
+
+        MigrateInfo* required = _balanceRequired( ns, distribution );
+        if ( required )
+            return required;
+
+        // randomize the order in which we balance the tags, as balance() does
+        vector<string> tags;
+        {
+            set<string> t = distribution.tags();
+            for ( set<string>::const_iterator i = t.begin(); i != t.end(); ++i )
+                tags.push_back( *i );
+            tags.push_back( "" );
+
+            std::random_shuffle( tags.begin(), tags.end() );
+        }
+
+        const set<string>& shards = distribution.shards();
+
+        for ( unsigned i=0; i<tags.size(); i++ ) {
+            string tag = tags[i];
+
+            string from;
+            string to;
+            double maxScore = -1;
+            double minScore = 2;
+
+            for ( set<string>::const_iterator z = shards.begin(); z != shards.end(); ++z ) {
+                const string& shard = *z;
+                const ShardInfo& info = distribution.shardInfo( shard );
+                const double score = loadScore( shard, distribution, load, weights );
+
+                if ( ! info.hasOpsQueued() &&
+                     distribution.numberOfChunksInShardWithTag( shard, tag ) > 0 &&
+                     score > maxScore ) {
+                    from = shard;
+                    maxScore = score;
+                }
+
+                if ( ! info.isSizeMaxed() && ! info.isDraining() && ! info.hasOpsQueued() &&
+                     info.hasTag( tag ) && score < minScore ) {
+                    to = shard;
+                    minScore = score;
+                }
+            }
+
+            if ( from.size() == 0 )
+                continue;
+
+            if ( to.size() == 0 ) {
+                log() << "no available shards to take chunks for tag [" << tag << "]" << endl;
+                return NULL;
+            }
+
+            if ( from == to )
+                continue;
+
+            const double imbalance = maxScore - minScore;
+
+            LOG(1) << "collection : " << ns << endl;
+            LOG(1) << "donor      : " << from << " load " << maxScore << endl;
+            LOG(1) << "receiver   : " << to << " load " << minScore << endl;
+            LOG(1) << "threshold  : " << weights.threshold << endl;
+
+            if ( imbalance <= weights.threshold )
+                continue;
+
+            const vector<BSONObj>& chunks = distribution.getChunks( from );
+
+            // operations are taken to go to the top chunk only when they are
+            // what loads the donor most and the donor holds that chunk
+            const WeightedShares shares( from, distribution, load, weights );
+            BSONObj top;
+            if ( shares.ops > shares.chunks && shares.ops > shares.dataSize ) {
+                const BSONObj topMax = topChunkMax( distribution );
+                for ( unsigned j = 0; j < chunks.size(); j++ ) {
+                    if ( chunks[j][ChunkType::max()].Obj().woCompare( topMax ) == 0 )
+                        top = topMax;
+                }
+            }
+            const bool busy = ! top.isEmpty();
+
+            ShardLoad donor;
+            ShardLoadMap::const_iterator l = load.find( from );
+            if ( l != load.end() )
+                donor = l->second;
+
+            const double chunkSize = static_cast<double>( donor.dataSize ) / chunks.size();
+            unsigned numJumboChunks = 0;
+            unsigned numTooLoaded = 0;
+            for ( unsigned j = 0; j < chunks.size(); j++ ) {
+                const BSONObj& chunk = busy ? chunks[chunks.size() - 1 - j] : chunks[j];
+
+                if ( distribution.getTagForChunk( chunk ) != tag )
+                    continue;
+
+                if ( _isJumbo( chunk ) ) {
+                    numJumboChunks++;
+                    continue;
+                }
+
+                double chunkOps = donor.opsPerSec / chunks.size();
+                if ( busy )
+                    chunkOps = chunk[ChunkType::max()].Obj().woCompare( top ) == 0 ? donor.opsPerSec : 0;
+
+                const double fromAfter =
+                    WeightedShares( from, distribution, load, weights,
+                                    -1, -chunkSize, -chunkOps ).score();
+                const double toAfter =
+                    WeightedShares( to, distribution, load, weights,
+                                    1, chunkSize, chunkOps ).score();
+                // the move has to narrow the gap, without the receiver overtaking the donor
+                if ( toAfter > fromAfter || fromAfter - toAfter >= imbalance ) {
+                    LOG(1) << "moving " << chunk << " would leave " << to << " with load "
+                           << toAfter << " and " << from << " with " << fromAfter << endl;
+                    numTooLoaded++;
+                    continue;
+                }
+
+                log() << " ns: " << ns << " going to move " << chunk
+                      << " from: " << from << " (load " << maxScore << ")"
+                      << " to: " << to << " (load " << minScore << ")"
+                      << " tag [" << tag << "]" << endl;
+                return new MigrateInfo( ns, to, from, chunk );
+            }
+
+            if ( numJumboChunks ) {
+                error() << "shard: " << from << "ns: " << ns
+                        << "has too much load, but its chunks are all jumbo or too loaded "
+                        << " numJumboChunks: " << numJumboChunks
+                        << " numTooLoaded: " << numTooLoaded
+                        << endl;
+            }
+        }
+
+        return NULL;
+    }
+
+    LoadWeights::LoadWeights()
+        : chunks( 1 ),
+          dataSize( 1 ),
+          ops( 1 ),
+          threshold( 0.1 ) {
+    }
+
+    LoadWeights::LoadWeights( const BSONObj& o )
+        : chunks( 1 ),
+          dataSize( 1 ),
+          ops( 1 ),
+          threshold( 0.1 ) {
+
+        BSONObjIterator i( o );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            const StringData name( e.fieldName() );
+            uassert( 17385,
+                     str::stream() << "balancer load " << name << " must be a number",
+                     e.isNumber() );
+            const double value = e.numberDouble();
+            if ( name == "threshold" ) {
+                uassert( 17391, "balancer load threshold must be in (0, 1]",
+                         value > 0 && value <= 1 );
+                threshold = value;
+                continue;
+            }
+
+            uassert( 17392,
+                     str::stream() << "balancer load " << name << " can't be negative",
+                     value >= 0 );
+            if ( name == "chunks" )
+                chunks = value;
+            else if ( name == "dataSize" )
+                dataSize = value;
+            else if ( name == "ops" )
+                ops = value;
+            else
+                uasserted( 17386, str::stream() << "unknown balancer load field " << name );
+        }
+
+        uassert( 17387, "balancer load weights can't all be zero",
+                 chunks > 0 || dataSize > 0 || ops > 0 );
+    }
+
+    BSONObj LoadWeights::toBSON() const {
+        return BSON( "chunks" << chunks <<
+                     "dataSize" << dataSize <<
+                     "ops" << ops <<
+                     "threshold" << threshold );
+    }
+
 
     ShardInfo::ShardInfo( long long maxSize, long long currSize,
                           bool draining, bool opsQueued,
@@ -116,6 +116,44 @@ namespace mongo {
     typedef map< string,ShardInfo > ShardInfoMap;
     typedef map< string,vector<BSONObj> > ShardToChunksMap;
 
+    /**
+     * How big and how busy a collection is on one shard, for the load-aware
+     * balancer. dataSize is the storageSize from collStats, opsPerSec the rate
+     * at which the shard's top counters for the collection grew since the last
+     * sample.
+     */
+    struct ShardLoad {
+        long long dataSize;
+        double opsPerSec;
+
+        ShardLoad() : dataSize( 0 ), opsPerSec( 0 ) {}
+        ShardLoad( long long a_dataSize, double a_opsPerSec )
+            : dataSize( a_dataSize ), opsPerSec( a_opsPerSec ) {}
+    };
+
+    typedef map< string,ShardLoad > ShardLoadMap;
+
+    /**
+     * How much the chunk count, the data size and the operation rate each count in
+     * a shard's load, and how far apart the most and least loaded shards may be,
+     * as a share of the collection's load. Given by the "load" field of the
+     * balancer settings, e.g. { chunks: 1, dataSize: 1, ops: 2, threshold: 0.1 }.
+     */
+    struct LoadWeights {
+        double chunks;
+        double dataSize;
+        double ops;
+        double threshold;
+
+        /** all weights 1, threshold 0.1 */
+        LoadWeights();
+
+        /** fields not in o keep their defaults, uasserts if o is not valid */
+        explicit LoadWeights( const BSONObj& o );
+
+        BSONObj toBSON() const;
+    };
+
     class DistributionStatus : boost::noncopyable {
     public:
         DistributionStatus( const ShardInfoMap& shardInfo,
@@ -198,8 +236,45 @@ namespace mongo {
                                      const DistributionStatus& distribution,
                                      int balancedLastTime );
 
+        /**
+         * Like balance(), but once no chunk has to move off a draining shard or a shard
+         * with the wrong tag, evens out the load of the collection rather than its chunk
+         * counts. A chunk moves from the most to the least loaded shard when their load
+         * differs by more than the threshold, and only if that narrows the difference
+         * without the receiver ending up with more load than the donor is left with,
+         * so that it can't move back.
+         *
+         * Op rates aren't known per chunk. When operations are what loads the donor
+         * most and it holds the collection's top chunk, where increasing keys go, that
+         * chunk is taken to get all of them and the others none; otherwise each chunk is
+         * taken to get an even share. The chunks are tried from the last or the first
+         * accordingly.
+         *
+         * @param load holds the load of the collection on each shard
+         */
+        static MigrateInfo* balanceByLoad( const string& ns,
+                                           const DistributionStatus& distribution,
+                                           const ShardLoadMap& load,
+                                           const LoadWeights& weights );
+
+        /**
+         * @return the share of the collection's load that is on shard, between 0 and 1:
+         *         the weighted mean of its shares of chunks, data and operations, leaving
+         *         out any measure that is zero on every shard
+         */
+        static double loadScore( const string& shard,
+                                 const DistributionStatus& distribution,
+                                 const ShardLoadMap& load,
+                                 const LoadWeights& weights );
+
     private:
         static bool _isJumbo( const BSONObj& chunk );
+
+        /**
+         * @return the move needed to drain a shard or fix a tag violation, or NULL
+         */
+        static MigrateInfo* _balanceRequired( const string& ns,
+                                              const DistributionStatus& distribution );
     };
 
 
@@ -381,6 +381,154 @@ namespace mongo {
             ASSERT( !m );
         }
 
+        TEST( BalancerPolicyTests, LoadWeightsParse ) {
+            LoadWeights defaults;
+            ASSERT_EQUALS( 1.0, defaults.chunks );
+            ASSERT_EQUALS( 0.1, defaults.threshold );
+
+            LoadWeights w( BSON( "ops" << 2 << "dataSize" << 0 << "threshold" << 0.25 ) );
+            ASSERT_EQUALS( 1.0, w.chunks );
+            ASSERT_EQUALS( 0.0, w.dataSize );
+            ASSERT_EQUALS( 2.0, w.ops );
+            ASSERT_EQUALS( 0.25, w.threshold );
+
+            ASSERT_THROWS( LoadWeights( BSON( "ops" << -1 ) ), UserException );
+            ASSERT_THROWS( LoadWeights( BSON( "ops" << "a lot" ) ), UserException );
+            ASSERT_THROWS( LoadWeights( BSON( "threshold" << 2 ) ), UserException );
+            ASSERT_THROWS( LoadWeights( BSON( "opz" << 1 ) ), UserException );
+            ASSERT_THROWS( LoadWeights( BSON( "chunks" << 0 << "dataSize" << 0 << "ops" << 0 ) ),
+                           UserException );
+        }
+
+        /**
+         * Chunk counts are even, but all operations go to shard0. It doesn't hold the top
+         * chunk, where increasing keys go, so each of its chunks is taken to get an even
+         * share of them, and its first chunk moves. Operations count twice here.
+         */
+        TEST( BalancerPolicyTests, LoadHotShard ) {
+            ShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+
+            ShardLoadMap load;
+            load["shard0"] = ShardLoad( 100, 1000 );
+            load["shard1"] = ShardLoad( 100, 0 );
+
+            DistributionStatus d( shards, chunks );
+            ASSERT( ! BalancerPolicy::balance( "ns", d, 0 ) );
+
+            LoadWeights w( BSON( "ops" << 2 ) );
+            ASSERT_EQUALS( 1.0, BalancerPolicy::loadScore( "shard0", d, load, w ) +
+                                BalancerPolicy::loadScore( "shard1", d, load, w ) );
+
+            MigrateInfo* m = BalancerPolicy::balanceByLoad( "ns", d, load, w );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard0" , m->from );
+            ASSERT_EQUALS( "shard1" , m->to );
+            ASSERT_EQUALS( BSON( "x" << BSON( "$minKey" << 1 ) ) , m->chunk.min );
+            delete m;
+
+            // without operations, the chunks and data are even
+            load["shard0"] = ShardLoad( 100, 0 );
+            ASSERT( ! BalancerPolicy::balanceByLoad( "ns", d, load, w ) );
+        }
+
+        /**
+         * shard0 holds most of the data. A chunk moves only while moving it can't leave
+         * shard1 with more load than shard0.
+         */
+        TEST( BalancerPolicyTests, LoadDataSize ) {
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 0, false, false );
+            shards["shard1"] = ShardInfo( 0, 0, false, false );
+
+            ShardLoadMap load;
+            load["shard0"] = ShardLoad( 900, 0 );
+            load["shard1"] = ShardLoad( 100, 0 );
+
+            {
+                ShardToChunksMap chunks;
+                addShard( chunks, 2 , false );
+                addShard( chunks, 2 , true );
+                DistributionStatus d( shards, chunks );
+                ASSERT( ! BalancerPolicy::balanceByLoad( "ns", d, load, LoadWeights() ) );
+            }
+
+            {
+                ShardToChunksMap chunks;
+                addShard( chunks, 4 , false );
+                addShard( chunks, 4 , true );
+                DistributionStatus d( shards, chunks );
+                MigrateInfo* m = BalancerPolicy::balanceByLoad( "ns", d, load, LoadWeights() );
+                ASSERT( m );
+                ASSERT_EQUALS( "shard0" , m->from );
+                ASSERT_EQUALS( "shard1" , m->to );
+                ASSERT_EQUALS( BSON( "x" << BSON( "$minKey" << 1 ) ) , m->chunk.min );
+                delete m;
+            }
+        }
+
+        /**
+         * All operations go to shard1, which holds the top chunk. Moving that chunk would
+         * make shard0 the loaded one, and the chunk would move back in the next round, so
+         * it stays and colder chunks move instead, in the same direction in each round.
+         */
+        TEST( BalancerPolicyTests, LoadNoPingPong ) {
+            ShardToChunksMap chunks;
+            addShard( chunks, 4 , false );
+            addShard( chunks, 4 , true );
+            const BSONObj hot = chunks["shard1"].back().getField( ChunkType::min() ).Obj();
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 4, false, false );
+            shards["shard1"] = ShardInfo( 0, 4, false, false );
+
+            ShardLoadMap load;
+            load["shard0"] = ShardLoad( 100, 0 );
+            load["shard1"] = ShardLoad( 100, 1000 );
+
+            LoadWeights w( BSON( "dataSize" << 0 << "ops" << 2 ) );
+            for ( int round = 0; round < 2; round++ ) {
+                DistributionStatus d( shards, chunks );
+                MigrateInfo* m = BalancerPolicy::balanceByLoad( "ns", d, load, w );
+                ASSERT( m );
+                ASSERT_EQUALS( "shard1" , m->from );
+                ASSERT_NOT_EQUALS( hot , m->chunk.min );
+                moveChunk( chunks, m );
+                delete m;
+            }
+            ASSERT_EQUALS( 2U , chunks["shard1"].size() );
+
+            // When only operations count, moving a cold chunk doesn't narrow the gap.
+            DistributionStatus d( shards, chunks );
+            LoadWeights opsOnly( BSON( "chunks" << 0 << "dataSize" << 0 << "ops" << 1 ) );
+            ASSERT( ! BalancerPolicy::balanceByLoad( "ns", d, load, opsOnly ) );
+        }
+
+        TEST( BalancerPolicyTests, LoadDraining ) {
+            ShardToChunksMap chunks;
+            addShard( chunks, 2 , false );
+            addShard( chunks, 2 , true );
+
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 2, false, false );
+            shards["shard1"] = ShardInfo( 0, 2, true, false );
+
+            ShardLoadMap load;
+            load["shard0"] = ShardLoad( 1000, 1000 );
+
+            DistributionStatus d( shards, chunks );
+            MigrateInfo* m = BalancerPolicy::balanceByLoad( "ns", d, load, LoadWeights() );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard1" , m->from );
+            ASSERT_EQUALS( "shard0" , m->to );
+            delete m;
+        }
+
         // Note: Only in 2.2, 2.4 has utility class
         class PseudoRandom {
         public:
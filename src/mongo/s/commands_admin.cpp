@@ -29,6 +29,7 @@
 #include "mongo/db/namespacestring.h"
 #include "mongo/db/stats/counters.h"
 
+#include "mongo/s/balance.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/config.h"
@@ -1093,6 +1094,52 @@ namespace mongo {
             }
         } moveChunkCmd;
 
+        class BalancerDryRunCmd : public GridAdminCmd {
+        public:
+            BalancerDryRunCmd() : GridAdminCmd( "balancerDryRun" ) {}
+            virtual void help( stringstream& help ) const {
+                help << "shows the chunk moves the balancer would make now, without making them\n"
+                     << "{ balancerDryRun : 1 [, ns : 'db.coll'] [, load : { chunks : 1, dataSize : 1, ops : 1, threshold : 0.1 }] }\n"
+                     << "load balances by load with the given weights instead of those of the balancer settings";
+            }
+            virtual void addRequiredPrivileges(const std::string& dbname,
+                                               const BSONObj& cmdObj,
+                                               std::vector<Privilege>* out) {
+                ActionSet actions;
+                actions.addAction(ActionType::moveChunk);
+                out->push_back(Privilege(AuthorizationManager::CLUSTER_RESOURCE_NAME, actions));
+            }
+            bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+                string ns;
+                BSONElement nsElt = cmdObj["ns"];
+                if ( ! nsElt.eoo() ) {
+                    if ( nsElt.type() != String ) {
+                        errmsg = "ns must be a string";
+                        return false;
+                    }
+                    ns = nsElt.String();
+                }
+
+                BSONObj load;
+                BSONElement loadElt = cmdObj["load"];
+                if ( ! loadElt.eoo() ) {
+                    if ( loadElt.type() != Object ) {
+                        errmsg = "load must be an object";
+                        return false;
+                    }
+                    load = loadElt.Obj();
+                }
+
+                scoped_ptr<ScopedDbConnection> conn(
+                        ScopedDbConnection::getInternalScopedDbConnection(
+                                configServer.getPrimary().getConnString(), 30));
+                balancer.dryRun( conn->conn(), ns, load, &result );
+                conn->done();
+
+                return true;
+            }
+        } balancerDryRunCmd;
+
         // ------------ server level commands -------------
 
         class ListShardsCmd : public GridAdminCmd {
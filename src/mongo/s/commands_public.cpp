@@ -1013,6 +1013,11 @@ namespace mongo {
             ShowPendingLockRequestsCmd() : NotAllowedOnShardedClusterCmd("showPendingLockRequests") {}
         } showPendingLockRequestsCmd;
 
+        class ShowLockContentionCmd : public NotAllowedOnShardedClusterCmd  {
+        public:
+            ShowLockContentionCmd() : NotAllowedOnShardedClusterCmd("showLockContention") {}
+        } showLockContentionCmd;
+
         class GroupCmd : public NotAllowedOnShardedCollectionCmd  {
         public:
             GroupCmd() : NotAllowedOnShardedCollectionCmd("group") {}
@@ -29,7 +29,9 @@
 
 namespace mongo {
 
+    class Collection;
     class Database;
+    class IndexDetails;
     //class DiskLoc;
     struct DbResponse;
 
@@ -360,4 +362,12 @@ namespace mongo {
     void writeObjToMigrateLog(BSONObj &obj);
     void writeObjToMigrateLogRef(BSONObj &obj);
 
+    /**
+     * Estimates keys splitting the whole of idx, which must be clustering, into pieces
+     * of about maxChunkSize bytes, the way splitVector does.  No more than maxSplitPoints
+     * are found unless it is 0.
+     */
+    void findSplitPoints(Collection *cl, const IndexDetails &idx, long long maxChunkSize,
+                         long long maxSplitPoints, vector<BSONObj> &splitPoints);
+
 }
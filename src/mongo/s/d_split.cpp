@@ -385,6 +385,16 @@ namespace mongo {
         }
     };
 
+    void findSplitPoints(Collection *cl, const IndexDetails &idx, long long maxChunkSize,
+                         long long maxSplitPoints, vector<BSONObj> &splitPoints) {
+        verify(idx.clustering());
+        KeyPattern kp(idx.keyPattern());
+        const BSONObj min = KeyPattern::toKeyFormat(kp.extendRangeBound(BSONObj(), false));
+        const BSONObj max = KeyPattern::toKeyFormat(kp.extendRangeBound(BSONObj(), true));
+        SplitVectorFinder finder(cl, &idx, idx.keyPattern(), min, max, splitPoints);
+        finder.find(maxChunkSize, maxSplitPoints);
+    }
+
     class SplitVector : public QueryCommand {
     public:
         SplitVector() : QueryCommand("splitVector") {}
@@ -113,7 +113,8 @@ namespace mongo {
                 r.process();
 
                 // Release connections after non-write op 
-                if ( ShardConnection::releaseConnectionsAfterResponse && r.expectResponse() ) {
+                if ( ( ShardConnection::releaseConnectionsAfterResponse ||
+                       ShardConnection::sharesConnections() ) && r.expectResponse() ) {
                     LOG(2) << "release thread local connections back to pool" << endl;
                     ShardConnection::releaseMyConnections();
                 }
@@ -301,6 +301,12 @@ namespace mongo {
         // Whether or not we release connections from the thread-local cache after a read
         static bool releaseConnectionsAfterResponse;
 
+        /**
+         * Whether client threads share a limited set of connections to each shard (see the
+         * shardConnectionsPerHost parameter), so must release them after every read.
+         */
+        static bool sharesConnections();
+
         // Controls whether we throw on initially failing to set a version
         static bool ignoreInitialVersionFailure;
 
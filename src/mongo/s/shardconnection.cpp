@@ -77,6 +77,85 @@ namespace mongo {
 
     } activeClientConnections;
 
+    // When positive, client threads share at most this many connections to each shard: a
+    // connection goes back to the pool after each response, and a thread that needs one
+    // while all are out waits for one to come back.
+    MONGO_EXPORT_SERVER_PARAMETER(shardConnectionsPerHost, int, 0);
+
+    // How long a thread waits for a shared connection before opening one over the limit,
+    // so a client holding connections between a write and its getLastError can't stall
+    // the others indefinitely.
+    MONGO_EXPORT_SERVER_PARAMETER(shardConnectionWaitMillis, int, 1000);
+
+    /**
+     * Counts the shard connections handed out to client threads, per host, and enforces
+     * shardConnectionsPerHost.
+     */
+    class ShardConnectionLimiter {
+    public:
+        ShardConnectionLimiter() : _mutex( "ShardConnectionLimiter" ) {}
+
+        /** Wait, if need be, until a connection to addr can be handed out, and count it. */
+        void acquire( const string& addr ) {
+            scoped_lock lk( _mutex );
+            Host& h = _hosts[addr];
+
+            const int limit = shardConnectionsPerHost;
+            if ( limit > 0 && h.inUse >= limit ) {
+                h.waits++;
+                const boost::system_time deadline = boost::get_system_time() +
+                        boost::posix_time::milliseconds( shardConnectionWaitMillis );
+                while ( h.inUse >= shardConnectionsPerHost ) {
+                    if ( ! _returned.timed_wait( lk.boost() , deadline ) ) {
+                        h.overflows++;
+                        break;
+                    }
+                }
+            }
+            h.inUse++;
+        }
+
+        /** A connection to addr went back to the shared pool or was closed. */
+        void release( const string& addr ) {
+            scoped_lock lk( _mutex );
+            Host& h = _hosts[addr];
+            verify( h.inUse > 0 );
+            h.inUse--;
+            _returned.notify_all();
+        }
+
+        void appendInfo( BSONObjBuilder& b ) {
+            BSONObjBuilder lb( b.subobjStart( "limits" ) );
+            lb.append( "perHost" , shardConnectionsPerHost );
+            BSONObjBuilder hb( lb.subobjStart( "hosts" ) );
+            {
+                scoped_lock lk( _mutex );
+                for ( HostMap::const_iterator i = _hosts.begin(); i != _hosts.end(); ++i ) {
+                    BSONObjBuilder bb( hb.subobjStart( i->first ) );
+                    bb.append( "inUse" , i->second.inUse );
+                    bb.appendNumber( "waits" , i->second.waits );
+                    bb.appendNumber( "overflows" , i->second.overflows );
+                    bb.done();
+                }
+            }
+            hb.done();
+            lb.done();
+        }
+
+    private:
+        struct Host {
+            Host() : inUse(0), waits(0), overflows(0) {}
+            int inUse;
+            long long waits;
+            long long overflows; // gave up waiting and went over the limit
+        };
+        typedef map<string,Host,DBConnectionPool::serverNameCompare> HostMap;
+
+        mongo::mutex _mutex;
+        boost::condition _returned;
+        HostMap _hosts;
+    } shardConnectionLimiter;
+
     /**
      * Command to allow access to the sharded conn pool information in mongos.
      * TODO: Refactor with other connection pooling changes
@@ -94,6 +173,7 @@ namespace mongo {
             shardConnectionPool.appendInfo( result );
             // Thread connection info
             activeClientConnections.appendInfo( result );
+            shardConnectionLimiter.appendInfo( result );
             return true;
         }
     } shardedPoolStatsCmd;
@@ -148,8 +228,7 @@ namespace mongo {
                     /* if we're shutting down, don't want to initiate release mechanism as it is slow,
                        and isn't needed since all connections will be closed anyway */
                     if ( inShutdown() ) {
-                        if( versionManager.isVersionableCB( ss->avail ) ) versionManager.resetShardVersionCB( ss->avail );
-                        delete ss->avail;
+                        discard( addr , ss->avail );
                     }
                     else
                         release( addr , ss->avail );
@@ -167,11 +246,18 @@ namespace mongo {
 
             auto_ptr<DBClientBase> c; // Handles cleanup if there's an exception thrown
             if ( s->avail ) {
-                c.reset( s->avail );
+                DBClientBase* avail = s->avail;
                 s->avail = 0;
-                shardConnectionPool.onHandedOut( c.get() ); // May throw an exception
+                try {
+                    shardConnectionPool.onHandedOut( avail ); // May throw an exception
+                }
+                catch ( std::exception& ) {
+                    discard( addr , avail );
+                    throw;
+                }
+                c.reset( avail );
             } else {
-                c.reset( shardConnectionPool.get( addr ) );
+                c.reset( _getShared( addr ) );
                 s->created++; // After, so failed creation doesn't get counted
             }
             return c.release();
@@ -194,7 +280,7 @@ namespace mongo {
                 }
 
                 if (!isConnGood) {
-                    delete s->avail;
+                    discard( addr , s->avail );
                     s->avail = NULL;
                 }
 
@@ -249,7 +335,7 @@ namespace mongo {
                     Status* s = _getStatus( sconnString );
 
                     if( ! s->avail ) {
-                        s->avail = shardConnectionPool.get( sconnString );
+                        s->avail = _getShared( sconnString );
                         s->created++; // After, so failed creation doesn't get counted
                     }
 
@@ -273,6 +359,25 @@ namespace mongo {
 
         void release( const string& addr , DBClientBase * conn ) {
             shardConnectionPool.release( addr , conn );
+            shardConnectionLimiter.release( addr );
+        }
+
+        /** Close a connection instead of returning it to the pool. */
+        void discard( const string& addr , DBClientBase * conn ) {
+            if( versionManager.isVersionableCB( conn ) ) versionManager.resetShardVersionCB( conn );
+            delete conn;
+            shardConnectionLimiter.release( addr );
+        }
+
+        DBClientBase* _getShared( const string& addr ) {
+            shardConnectionLimiter.acquire( addr );
+            try {
+                return shardConnectionPool.get( addr );
+            }
+            catch ( std::exception& ) {
+                shardConnectionLimiter.release( addr );
+                throw;
+            }
         }
 
         void _check( const string& ns ) {
@@ -327,7 +432,7 @@ namespace mongo {
         void clearPool() {
             for(HostMap::iterator iter = _hosts.begin(); iter != _hosts.end(); ++iter) {
                 if (iter->second->avail != NULL) {
-                    delete iter->second->avail;
+                    discard( iter->first , iter->second->avail );
                 }
             }
 
@@ -428,8 +533,7 @@ namespace mongo {
 
     void ShardConnection::kill() {
         if ( _conn ) {
-            if( versionManager.isVersionableCB( _conn ) ) versionManager.resetShardVersionCB( _conn );
-            delete _conn;
+            ClientConnections::threadInstance()->discard( _addr , _conn );
             _conn = 0;
             _finishedInit = true;
         }
@@ -488,6 +592,10 @@ namespace mongo {
         true
     );
 
+    bool ShardConnection::sharesConnections() {
+        return shardConnectionsPerHost > 0;
+    }
+
     void ShardConnection::releaseMyConnections() {
         ClientConnections::threadInstance()->releaseAll();
     }
@@ -31,6 +31,7 @@ namespace mongo {
     const BSONField<BSONObj> SettingsType::balancerActiveWindow("activeWindow");
     const BSONField<bool> SettingsType::shortBalancerSleep("_nosleep");
     const BSONField<bool> SettingsType::secondaryThrottle("_secondaryThrottle");
+    const BSONField<BSONObj> SettingsType::balancerLoad("load");
 
     SettingsType::SettingsType() {
         clear();
@@ -103,6 +104,7 @@ namespace mongo {
         }
         if (_isShortBalancerSleepSet) builder.append(shortBalancerSleep(), _shortBalancerSleep);
         if (_isSecondaryThrottleSet) builder.append(secondaryThrottle(), _secondaryThrottle);
+        if (_isBalancerLoadSet) builder.append(balancerLoad(), _balancerLoad);
 
         return builder.obj();
     }
@@ -139,6 +141,10 @@ namespace mongo {
         if (fieldState == FieldParser::FIELD_INVALID) return false;
         _isSecondaryThrottleSet = fieldState == FieldParser::FIELD_SET;
 
+        fieldState = FieldParser::extract(source, balancerLoad, &_balancerLoad, errMsg);
+        if (fieldState == FieldParser::FIELD_INVALID) return false;
+        _isBalancerLoadSet = fieldState == FieldParser::FIELD_SET;
+
         return true;
     }
 
@@ -162,6 +168,9 @@ namespace mongo {
         _secondaryThrottle = false;
         _isSecondaryThrottleSet = false;
 
+        _balancerLoad = BSONObj();
+        _isBalancerLoadSet = false;
+
     }
 
     void SettingsType::cloneTo(SettingsType* other) const {
@@ -185,6 +194,9 @@ namespace mongo {
         other->_secondaryThrottle = _secondaryThrottle;
         other->_isSecondaryThrottleSet = _isSecondaryThrottleSet;
 
+        other->_balancerLoad = _balancerLoad;
+        other->_isBalancerLoadSet = _isBalancerLoadSet;
+
     }
 
     std::string SettingsType::toString() const {
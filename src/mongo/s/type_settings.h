@@ -63,6 +63,7 @@ namespace mongo {
         static const BSONField<BSONObj> balancerActiveWindow;
         static const BSONField<bool> shortBalancerSleep;
         static const BSONField<bool> secondaryThrottle;
+        static const BSONField<BSONObj> balancerLoad;
 
         //
         // settings type methods
@@ -229,6 +230,27 @@ namespace mongo {
                 return secondaryThrottle.getDefault();
             }
         }
+        void setBalancerLoad(BSONObj& balancerLoad) {
+            _balancerLoad = balancerLoad.getOwned();
+            _isBalancerLoadSet = true;
+        }
+
+        void unsetBalancerLoad() { _isBalancerLoadSet = false; }
+
+        bool isBalancerLoadSet() const {
+            return _isBalancerLoadSet || balancerLoad.hasDefault();
+        }
+
+        // Calling get*() methods when the member is not set and has no default results in undefined
+        // behavior
+        BSONObj getBalancerLoad() const {
+            if (_isBalancerLoadSet) {
+                return _balancerLoad;
+            } else {
+                dassert(balancerLoad.hasDefault());
+                return balancerLoad.getDefault();
+            }
+        }
 
     private:
         // Convention: (M)andatory, (O)ptional, (S)pecial rule.
@@ -252,6 +274,11 @@ namespace mongo {
 
         bool _secondaryThrottle;         // (O)  only migrate chunks as fast as at least
         bool _isSecondaryThrottleSet;    // one secondary can keep up with
+
+        BSONObj _balancerLoad;           // (O)  if present, the balancer evens out load
+        bool _isBalancerLoadSet;         // rather than chunk counts, see LoadWeights.
+                                         // Format: { chunks: 1, dataSize: 1, ops: 1,
+                                         // threshold: 0.1 }
     };
 
 } // namespace mongo
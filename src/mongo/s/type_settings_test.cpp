@@ -83,7 +83,8 @@ namespace {
                            SettingsType::balancerActiveWindow(BSON("start" << "23:00" <<
                                                                    "stop" << "6:00" )) <<
                            SettingsType::shortBalancerSleep(true) <<
-                           SettingsType::secondaryThrottle(true));
+                           SettingsType::secondaryThrottle(true) <<
+                           SettingsType::balancerLoad(BSON("ops" << 2)));
         ASSERT(settings.parseBSON(objBalancer, &errMsg));
         ASSERT_EQUALS(errMsg, "");
         ASSERT_TRUE(settings.isValid(NULL));
@@ -93,6 +94,7 @@ namespace {
                                                                "stop" << "6:00" ));
         ASSERT_EQUALS(settings.getShortBalancerSleep(), true);
         ASSERT_EQUALS(settings.getSecondaryThrottle(), true);
+        ASSERT_EQUALS(settings.getBalancerLoad(), BSON("ops" << 2));
     }
 
     TEST(Validity, BadType) {
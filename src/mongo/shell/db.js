@@ -1041,6 +1041,14 @@ DB.prototype.showPendingLockRequests = function(){
     return this._runCommandCursor('showPendingLockRequests');
 }
 
+DB.prototype.showLockContention = function( options ){
+    var cmd = { showLockContention : 1 };
+    if ( options ) {
+        Object.extend( cmd , options );
+    }
+    return this._adminCommand( cmd );
+}
+
 DB.prototype.serverBuildInfo = function(){
     return this._adminCommand( "buildinfo" );
 }
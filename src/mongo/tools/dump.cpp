@@ -22,13 +22,18 @@
 #include <fcntl.h>
 #include <map>
 #include <fstream>
+#include <iomanip>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "mongo/base/initializer.h"
+#include "mongo/client/dbclient_rs.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/tools/tool.h"
 
 using namespace mongo;
@@ -44,14 +49,34 @@ class Dump : public Tool {
     private:
         FILE* _f;
     };
+
+    // The ranges of one collection being dumped by writeCollectionRanges()
+    struct RangeDump {
+        RangeDump(const string& theColl, const BSONObj& thePK, const vector<BSONObj>& theSplits,
+                  const boost::filesystem::path& theDir)
+            : coll(theColl), pk(thePK), splits(theSplits), dir(theDir) {}
+
+        const string coll;
+        const BSONObj pk;
+        const vector<BSONObj>& splits; // range i is [splits[i-1], splits[i])
+        const boost::filesystem::path dir;
+        AtomicUInt32 nextRange;
+        AtomicUInt64 objects;
+        AtomicUInt32 failed;
+    };
+
 public:
-    Dump() : Tool( "dump" , ALL , "" , "" , true ) {
+    Dump() : Tool( "dump" , ALL , "" , "" , true ), _numParallelRanges(1), _minRangeBytes(0) {
         add_options()
         ("out,o", po::value<string>()->default_value("dump"), "output directory or \"-\" for stdout")
         ("query,q", po::value<string>() , "json query" )
         ("oplog", "Use oplog for point-in-time snapshotting" )
         ("repair", "try to recover a crashed database" )
         ("forceTableScan", "deprecated" )
+        ("numParallelRanges,j", po::value<int>()->default_value(1), "dump large collections as ranges of their primary key over this many connections at once. Each range is read in its own snapshot, so without --oplog the ranges are not consistent with each other." )
+        ;
+        add_hidden_options()
+        ("minRangeSizeMB", po::value<int>()->default_value(64), "smallest range to split collections into with --numParallelRanges")
         ;
     }
 
@@ -70,7 +95,8 @@ public:
 
     // This is a functor that writes a BSONObj to a file
     struct Writer {
-        Writer(FILE* out, ProgressMeter* m) :_out(out), _m(m) {}
+        Writer(FILE* out, ProgressMeter* m, AtomicUInt64* count = NULL)
+            :_out(out), _m(m), _count(count) {}
 
         void operator () (const BSONObj& obj) {
             size_t toWrite = obj.objsize();
@@ -87,22 +113,26 @@ public:
             if (_m) {
                 _m->hit();
             }
+            if (_count) {
+                _count->fetchAndAdd(1);
+            }
         }
 
         FILE* _out;
         ProgressMeter* _m;
+        AtomicUInt64* _count;
     };
 
     void doCollection( const string coll , FILE* out , ProgressMeter *m ) {
-        Query q = _query;
+        doCollection( conn(true) , coll , _query , out , Writer(out, m) );
+    }
 
+    void doCollection( DBClientBase& connBase , const string coll , const Query& q , FILE* out ,
+                       const Writer& writer ) {
         int queryOptions = QueryOption_SlaveOk | QueryOption_NoCursorTimeout;
         if (startsWith(coll.c_str(), "local.oplog.")) {
             queryOptions |= QueryOption_OplogReplay;
         }
-        
-        DBClientBase& connBase = conn(true);
-        Writer writer(out, m);
 
         // use low-latency "exhaust" mode if going over the network
         if (!_usingMongos && typeid(connBase) == typeid(DBClientConnection&)) {
@@ -113,12 +143,134 @@ public:
         else {
             //This branch should only be taken with DBDirectClient or mongos which doesn't support exhaust mode
             scoped_ptr<DBClientCursor> cursor(connBase.query( coll.c_str() , q , 0 , 0 , 0 , queryOptions ));
+            Writer w(writer);
             while ( cursor->more() ) {
-                writer(cursor->next());
+                w(cursor->next());
             }
         }
     }
 
+    // Ask the server to split coll into ranges of about rangeBytes each, by estimating key
+    // positions in the primary key.  Returns no split points if it can't.
+    vector<BSONObj> splitCollection( const string& coll , const BSONObj& pk , long long rangeBytes ) {
+        vector<BSONObj> splits;
+        BSONObj res;
+        BSONObjBuilder cmd;
+        cmd.append( "splitVector" , coll );
+        cmd.append( "keyPattern" , pk );
+        cmd.append( "maxChunkSizeBytes" , rangeBytes );
+        if ( !conn().runCommand( nsToDatabase( coll ) , cmd.obj() , res ) ) {
+            log() << "\t\tcan't split " << coll << " into ranges, dumping it whole: " << res << endl;
+            return splits;
+        }
+        for ( BSONObjIterator it( res.getObjectField( "splitKeys" ) ); it.more(); ) {
+            splits.push_back( it.next().Obj().getOwned() );
+        }
+        return splits;
+    }
+
+    // Dump coll to one file per primary key range in outputDir, reading ranges over
+    // --numParallelRanges connections at once.  Ranges are disjoint, so mongorestore can read
+    // the files in any order.
+    void writeCollectionRanges( const string coll , const BSONObj& pk , const vector<BSONObj>& splits ,
+                                boost::filesystem::path outputDir ) {
+        log() << "\t" << coll << " to " << outputDir.string() << " in " << splits.size() + 1
+              << " ranges" << endl;
+        boost::filesystem::create_directories( outputDir );
+
+        RangeDump rd( coll , pk , splits , outputDir );
+        const int numThreads = std::min( _numParallelRanges , static_cast<int>( splits.size() + 1 ) );
+        boost::thread_group workers;
+        for ( int i = 0; i < numThreads; i++ ) {
+            workers.create_thread( boost::bind( &Dump::rangeWorker , this , &rd ) );
+        }
+        workers.join_all();
+        uassert( 17372 , str::stream() << "failed to dump " << coll << ", see errors above" ,
+                 !rd.failed.load() );
+
+        log() << "\t\t " << rd.objects.load() << " objects" << endl;
+    }
+
+    // Body of each writeCollectionRanges() thread: dump ranges over a connection of its own
+    // until none are left, or until some thread fails.
+    void rangeWorker( RangeDump* rd ) {
+        try {
+            scoped_ptr<DBClientBase> c( newConnection() );
+            DBClientBase* connBase = c.get();
+            if ( connBase->type() == ConnectionString::SET ) {
+                // like conn(true)
+                connBase = &static_cast<DBClientReplicaSet*>( connBase )->slaveConn();
+            }
+
+            for ( size_t i = rd->nextRange.fetchAndAdd(1);
+                  i <= rd->splits.size() && !rd->failed.load();
+                  i = rd->nextRange.fetchAndAdd(1) ) {
+                Query q = _query;
+                q.hint( rd->pk );
+                if ( i > 0 ) {
+                    q.minKey( rd->splits[i - 1] );
+                }
+                if ( i < rd->splits.size() ) {
+                    q.maxKey( rd->splits[i] );
+                }
+
+                stringstream name;
+                name << setw(6) << setfill('0') << i << ".bson";
+                boost::filesystem::path outputFile = rd->dir / name.str();
+                LOG(1) << "\t\trange " << i << " to " << outputFile.string() << endl;
+
+                FilePtr f (fopen(outputFile.string().c_str(), "wb"));
+                uassert(10262, errnoWithPrefix("couldn't open file"), f);
+                doCollection( *connBase , rd->coll , q , f , Writer(f, NULL, &rd->objects) );
+            }
+        }
+        catch ( DBException& e ) {
+            error() << "assertion: " << e.toString() << endl;
+            rd->failed.store(1);
+        }
+        catch ( std::exception& e ) {
+            error() << "error: " << e.what() << endl;
+            rd->failed.store(1);
+        }
+    }
+
+    // Dump coll to outputFile, or to a directory of range files if it's worth splitting.
+    void writeCollection( const string coll , const BSONObj& options ,
+                          boost::filesystem::path outputFile ) {
+        // An earlier dump may have left range files here, which restore would read back too.
+        boost::filesystem::remove_all( outputFile );
+
+        // Capped collections and collections without _id have a hidden primary key, and
+        // partitioned collections are already dumped from several dictionaries.
+        const bool canSplit = _numParallelRanges > 1 && !_usingMongos &&
+                              !NamespaceString( coll ).isSystem() &&
+                              !options["capped"].trueValue() &&
+                              !options["partitioned"].trueValue() &&
+                              ( !options["autoIndexId"].ok() || options["autoIndexId"].trueValue() );
+        if ( canSplit ) {
+            BSONObj stats;
+            if ( conn( true ).runCommand( nsToDatabase( coll ) ,
+                                          BSON( "collStats" << nsToCollectionSubstring( coll ) ) ,
+                                          stats ) ) {
+                // Aim for a few ranges per connection so that slow ranges don't hold up the
+                // rest, but don't bother splitting small collections.
+                const long long rangeBytes = std::max( _minRangeBytes ,
+                                                       stats["size"].numberLong() /
+                                                       ( rangesPerConnection * _numParallelRanges ) );
+                const BSONObj pk = options["primaryKey"].isABSONObj()
+                                   ? options["primaryKey"].Obj()
+                                   : BSON( "_id" << 1 );
+                const vector<BSONObj> splits = splitCollection( coll , pk , rangeBytes );
+                if ( !splits.empty() ) {
+                    // <coll>.bson becomes a directory of range files.
+                    writeCollectionRanges( coll , pk , splits , outputFile );
+                    return;
+                }
+            }
+        }
+        writeCollectionFile( coll , outputFile );
+    }
+
     void writeCollectionFile( const string coll , boost::filesystem::path outputFile ) {
         log() << "\t" << coll << " to " << outputFile.string() << endl;
 
@@ -247,7 +399,7 @@ public:
         for (vector<string>::iterator it = collections.begin(); it != collections.end(); ++it) {
             string name = *it;
             const string filename = name.substr( db.size() + 1 );
-            writeCollectionFile( name , outdir / ( filename + ".bson" ) );
+            writeCollection( name , collectionOptions[name] , outdir / ( filename + ".bson" ) );
             writeMetadataFile( name, outdir / (filename + ".metadata.json"), collectionOptions, indexes, partitionInfo);
         }
 
@@ -334,6 +486,17 @@ public:
 
         _usingMongos = isMongos();
 
+        _numParallelRanges = getParam( "numParallelRanges" , 1 );
+        if ( _numParallelRanges < 1 ) {
+            log() << "--numParallelRanges must be at least 1" << endl;
+            return -1;
+        }
+        if ( hasParam( "dbpath" ) && _numParallelRanges > 1 ) {
+            log() << "warning: dumping over one connection when using --dbpath" << endl;
+            _numParallelRanges = 1;
+        }
+        _minRangeBytes = static_cast<long long>( getParam( "minRangeSizeMB" , 64 ) ) * 1024 * 1024;
+
         boost::filesystem::path root( out );
         string db = _db;
 
@@ -388,8 +551,14 @@ public:
 
     bool _usingMongos;
     BSONObj _query;
+    int _numParallelRanges;
+
+    long long _minRangeBytes;
+
+    static const int rangesPerConnection = 4;
 };
 
+
 int main( int argc , char ** argv, char ** envp ) {
     mongo::runGlobalInitializersOrDie(argc, argv, envp);
     Dump d;
@@ -20,7 +20,9 @@
 #include "mongo/pch.h"
 #include "mongo/db/json.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/tools/tool.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/text.h"
 #include "mongo/base/initializer.h"
 #include "mongo/client/remote_loader.h"
@@ -29,7 +31,9 @@
 #include <iostream>
 #include <boost/program_options.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace mongo;
 using std::string;
@@ -52,6 +56,9 @@ class Import : public Tool {
     vector<string> _upsertFields;
     static const int BUF_SIZE;
 
+    // parseRow's line buffer, allocated once rather than per line
+    boost::scoped_array<char> _rowBuffer;
+
     void csvTokenizeRow(const string& row, vector<string>& tokens) {
         bool inQuotes = false;
         bool prevWasQuote = false;
@@ -146,10 +153,10 @@ class Import : public Tool {
     }
 
     /*
-     * Parses a BSON object out of a JSON array.
+     * Parses a BSON object out of a JSON array.  end is the null terminating the array's buffer.
      * Returns number of bytes processed on success and -1 on failure.
      */
-    int parseJSONArray(char* buf, BSONObj& o) {
+    int parseJSONArray(char* buf, const char* end, BSONObj& o) {
         int len = 0;
         while (buf[0] != '{' && buf[0] != '\0') {
             len++;
@@ -160,7 +167,7 @@ class Import : public Tool {
 
         int jslen;
         try {
-            o = fromjson(buf, &jslen);
+            o = fromjson(buf, end, &jslen);
         } catch ( MsgAssertionException& e ) {
             uasserted(13293, string("BSON representation of supplied JSON array is too large: ") + e.what());
         }
@@ -170,13 +177,15 @@ class Import : public Tool {
     }
 
     /*
-     * Parses one object from the input file.  This usually corresponds to one line in the input
-     * file, unless the file is a CSV and contains a newline within a quoted string entry.
-     * Returns a true if a BSONObj was successfully created and false if not.
+     * Reads one row from the input file.  This usually corresponds to one line in the input file,
+     * unless the file is a CSV and contains a newline within a quoted string entry.
+     * Returns false if the line was empty.
      */
-    bool parseRow(istream* in, BSONObj& o, int& numBytesRead) {
-        boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
-        char* line = buffer.get();
+    bool readRow(istream* in, string& row, int& numBytesRead) {
+        if (!_rowBuffer) {
+            _rowBuffer.reset(new char[BUF_SIZE+2]);
+        }
+        char* line = _rowBuffer.get();
 
         numBytesRead = getLine(in, line);
         line += numBytesRead;
@@ -193,17 +202,12 @@ class Import : public Tool {
                 *end = 0;
                 end--;
             }
-            try {
-                o = fromjson( line );
-            } catch ( MsgAssertionException& e ) {
-                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
-            }
+            row.assign(line, end + 1);
             return true;
         }
 
-        vector<string> tokens;
         if (_type == CSV) {
-            string row;
+            row.clear();
             bool inside_quotes = false;
             size_t last_quote = 0;
             while (true) {
@@ -231,45 +235,290 @@ class Import : public Tool {
             }
             // now 'row' is string corresponding to one row of the CSV file
             // (which may span multiple lines) and represents one BSONObj
+            return true;
+        }
+
+        // _type == TSV
+        while (line[0] != '\t' && isspace(line[0])) { // Strip leading whitespace, but not tabs
+            line++;
+        }
+        row.assign(line);
+        return true;
+    }
+
+    void tokenizeRow(const string& row, vector<string>& tokens) {
+        if (_type == CSV) {
             csvTokenizeRow(row, tokens);
         }
-        else {  // _type == TSV
-            while (line[0] != '\t' && isspace(line[0])) { // Strip leading whitespace, but not tabs
-                line++;
-            }
+        else {
+            boost::split(tokens, row, boost::is_any_of(_sep));
+        }
+    }
 
-            boost::split(tokens, line, boost::is_any_of(_sep));
+    /*
+     * Parses one object out of a row returned by readRow().  May be called on several threads at
+     * once.
+     */
+    BSONObj parseRow(const string& row) {
+        if (_type == JSON) {
+            try {
+                return fromjson( row.c_str(), row.c_str() + row.size(), NULL );
+            } catch ( MsgAssertionException& e ) {
+                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
+            }
         }
 
+        vector<string> tokens;
+        tokenizeRow(row, tokens);
+
         // Now that the row is tokenized, create a BSONObj out of it.
         BSONObjBuilder b;
         unsigned int pos=0;
         for (vector<string>::iterator it = tokens.begin(); it != tokens.end(); ++it) {
-            string token = *it;
-            if ( _headerLine ) {
-                _fields.push_back(token);
+            const string& token = *it;
+            string name;
+            if ( pos < _fields.size() ) {
+                name = _fields[pos];
+            }
+            else {
+                stringstream ss;
+                ss << "field" << pos;
+                name = ss.str();
+            }
+            pos++;
+
+            _append( b , name , token );
+        }
+        return b.obj();
+    }
+
+    /*
+     * Input is read on one thread, in chunks of consecutive rows.  The chunks are parsed by
+     * --numParsingWorkers threads and then inserted, in input order, as one message per chunk
+     * over --numInsertionWorkers connections.  With one insertion worker (the default) documents
+     * are inserted in the order they were read, on the main thread's connection, which is the
+     * only one a bulk load or --dbpath can use.
+     */
+    struct Chunk {
+        Chunk() : bytes(0), parsed(false), errors(0) {}
+        vector<string> rows;
+        int bytes;
+        bool parsed;            // docs and errors are filled in
+        vector<BSONObj> docs;   // the rows that parsed, in order
+        int errors;             // rows that didn't; with --stopOnError, docs stops at the first
+    };
+    typedef boost::shared_ptr<Chunk> ChunkPtr;
+
+    // A chunk is sent once it holds this many rows or bytes of input
+    static const int insertBatchDocs = 1000;
+    static const int insertBatchBytes = 4 * 1024 * 1024;
+
+    int _numParsingWorkers;
+    int _numInsertionWorkers;
+    bool _stopOnError;
+
+    // Chunks to parse, and all chunks in input order to insert.  A null chunk ends each worker.
+    scoped_ptr<BlockingQueue<ChunkPtr> > _toParse;
+    scoped_ptr<BlockingQueue<ChunkPtr> > _toInsert;
+    mongo::mutex _parsedMutex;
+    boost::condition _chunkParsed;
+
+    AtomicUInt32 _stop;                 // set when --stopOnError sees an error
+    AtomicUInt64 _numInserted;
+    AtomicUInt64 _numErrors;
+    AtomicUInt64 _lastErrorFailures;
+
+    // Reads the input into chunks, or parses a --jsonArray itself, until it ends or _stop is set.
+    void readInput(istream* in, long long fileSize) {
+        try {
+            ProgressMeter pm( fileSize );
+            time_t start = time(0);
+            ChunkPtr chunk(new Chunk());
+            if (_jsonArray) {
+                readJSONArray(in, pm, chunk);
             }
             else {
-                string name;
-                if ( pos < _fields.size() ) {
-                    name = _fields[pos];
+                while ( in->rdstate() == 0 && !_stop.load() ) {
+                    int len = 0;
+                    try {
+                        string row;
+                        if (readRow(in, row, len)) {
+                            chunk->rows.push_back(row);
+                            chunk->bytes += row.size();
+                        }
+                    }
+                    catch ( std::exception& e ) {
+                        log() << "exception:" << e.what() << endl;
+                        noteErrors(1);
+                    }
+                    if ( chunk->rows.size() >= (size_t) insertBatchDocs || chunk->bytes >= insertBatchBytes ) {
+                        queueChunk(chunk);
+                        chunk.reset(new Chunk());
+                    }
+                    if ( pm.hit( len + 1 ) ) {
+                        const unsigned long long num = _numInserted.load();
+                        log() << "\t\t\t" << num << "\t" << ( num / std::max<time_t>( time(0) - start, 1 ) ) << "/second" << endl;
+                    }
                 }
-                else {
-                    stringstream ss;
-                    ss << "field" << pos;
-                    name = ss.str();
+            }
+            if ( !chunk->rows.empty() || !chunk->docs.empty() ) {
+                queueChunk(chunk);
+            }
+        }
+        catch ( std::exception& e ) {
+            error() << "error reading input: " << e.what() << endl;
+            noteErrors(1);
+        }
+        for (int i = 0; i < _numParsingWorkers; i++) {
+            _toParse->push(ChunkPtr());
+        }
+        for (int i = 0; i < _numInsertionWorkers; i++) {
+            _toInsert->push(ChunkPtr());
+        }
+    }
+
+    // The whole array is in one buffer, and finding where each object ends means parsing it,
+    // so a --jsonArray is parsed as it is read.
+    void readJSONArray(istream* in, ProgressMeter& pm, ChunkPtr& chunk) {
+        boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
+        char* line = buffer.get();
+        int bytesProcessed = getLine(in, line);
+        line += bytesProcessed;
+        const char* lineEnd = line + strlen(line);
+        pm.hit(bytesProcessed);
+        while ( !_stop.load() ) {
+            BSONObj o;
+            try {
+                if ((bytesProcessed = parseJSONArray(line, lineEnd, o)) < 0) {
+                    break;
                 }
-                pos++;
+            }
+            catch ( std::exception& e ) {
+                log() << "exception:" << e.what() << endl;
+                log() << line << endl;
+                noteErrors(1);
+                // there is no telling where the next object starts
+                break;
+            }
+            line += bytesProcessed;
+            pm.hit(bytesProcessed);
+            chunk->docs.push_back(o);
+            chunk->bytes += o.objsize();
+            if ( chunk->docs.size() >= (size_t) insertBatchDocs || chunk->bytes >= insertBatchBytes ) {
+                queueChunk(chunk);
+                chunk.reset(new Chunk());
+            }
+        }
+    }
 
-                _append( b , name , token );
+    void queueChunk(const ChunkPtr& chunk) {
+        if (chunk->rows.empty()) {
+            chunk->parsed = true;
+        }
+        else {
+            _toParse->push(chunk);
+        }
+        _toInsert->push(chunk);
+    }
+
+    // Body of each parsing thread.
+    void parseWorker() {
+        for (ChunkPtr chunk = _toParse->blockingPop(); chunk; chunk = _toParse->blockingPop()) {
+            for (vector<string>::const_iterator it = chunk->rows.begin(); it != chunk->rows.end(); ++it) {
+                try {
+                    chunk->docs.push_back(parseRow(*it));
+                }
+                catch ( std::exception& e ) {
+                    log() << "exception:" << e.what() << endl;
+                    log() << *it << endl;
+                    chunk->errors++;
+                    if (_stopOnError) {
+                        break;
+                    }
+                }
             }
+            chunk->rows.clear();
+
+            scoped_lock lk(_parsedMutex);
+            chunk->parsed = true;
+            _chunkParsed.notify_all();
+        }
+    }
+
+    // Body of each insertion worker: takes chunks in input order, waits for each to be parsed
+    // and inserts it.  Stops at the end of input or when --stopOnError sees an error.
+    void insertWorker(DBClientBase& c, const string& ns) {
+        for (ChunkPtr chunk = _toInsert->blockingPop(); chunk; chunk = _toInsert->blockingPop()) {
+            {
+                scoped_lock lk(_parsedMutex);
+                while (!chunk->parsed) {
+                    _chunkParsed.wait(lk.boost());
+                }
+            }
+            if (_stop.load()) {
+                continue;
+            }
+            try {
+                if (_doimport) {
+                    insertChunk(c, ns, *chunk);
+                }
+                _numInserted.fetchAndAdd(chunk->docs.size());
+            }
+            catch ( std::exception& e ) {
+                log() << "exception:" << e.what() << endl;
+                noteErrors(1);
+            }
+            if (chunk->errors) {
+                noteErrors(chunk->errors);
+            }
+        }
+    }
+
+    void insertChunk(DBClientBase& c, const string& ns, const Chunk& chunk) {
+        if (chunk.docs.empty()) {
+            return;
+        }
+        if (_upsert) {
+            for (vector<BSONObj>::const_iterator it = chunk.docs.begin(); it != chunk.docs.end(); ++it) {
+                const BSONObj& o = *it;
+                bool doUpsert = true;
+                BSONObjBuilder b;
+                for (vector<string>::const_iterator it=_upsertFields.begin(), end=_upsertFields.end(); it!=end; ++it) {
+                    BSONElement e = o.getFieldDotted(it->c_str());
+                    if (e.eoo()) {
+                        doUpsert = false;
+                        break;
+                    }
+                    b.appendAs(e, *it);
+                }
+
+                if (doUpsert) {
+                    c.update(ns, Query(b.obj()), o, true);
+                }
+                else {
+                    c.insert( ns.c_str() , o );
+                }
+            }
+        }
+        else {
+            // Like single inserts, keep going past documents that fail to insert.
+            c.insert( ns , chunk.docs , InsertOption_ContinueOnError );
+        }
+        if (!checkLastError(c) && _stopOnError) {
+            _stop.store(1);
+        }
+    }
+
+    // Counts errors, and stops the import if --stopOnError was given.
+    void noteErrors(int n) {
+        _numErrors.fetchAndAdd(n);
+        if (_stopOnError) {
+            _stop.store(1);
         }
-        o = b.obj();
-        return true;
     }
 
 public:
-    Import() : Tool( "import" ) {
+    Import() : Tool( "import" ), _parsedMutex( "Import::parsed" ) {
         addFieldOptions();
         add_options()
         ("ignoreBlanks","if given, empty fields in csv and tsv will be ignored")
@@ -281,6 +530,8 @@ public:
         ("upsertFields", po::value<string>(), "comma-separated fields for the query part of the upsert. You should make sure this is indexed" )
         ("stopOnError", "stop importing at first error rather than continuing" )
         ("jsonArray", "load a json array, not one item per line. Currently limited to 16MB." )
+        ("numParsingWorkers", po::value<int>()->default_value(4), "number of threads parsing input; documents are still inserted in input order")
+        ("numInsertionWorkers", po::value<int>()->default_value(1), "number of connections inserting batches in parallel, in no particular order. More than one prevents the bulk load optimization.")
         ;
         add_hidden_options()
         ("noimport", "don't actually import. useful for benchmarking parser" )
@@ -292,6 +543,9 @@ public:
         _upsert = false;
         _doimport = true;
         _jsonArray = false;
+        _numParsingWorkers = 1;
+        _numInsertionWorkers = 1;
+        _stopOnError = false;
     }
     ;
     virtual void printExtraHelp( ostream & out ) {
@@ -301,11 +555,9 @@ public:
         out << "  mongoimport --host myhost --db my_cms --collection docs < mydocfile.json\n" << endl;
     }
 
-    unsigned long long lastErrorFailures;
-
     /** @return true if ok */
-    bool checkLastError() { 
-        string s = conn().getLastError();
+    bool checkLastError(DBClientBase& c) {
+        string s = c.getLastError();
         if( !s.empty() ) { 
             if( str::contains(s,"uplicate") ) {
                 // we don't want to return an error from the mongoimport process for
@@ -313,7 +565,7 @@ public:
                 log() << s << endl;
             }
             else {
-                lastErrorFailures++;
+                _lastErrorFailures.fetchAndAdd(1);
                 log() << "error: " << s << endl;
                 return false;
             }
@@ -324,7 +576,6 @@ public:
     int run() {
         string filename = getParam( "file" );
         long long fileSize = 0;
-        int headerRows = 0;
 
         istream * in = &cin;
 
@@ -356,6 +607,19 @@ public:
 
         LOG(1) << "ns: " << ns << endl;
 
+        // Make sure default values set here stay in sync with the ones set in the constructor.
+        _numParsingWorkers = getParam( "numParsingWorkers" , 4 );
+        _numInsertionWorkers = getParam( "numInsertionWorkers" , 1 );
+        if ( _numParsingWorkers < 1 || _numInsertionWorkers < 1 ) {
+            log() << "--numParsingWorkers and --numInsertionWorkers must be at least 1" << endl;
+            return -1;
+        }
+        if ( hasParam( "dbpath" ) && _numInsertionWorkers > 1 ) {
+            log() << "warning: inserting over one connection when using --dbpath" << endl;
+            _numInsertionWorkers = 1;
+        }
+        _stopOnError = hasParam( "stopOnError" );
+
         if ( hasParam( "drop" ) ) {
             log() << "dropping: " << ns << endl;
             conn().dropCollection( ns.c_str() );
@@ -377,9 +641,15 @@ public:
             }
         }
 
-        _doBulkLoad = !_upsert;
+        if ( _upsert && _numInsertionWorkers > 1 ) {
+            // Later rows must win over earlier ones with the same key.
+            warning() << "upserting over one connection to keep rows in order" << endl;
+            _numInsertionWorkers = 1;
+        }
+
+        _doBulkLoad = !_upsert && _numInsertionWorkers == 1;
         if (!_doBulkLoad) {
-            warning() << "not using bulk load because either upsert/upsertFields was specified" << endl;
+            warning() << "not using bulk load because either upsert/upsertFields or numInsertionWorkers was specified" << endl;
         }
 
         if ( hasParam( "noimport" ) ) {
@@ -406,10 +676,7 @@ public:
 
         if ( _type == CSV || _type == TSV ) {
             _headerLine = hasParam( "headerline" );
-            if ( _headerLine ) {
-                headerRows = 1;
-            }
-            else {
+            if ( !_headerLine ) {
                 needFields();
             }
         }
@@ -418,17 +685,17 @@ public:
             _jsonArray = true;
         }
 
-        time_t start = time(0);
         LOG(1) << "filesize: " << fileSize << endl;
-        ProgressMeter pm( fileSize );
-        int num = 0;
-        int lastNumChecked = num;
-        int errors = 0;
-        lastErrorFailures = 0;
-        int len = 0;
-        // buffer and line are only used when parsing a jsonArray
-        boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
-        char* line = buffer.get();
+
+        if ( _headerLine ) {
+            // The rest of the rows are parsed on other threads, which need the field names.
+            string row;
+            int len = 0;
+            while ( in->rdstate() == 0 && !readRow(in, row, len) ) {
+            }
+            tokenizeRow(row, _fields);
+            _headerLine = false;
+        }
 
         scoped_ptr<RemoteLoader> loader;
         if (_doBulkLoad) {
@@ -437,92 +704,40 @@ public:
             NamespaceString n(ns);
             loader.reset(new RemoteLoader(conn(), n.db, n.coll, vector<BSONObj>(), BSONObj()));
         }
-        while ( _jsonArray || in->rdstate() == 0 ) {
-            try {
-                BSONObj o;
-                if (_jsonArray) {
-                    int bytesProcessed = 0;
-                    if (line == buffer.get()) { // Only read on first pass - the whole array must be on one line.
-                        bytesProcessed = getLine(in, line);
-                        line += bytesProcessed;
-                        len += bytesProcessed;
-                    }
-                    if ((bytesProcessed = parseJSONArray(line, o)) < 0) {
-                        len += bytesProcessed;
-                        break;
-                    }
-                    len += bytesProcessed;
-                    line += bytesProcessed;
-                }
-                else {
-                    if (!parseRow(in, o, len)) {
-                        continue;
-                    }
-                }
 
-                if ( _headerLine ) {
-                    _headerLine = false;
-                }
-                else if (_doimport) {
-                    bool doUpsert = _upsert;
-                    BSONObjBuilder b;
-                    if (_upsert) {
-                        for (vector<string>::const_iterator it=_upsertFields.begin(), end=_upsertFields.end(); it!=end; ++it) {
-                            BSONElement e = o.getFieldDotted(it->c_str());
-                            if (e.eoo()) {
-                                doUpsert = false;
-                                break;
-                            }
-                            b.appendAs(e, *it);
-                        }
-                    }
+        _toParse.reset(new BlockingQueue<ChunkPtr>(2 * _numParsingWorkers + 1));
+        _toInsert.reset(new BlockingQueue<ChunkPtr>(2 * (_numParsingWorkers + _numInsertionWorkers) + 1));
 
-                    if (doUpsert) {
-                        conn().update(ns, Query(b.obj()), o, true);
-                    }
-                    else {
-                        conn().insert( ns.c_str() , o );
-                    }
-
-                    if( num < 10 ) { 
-                        // we absolutely want to check the first and last op of the batch. we do 
-                        // a few more as that won't be too time expensive.
-                        checkLastError();
-                        lastNumChecked = num;
-                    }
-                }
-
-                num++;
-            }
-            catch ( std::exception& e ) {
-                log() << "exception:" << e.what() << endl;
-                log() << line << endl;
-                errors++;
-
-                if (hasParam("stopOnError") || _jsonArray)
-                    break;
-            }
+        vector<boost::shared_ptr<DBClientBase> > connections;
+        for (int i = 1; i < _numInsertionWorkers; i++) {
+            connections.push_back(boost::shared_ptr<DBClientBase>(newConnection()));
+        }
 
-            if ( pm.hit( len + 1 ) ) {
-                log() << "\t\t\t" << num << "\t" << ( num / ( time(0) - start ) ) << "/second" << endl;
-            }
+        boost::thread_group workers;
+        workers.create_thread(boost::bind(&Import::readInput, this, in, fileSize));
+        for (int i = 0; i < _numParsingWorkers; i++) {
+            workers.create_thread(boost::bind(&Import::parseWorker, this));
         }
-        if (loader) {
-            loader->commit();
+        for (size_t i = 0; i < connections.size(); i++) {
+            workers.create_thread(boost::bind(&Import::insertWorker, this,
+                                              boost::ref(*connections[i]), ns));
         }
+        // The main thread's connection is the one a bulk load, or --dbpath, has to use.
+        insertWorker(conn(), ns);
+        workers.join_all();
 
-        // this is for two reasons: to wait for all operations to reach the server and be processed, and this will wait until all data reaches the server,
-        // and secondly to check if there were an error (on the last op)
-        if( lastNumChecked+1 != num ) { // avoid redundant log message if already reported above
-            log() << "check " << lastNumChecked << " " << num << endl;
-            checkLastError();
+        if (loader) {
+            loader->commit();
         }
 
+        const unsigned long long num = _numInserted.load();
+        const unsigned long long errors = _numErrors.load();
+        const unsigned long long lastErrorFailures = _lastErrorFailures.load();
         bool hadErrors = lastErrorFailures || errors;
 
-        // the message is vague on lastErrorFailures as we don't call it on every single operation. 
-        // so if we have a lastErrorFailure there might be more than just what has been counted.
-        log() << (lastErrorFailures ? "tried to import " : "imported ") << ( num - headerRows ) << " objects" << endl;
+        // the message is vague on lastErrorFailures as getLastError only reports the last error of
+        // each batch, so if we have a lastErrorFailure there might be more than just what has been counted.
+        log() << (lastErrorFailures ? "tried to import " : "imported ") << num << " objects" << endl;
 
         if ( !hadErrors )
             return 0;
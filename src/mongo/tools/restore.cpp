@@ -19,17 +19,20 @@
 
 #include "pch.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/convenience.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/program_options.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <fstream>
 #include <set>
 
 #include "mongo/base/initializer.h"
 #include "mongo/db/namespacestring.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/stringutils.h"
 #include "mongo/db/json.h"
@@ -48,10 +51,23 @@ public:
     bool _restoreIndexes;
     int _w;
     bool _doBulkLoad;
-    string _curns;
-    string _curdb;
-    string _curcoll;
-    set<string> _users; // For restoring users with --drop
+    int _numParallelCollections;
+
+    // A collection file to restore, found by drillDown()
+    struct Job {
+        boost::filesystem::path file; // A .bson file, or a directory of range files
+        vector<boost::filesystem::path> rangeFiles; // Files to read, in no particular order
+        string ns;
+        string oldCollName; // Name of the collection that was dumped from
+    };
+    vector<Job> _jobs;
+    AtomicUInt32 _nextJob;
+    AtomicUInt32 _failed;
+
+    // Inserts are sent in batches of at most this many bytes (or one larger object), while the
+    // next few batches are read from the file.
+    static const int insertBatchBytes = 4 * 1024 * 1024;
+    static const int readAheadBatches = 4;
 
     std::string _defaultCompression;
     BytesQuantity<int> _defaultPageSize;
@@ -59,7 +75,7 @@ public:
 
     Restore() : BSONTool( "restore" ),
         _drop(false), _restoreOptions(false), _restoreIndexes(false),
-        _w(0), _doBulkLoad(false) {
+        _w(0), _doBulkLoad(false), _numParallelCollections(1) {
         // Default values set here will show up in help text, but will supercede any default value
         // used when calling getParam below.
         add_options()
@@ -71,6 +87,7 @@ public:
         ("noIndexRestore" , "don't restore indexes")
         ("w" , po::value<int>()->default_value(0) , "minimum number of replicas per write. WARNING, setting w > 1 prevents the bulk load optimization." )
         ("noLoader", "don't use bulk loader")
+        ("numParallelCollections,j", po::value<int>()->default_value(4), "number of collections to restore in parallel, each over its own connection")
         ("defaultCompression", po::value(&_defaultCompression)->default_value(""), "default compression method to use for collections and indexes (unless otherwise specified in metadata.json)")
         ("defaultPageSize", po::value(&_defaultPageSize)->default_value(0), "default pageSize value to use for collections and indexes (unless otherwise specified in metadata.json)")
         ("defaultReadPageSize", po::value(&_defaultReadPageSize)->default_value(0), "default readPageSize value to use for collections and indexes (unless otherwise specified in metadata.json)")
@@ -113,6 +130,16 @@ public:
         if (hasParam( "noLoader" )) {
             _doBulkLoad = false;
         }
+        // Make sure default value set here stays in sync with the one set in the constructor above.
+        _numParallelCollections = getParam( "numParallelCollections" , 4 );
+        if (_numParallelCollections < 1) {
+            log() << "--numParallelCollections must be at least 1" << endl;
+            return -1;
+        }
+        if (hasParam( "dbpath" ) && _numParallelCollections > 1) {
+            log() << "warning: restoring one collection at a time when using --dbpath" << endl;
+            _numParallelCollections = 1;
+        }
         if (hasParam( "keepIndexVersion" )) {
             log() << "warning: --keepIndexVersion is deprecated in TokuMX" << endl;
         }
@@ -133,10 +160,7 @@ public:
          * .bson file, or a single .bson file itself (a collection).
          */
         drillDown(root, _db != "", _coll != "", true);
-        string err = conn().getLastError(_db == "" ? "admin" : _db);
-        if (!err.empty()) {
-            error() << err;
-        }
+        restoreCollections();
 
         return EXIT_CLEAN;
     }
@@ -148,7 +172,7 @@ public:
         if (root.leaf().string()[0] == '.' && root.leaf().string() != ".")
             return;
 
-        if ( is_directory( root ) ) {
+        if ( is_directory( root ) && !isRangeDirectory( root ) ) {
             boost::filesystem::directory_iterator end;
             boost::filesystem::directory_iterator i(root);
             while ( i != end ) {
@@ -156,7 +180,7 @@ public:
                 i++;
 
                 if (use_db) {
-                    if (boost::filesystem::is_directory(p)) {
+                    if (boost::filesystem::is_directory(p) && !isRangeDirectory(p)) {
                         error() << "ERROR: root directory must be a dump of a single database" << endl;
                         error() << "       when specifying a db name with --db" << endl;
                         printHelp(cout);
@@ -165,7 +189,7 @@ public:
                 }
 
                 if (use_coll) {
-                    if (boost::filesystem::is_directory(p) || i != end) {
+                    if ((boost::filesystem::is_directory(p) && !isRangeDirectory(p)) || i != end) {
                         error() << "ERROR: root directory must be a dump of a single collection" << endl;
                         error() << "       when specifying a collection name with --collection" << endl;
                         printHelp(cout);
@@ -225,120 +249,83 @@ public:
             ns += "." + oldCollName;
         }
 
-        log() << "\tgoing into namespace [" << ns << "]" << endl;
-
-        if ( _drop ) {
-            if (root.leaf() != "system.users.bson" ) {
-                log() << "\t dropping" << endl;
-                conn().dropCollection( ns );
-            } else {
-                // Create map of the users currently in the DB
-                BSONObj fields = BSON("user" << 1);
-                scoped_ptr<DBClientCursor> cursor(conn().query(ns, Query(), 0, 0, &fields));
-                while (cursor->more()) {
-                    BSONObj user = cursor->next();
-                    _users.insert(user["user"].String());
+        Job job;
+        job.file = root;
+        job.ns = ns;
+        job.oldCollName = oldCollName;
+        if (isRangeDirectory(root)) {
+            boost::filesystem::directory_iterator end;
+            for (boost::filesystem::directory_iterator i(root); i != end; ++i) {
+                boost::filesystem::path p = *i;
+                if (endsWith(p.string().c_str(), ".bson")) {
+                    job.rangeFiles.push_back(p);
                 }
             }
+            log() << "\t" << job.rangeFiles.size() << " range files" << endl;
         }
-
-        BSONObj metadataObject;
-        if (_restoreOptions || _restoreIndexes) {
-            boost::filesystem::path metadataFile = (root.branch_path() / (oldCollName + ".metadata.json"));
-            if (!boost::filesystem::exists(metadataFile.string())) {
-                // This is fine because dumps from before 2.1 won't have a metadata file, just print a warning.
-                // System collections shouldn't have metadata so don't warn if that file is missing.
-                if (!startsWith(metadataFile.leaf().string(), "system.")) {
-                    log() << metadataFile.string() << " not found. Skipping." << endl;
-                }
-            } else {
-                metadataObject = parseMetadataFile(metadataFile.string());
-            }
+        else {
+            job.rangeFiles.push_back(root);
         }
+        _jobs.push_back(job);
+    }
 
-        _curns = ns.c_str();
-        NamespaceString nss(_curns);
-        _curdb = nss.db;
-        _curcoll = nss.coll;
+    // mongodump --numParallelRanges writes large collections as a <collection>.bson directory
+    // holding one file per primary key range.  Database directories can't have a "." in their
+    // names, so there's no confusing the two.
+    static bool isRangeDirectory( const boost::filesystem::path &p ) {
+        return boost::filesystem::is_directory(p) && endsWith(p.string().c_str(), ".bson");
+    }
 
-        // If drop is not used, warn if the collection exists.
-        if (!_drop) {
-            scoped_ptr<DBClientCursor> cursor(conn().query(_curdb + ".system.namespaces",
-                                                            Query(BSON("name" << ns))));
-            if (cursor->more()) {
-                // collection already exists show warning
-                warning() << "Restoring to " << ns << " without dropping. Restored data "
-                             "will be inserted without raising errors; check your server log"
-                             << endl;
+    // Restore the collections found by drillDown(), several at a time if asked to.
+    void restoreCollections() {
+        const int numThreads = std::min(_numParallelCollections, static_cast<int>(_jobs.size()));
+        if (numThreads <= 1) {
+            for (vector<Job>::const_iterator it = _jobs.begin(); it != _jobs.end(); ++it) {
+                CollectionRestore(*this, conn(), *it).run();
             }
+            return;
         }
 
-        vector<BSONObj> indexes;
-        if (_restoreIndexes && metadataObject.hasField("indexes")) {
-            const vector<BSONElement> indexElements = metadataObject["indexes"].Array();
-            for (vector<BSONElement>::const_iterator it = indexElements.begin(); it != indexElements.end(); ++it) {
-                // Need to make sure the ns field gets updated to
-                // the proper _curdb + _curns value, if we're
-                // restoring to a different database.
-                // Also need to update the options with any defaults specified on the command line
-                indexes.push_back(updateOptions(renameIndexNs(it->Obj())));
-            }
+        log() << "restoring " << _jobs.size() << " collections using " << numThreads
+              << " threads" << endl;
+        boost::thread_group workers;
+        for (int i = 0; i < numThreads; i++) {
+            workers.create_thread(boost::bind(&Restore::restoreWorker, this));
         }
-        const BSONObj options = updateOptions(_restoreOptions && metadataObject.hasField("options")
-                                              ? metadataObject["options"].Obj()
-                                              : BSONObj());
-
-        if (_doBulkLoad && !options["partitioned"].trueValue()) {
-            RemoteLoader loader(conn(), _curdb, _curcoll, indexes, options);
-            processFile( root );
-            BSONObj res;
-            bool ok = loader.commit(&res);
-            if (!ok) {
-                error() << "Error committing load for " << _curdb << "." << _curcoll << ": " << res << endl;
-            }
-        } else {
-            // No bulk load. Create collection and indexes manually.
-            if (!options.isEmpty()) {
-                createCollectionWithOptions(options, metadataObject);
-            }
-            // Build indexes last - it's a little faster.
-            processFile( root );
-            for (vector<BSONObj>::iterator it = indexes.begin(); it != indexes.end(); ++it) {
-                createIndex(*it);
+        workers.join_all();
+        uassert(17371, "failed to restore all collections, see errors above", !_failed.load());
+    }
+
+    // Body of each restoreCollections() thread: restore collections over a connection of its
+    // own until none are left, or until some thread fails.
+    void restoreWorker() {
+        try {
+            scoped_ptr<DBClientBase> c(newConnection());
+            for (const Job *job = nextJob(); job != NULL; job = nextJob()) {
+                CollectionRestore(*this, *c, *job).run();
             }
         }
+        catch (DBException &e) {
+            error() << "assertion: " << e.toString() << endl;
+            _failed.store(1);
+        }
+        catch (std::exception &e) {
+            error() << "error: " << e.what() << endl;
+            _failed.store(1);
+        }
+    }
 
-        if (_drop && root.leaf() == "system.users.bson") {
-            // Delete any users that used to exist but weren't in the dump file
-            for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
-                BSONObj userMatch = BSON("user" << *it);
-                conn().remove(ns, Query(userMatch));
-            }
-            _users.clear();
+    const Job *nextJob() {
+        if (_failed.load()) {
+            return NULL;
         }
+        const size_t i = _nextJob.fetchAndAdd(1);
+        return i < _jobs.size() ? &_jobs[i] : NULL;
     }
 
     virtual void gotObject( const BSONObj& obj ) {
-        StringData collstr = nsToCollectionSubstring(_curns);
-        massert( 16910, "Shouldn't be inserting into system.indexes directly",
-                        collstr != "system.indexes" );
-        if (_drop && collstr == "system.users" && _users.count(obj["user"].String())) {
-            // Since system collections can't be dropped, we have to manually
-            // replace the contents of the system.users collection
-            BSONObj userMatch = BSON("user" << obj["user"].String());
-            conn().update(_curns, Query(userMatch), obj);
-            _users.erase(obj["user"].String());
-        } else {
-            conn().insert( _curns , obj );
-
-            // wait for insert to propagate to "w" nodes (doesn't warn if w used without replset)
-            if ( _w > 0 ) {
-                string err = conn().getLastError(_curdb, false, false, _w);
-                if (!err.empty()) {
-                    error() << err << endl;
-                }
-            }
-        }
+        // Collections are restored in batches by CollectionRestore, see processFileInBatches().
+        msgasserted(17393, "mongorestore reads collections in batches, not one object at a time");
     }
 
 private:
@@ -406,114 +393,270 @@ private:
         return nfields == obj2.nFields();
     }
 
-    void createCollectionWithOptions(BSONObj obj, BSONObj metadataObject) {
-        BSONObjIterator i(obj);
+    // Restores one collection file over one connection.
+    class CollectionRestore : public BSONTool::BatchHandler {
+    public:
+        CollectionRestore(Restore &restore, DBClientBase &conn, const Job &job)
+            : _restore(restore), _conn(conn), _job(job), _curns(job.ns) {
+            NamespaceString nss(_curns);
+            _curdb = nss.db;
+            _curcoll = nss.coll;
+        }
 
-        // Rebuild obj as a command object for the "create" command.
-        // - {create: <name>} comes first, where <name> is the new name for the collection
-        // - elements with type Undefined get skipped over
-        BSONObjBuilder bo;
-        bo.append("create", _curcoll);
-        while (i.more()) {
-            BSONElement e = i.next();
+        void run() {
+            log() << "\tgoing into namespace [" << _curns << "]" << endl;
 
-            if (strcmp(e.fieldName(), "create") == 0) {
-                continue;
+            if ( _restore._drop ) {
+                if (_job.file.leaf() != "system.users.bson" ) {
+                    log() << "\t dropping" << endl;
+                    conn().dropCollection( _curns );
+                } else {
+                    // Create map of the users currently in the DB
+                    BSONObj fields = BSON("user" << 1);
+                    scoped_ptr<DBClientCursor> cursor(conn().query(_curns, Query(), 0, 0, &fields));
+                    while (cursor->more()) {
+                        BSONObj user = cursor->next();
+                        _users.insert(user["user"].String());
+                    }
+                }
             }
 
-            if (e.type() == Undefined) {
-                log() << _curns << ": skipping undefined field: " << e.fieldName() << endl;
-                continue;
+            BSONObj metadataObject;
+            if (_restore._restoreOptions || _restore._restoreIndexes) {
+                boost::filesystem::path metadataFile = (_job.file.branch_path() / (_job.oldCollName + ".metadata.json"));
+                if (!boost::filesystem::exists(metadataFile.string())) {
+                    // This is fine because dumps from before 2.1 won't have a metadata file, just print a warning.
+                    // System collections shouldn't have metadata so don't warn if that file is missing.
+                    if (!startsWith(metadataFile.leaf().string(), "system.")) {
+                        log() << metadataFile.string() << " not found. Skipping." << endl;
+                    }
+                } else {
+                    metadataObject = _restore.parseMetadataFile(metadataFile.string());
+                }
             }
 
-            bo.append(e);
-        }
-        obj = bo.obj();
+            // If drop is not used, warn if the collection exists.
+            if (!_restore._drop) {
+                scoped_ptr<DBClientCursor> cursor(conn().query(_curdb + ".system.namespaces",
+                                                                Query(BSON("name" << _curns))));
+                if (cursor->more()) {
+                    // collection already exists show warning
+                    warning() << "Restoring to " << _curns << " without dropping. Restored data "
+                                 "will be inserted without raising errors; check your server log"
+                                 << endl;
+                }
+            }
 
-        BSONObj fields = BSON("options" << 1);
-        scoped_ptr<DBClientCursor> cursor(conn().query(_curdb + ".system.namespaces", Query(BSON("name" << _curns)), 0, 0, &fields));
+            vector<BSONObj> indexes;
+            if (_restore._restoreIndexes && metadataObject.hasField("indexes")) {
+                const vector<BSONElement> indexElements = metadataObject["indexes"].Array();
+                for (vector<BSONElement>::const_iterator it = indexElements.begin(); it != indexElements.end(); ++it) {
+                    // Need to make sure the ns field gets updated to
+                    // the proper _curdb + _curns value, if we're
+                    // restoring to a different database.
+                    // Also need to update the options with any defaults specified on the command line
+                    indexes.push_back(_restore.updateOptions(renameIndexNs(it->Obj())));
+                }
+            }
+            const BSONObj options = _restore.updateOptions(_restore._restoreOptions && metadataObject.hasField("options")
+                                                  ? metadataObject["options"].Obj()
+                                                  : BSONObj());
 
-        bool createColl = true;
-        if (cursor->more()) {
-            createColl = false;
-            if (metadataObject["partitioned"].trueValue()) {
-                log() << "Collection " << _curns << " already exists, so we will not be creating the automatic partitions" << endl;
+            if (_restore._doBulkLoad && !options["partitioned"].trueValue()) {
+                RemoteLoader loader(conn(), _curdb, _curcoll, indexes, options);
+                processFile();
+                BSONObj res;
+                bool ok = loader.commit(&res);
+                if (!ok) {
+                    error() << "Error committing load for " << _curdb << "." << _curcoll << ": " << res << endl;
+                }
+            } else {
+                // No bulk load. Create collection and indexes manually.
+                if (!options.isEmpty()) {
+                    createCollectionWithOptions(options, metadataObject);
+                }
+                // Build indexes last - it's a little faster.
+                processFile();
+                for (vector<BSONObj>::iterator it = indexes.begin(); it != indexes.end(); ++it) {
+                    createIndex(*it);
+                }
             }
-            BSONObj nsObj = cursor->next();
-            if (!nsObj.hasField("options") || !optionsSame(obj, nsObj["options"].Obj())) {
-                    log() << "WARNING: collection " << _curns << " exists with different options than are in the metadata.json file and not using --drop. Options in the metadata file will be ignored." << endl;
+
+            if (_restore._drop && _job.file.leaf() == "system.users.bson") {
+                // Delete any users that used to exist but weren't in the dump file
+                for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
+                    BSONObj userMatch = BSON("user" << *it);
+                    conn().remove(_curns, Query(userMatch));
+                }
+                _users.clear();
             }
         }
 
-        if (!createColl) {
-            return;
-        }
+        virtual void gotBatch( const vector<BSONObj>& batch ) {
+            StringData collstr = nsToCollectionSubstring(_curns);
+            massert( 16910, "Shouldn't be inserting into system.indexes directly",
+                            collstr != "system.indexes" );
+            vector<BSONObj> inserts;
+            const vector<BSONObj> *toInsert = &batch;
+            if (_restore._drop && collstr == "system.users") {
+                for (vector<BSONObj>::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+                    const BSONObj &obj = *it;
+                    if (_users.count(obj["user"].String())) {
+                        // Since system collections can't be dropped, we have to manually
+                        // replace the contents of the system.users collection
+                        BSONObj userMatch = BSON("user" << obj["user"].String());
+                        conn().update(_curns, Query(userMatch), obj);
+                        _users.erase(obj["user"].String());
+                    } else {
+                        inserts.push_back(obj);
+                    }
+                }
+                toInsert = &inserts;
+            }
+            if (toInsert->empty()) {
+                return;
+            }
 
-        BSONObj info;
-        if (!conn().runCommand(_curdb, obj, info)) {
-            uasserted(15936, "Creating collection " + _curns + " failed. Errmsg: " + info["errmsg"].String());
-        } else {
-            log() << "\tCreated collection " << _curns << " with options: " << obj.jsonString() << endl;
-            if (metadataObject["partitionInfo"].trueValue()) {
-                BSONObj res;
-                BSONObjBuilder b;
-                b.append("clonePartitionInfo", obj["create"].String());
-                BSONObj pInfo = metadataObject["partitionInfo"].Obj();
-                b.appendAs(pInfo["partitions"], "info");
-                BSONObj o = b.obj();
-                log() << "the obj, " << o << endl;
-                bool ok = conn().runCommand(_curdb, o, info);
-                log() << "ok: " << ok << "info: " << info << endl;
+            // Like single inserts, keep going past objects that fail to insert.
+            conn().insert( _curns , *toInsert , InsertOption_ContinueOnError );
+
+            // Report the batch's last error, and with --w wait for the inserts to propagate to
+            // "w" nodes (doesn't warn if w used without replset).
+            string err = conn().getLastError(_curdb, false, false, _restore._w > 0 ? _restore._w : 0);
+            if (!err.empty()) {
+                error() << "error inserting into " << _curns << ": " << err << endl;
+                _restore._failed.store(1);
             }
         }
-    }
 
-    BSONObj renameIndexNs(const BSONObj &orig) {
-        BSONObjBuilder bo;
-        BSONObjIterator i(orig);
-        while ( i.more() ) {
-            BSONElement e = i.next();
-            if (strcmp(e.fieldName(), "ns") == 0) {
-                string s = _curdb + "." + _curcoll;
-                bo.append("ns", s);
+    private:
+        DBClientBase &conn() { return _conn; }
+
+        void processFile() {
+            // Ranges are disjoint, so they may be inserted in any order.
+            for (vector<boost::filesystem::path>::const_iterator it = _job.rangeFiles.begin();
+                 it != _job.rangeFiles.end(); ++it) {
+                _restore.processFileInBatches(*it, *this, insertBatchBytes, readAheadBatches);
             }
-            else if (strcmp(e.fieldName(), "v") != 0) { // Remove index version number
+        }
+
+        void createCollectionWithOptions(BSONObj obj, BSONObj metadataObject) {
+            BSONObjIterator i(obj);
+
+            // Rebuild obj as a command object for the "create" command.
+            // - {create: <name>} comes first, where <name> is the new name for the collection
+            // - elements with type Undefined get skipped over
+            BSONObjBuilder bo;
+            bo.append("create", _curcoll);
+            while (i.more()) {
+                BSONElement e = i.next();
+
+                if (strcmp(e.fieldName(), "create") == 0) {
+                    continue;
+                }
+
+                if (e.type() == Undefined) {
+                    log() << _curns << ": skipping undefined field: " << e.fieldName() << endl;
+                    continue;
+                }
+
                 bo.append(e);
             }
-        }
-        return bo.obj();
-    }
+            obj = bo.obj();
 
-    /* We must handle if the dbname or collection name is different at restore time than what was dumped.
-     */
-    void createIndex(BSONObj indexObj) {
-        LOG(0) << "\tCreating index: " << indexObj << endl;
-        conn().insert( _curdb + ".system.indexes" ,  indexObj );
+            BSONObj fields = BSON("options" << 1);
+            scoped_ptr<DBClientCursor> cursor(conn().query(_curdb + ".system.namespaces", Query(BSON("name" << _curns)), 0, 0, &fields));
 
-        // We're stricter about errors for indexes than for regular data
-        BSONObj err = conn().getLastErrorDetailed(_curdb, false, false, _w);
+            bool createColl = true;
+            if (cursor->more()) {
+                createColl = false;
+                if (metadataObject["partitioned"].trueValue()) {
+                    log() << "Collection " << _curns << " already exists, so we will not be creating the automatic partitions" << endl;
+                }
+                BSONObj nsObj = cursor->next();
+                if (!nsObj.hasField("options") || !_restore.optionsSame(obj, nsObj["options"].Obj())) {
+                        log() << "WARNING: collection " << _curns << " exists with different options than are in the metadata.json file and not using --drop. Options in the metadata file will be ignored." << endl;
+                }
+            }
 
-        if (err.hasField("err") && !err["err"].isNull()) {
-            if (err["err"].str() == "norepl" && _w > 1) {
-                error() << "Cannot specify write concern for non-replicas" << endl;
+            if (!createColl) {
+                return;
             }
-            else {
-                string errCode;
 
-                if (err.hasField("code")) {
-                    errCode = str::stream() << err["code"].numberInt();
+            BSONObj info;
+            if (!conn().runCommand(_curdb, obj, info)) {
+                uasserted(15936, "Creating collection " + _curns + " failed. Errmsg: " + info["errmsg"].String());
+            } else {
+                log() << "\tCreated collection " << _curns << " with options: " << obj.jsonString() << endl;
+                if (metadataObject["partitionInfo"].trueValue()) {
+                    BSONObj res;
+                    BSONObjBuilder b;
+                    b.append("clonePartitionInfo", obj["create"].String());
+                    BSONObj pInfo = metadataObject["partitionInfo"].Obj();
+                    b.appendAs(pInfo["partitions"], "info");
+                    BSONObj o = b.obj();
+                    log() << "the obj, " << o << endl;
+                    bool ok = conn().runCommand(_curdb, o, info);
+                    log() << "ok: " << ok << "info: " << info << endl;
                 }
+            }
+        }
 
-                error() << "Error creating index " << indexObj["ns"].String() << ": "
-                        << errCode << " " << err["err"] << endl;
+        BSONObj renameIndexNs(const BSONObj &orig) {
+            BSONObjBuilder bo;
+            BSONObjIterator i(orig);
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                if (strcmp(e.fieldName(), "ns") == 0) {
+                    string s = _curdb + "." + _curcoll;
+                    bo.append("ns", s);
+                }
+                else if (strcmp(e.fieldName(), "v") != 0) { // Remove index version number
+                    bo.append(e);
+                }
             }
+            return bo.obj();
+        }
 
-            ::abort();
+        /* We must handle if the dbname or collection name is different at restore time than what was dumped.
+         */
+        void createIndex(BSONObj indexObj) {
+            LOG(0) << "\tCreating index: " << indexObj << endl;
+            conn().insert( _curdb + ".system.indexes" ,  indexObj );
+
+            // We're stricter about errors for indexes than for regular data
+            BSONObj err = conn().getLastErrorDetailed(_curdb, false, false, _restore._w);
+
+            if (err.hasField("err") && !err["err"].isNull()) {
+                if (err["err"].str() == "norepl" && _restore._w > 1) {
+                    error() << "Cannot specify write concern for non-replicas" << endl;
+                }
+                else {
+                    string errCode;
+
+                    if (err.hasField("code")) {
+                        errCode = str::stream() << err["code"].numberInt();
+                    }
+
+                    error() << "Error creating index " << indexObj["ns"].String() << ": "
+                            << errCode << " " << err["err"] << endl;
+                }
+
+                ::abort();
+            }
+
+            massert(16441, str::stream() << "Error calling getLastError: " << err["errmsg"],
+                    err["ok"].trueValue());
         }
 
-        massert(16441, str::stream() << "Error calling getLastError: " << err["errmsg"],
-                err["ok"].trueValue());
-    }
+        Restore &_restore;
+        DBClientBase &_conn;
+        const Job &_job;
+        string _curns;
+        string _curdb;
+        string _curcoll;
+        set<string> _users; // For restoring users with --drop
+    };
 };
 
 int main( int argc , char ** argv, char ** envp ) {
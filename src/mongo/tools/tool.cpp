@@ -19,7 +19,9 @@
 
 #include "mongo/tools/tool.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <boost/thread/thread.hpp>
 #include <fstream>
 #include <iostream>
 
@@ -31,8 +33,10 @@
 #include "mongo/db/collection.h"
 #include "mongo/db/txn_complete_hooks.h"
 #include "mongo/db/storage/env.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/posix_fadvise.h"
 #include "mongo/util/password.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/version.h"
 
 using namespace std;
@@ -326,6 +330,22 @@ namespace mongo {
         return *_conn;
     }
 
+    DBClientBase* Tool::newConnection() {
+        uassert( 17366 , "can't open more connections when using --dbpath" ,
+                 !hasParam( "dbpath" ) );
+
+        string errmsg;
+        ConnectionString cs = ConnectionString::parse( _host , errmsg );
+        uassert( 17367 , str::stream() << "invalid hostname [" << _host << "] " << errmsg ,
+                 cs.isValid() );
+
+        auto_ptr<DBClientBase> c( cs.connect( errmsg ) );
+        uassert( 17368 , str::stream() << "couldn't connect to [" << _host << "] " << errmsg ,
+                 c.get() );
+        auth( *c );
+        return c.release();
+    }
+
     bool Tool::isMaster() {
         if ( hasParam("dbpath") ) {
             return true;
@@ -432,7 +452,14 @@ namespace mongo {
             return;
         }
 
-        _conn->auth( BSON( saslCommandPrincipalSourceFieldName << getAuthenticationDatabase() <<
+        auth( *_conn );
+    }
+
+    void Tool::auth( DBClientBase &conn ) {
+        if ( _username.empty() )
+            return;
+
+        conn.auth( BSON( saslCommandPrincipalSourceFieldName << getAuthenticationDatabase() <<
                            saslCommandPrincipalFieldName << _username <<
                            saslCommandPasswordFieldName << _password  <<
                            saslCommandMechanismFieldName << _authenticationMechanism ) );
@@ -456,27 +483,137 @@ namespace mongo {
             _objcheck = false;
 
         if ( hasParam( "filter" ) )
-            _matcher.reset( new Matcher( fromjson( getParam( "filter" ) ) ) );
+            _filter = fromjson( getParam( "filter" ) );
 
         return doRun();
     }
 
     long long BSONTool::processFile( const boost::filesystem::path& root ) {
         _fileName = root.string();
+        return readFile( root , boost::bind( &BSONTool::gotObject , this , _1 ) );
+    }
+
+    /**
+     * Hands the batches built by the reader thread of processFileInBatches() to the handler.
+     * An empty batch pointer marks the end of the file.
+     */
+    class BSONTool::BatchReader : boost::noncopyable {
+    public:
+        typedef boost::shared_ptr< vector<BSONObj> > Batch;
+
+        BatchReader( int maxBatchBytes , int readAhead ) :
+            _maxBatchBytes( maxBatchBytes ), _batchBytes( 0 ), _queue( readAhead + 1 ),
+            _count( 0 ), _aborted( 0 ) {}
+
+        /** Called by the reader thread for each object in the file. */
+        void gotObject( const BSONObj& obj ) {
+            uassert( 17369 , "reading aborted" , !_aborted.load() );
+            if ( _batch && _batchBytes + obj.objsize() > _maxBatchBytes )
+                flush();
+            if ( ! _batch )
+                _batch.reset( new vector<BSONObj>() );
+            _batch->push_back( obj.getOwned() );
+            _batchBytes += obj.objsize();
+        }
+
+        /** Called by the reader thread when it is done, successfully or not. */
+        void finish( long long count , const string& error ) {
+            if ( error.empty() )
+                flush();
+            _count = count;
+            _error = error;
+            _queue.push( Batch() );
+        }
+
+        /** Called by the handler's thread; returns an empty pointer at the end. */
+        Batch pop() { return _queue.blockingPop(); }
+
+        /** Called by the handler's thread to stop the reader, which may be blocked on us. */
+        void abort() {
+            _aborted.store( 1 );
+            while ( pop() ) {
+            }
+        }
+
+        /* only valid once pop() has returned the end marker */
+        long long count() const { return _count; }
+        const string& error() const { return _error; }
+
+    private:
+        void flush() {
+            if ( ! _batch )
+                return;
+            _queue.push( _batch );
+            _batch.reset();
+            _batchBytes = 0;
+        }
+
+        const int _maxBatchBytes;
+        Batch _batch;
+        int _batchBytes;
+        BlockingQueue<Batch> _queue;
+        long long _count;
+        string _error;
+        AtomicUInt32 _aborted;
+    };
+
+    void BSONTool::readBatches( const boost::filesystem::path& root , BatchReader* reader ) {
+        long long count = 0;
+        string error;
+        try {
+            count = readFile( root , boost::bind( &BatchReader::gotObject , reader , _1 ) );
+        }
+        catch ( DBException& e ) {
+            error = e.toString();
+        }
+        catch ( std::exception& e ) {
+            error = e.what();
+        }
+        reader->finish( count , error );
+    }
+
+    long long BSONTool::processFileInBatches( const boost::filesystem::path& root ,
+                                              BatchHandler& handler ,
+                                              int maxBatchBytes , int readAhead ) {
+        BatchReader reader( maxBatchBytes , readAhead );
+        boost::thread readerThread( boost::bind( &BSONTool::readBatches , this , root , &reader ) );
+        try {
+            for ( BatchReader::Batch batch = reader.pop(); batch; batch = reader.pop() ) {
+                handler.gotBatch( *batch );
+            }
+        }
+        catch ( ... ) {
+            reader.abort();
+            readerThread.join();
+            throw;
+        }
+        readerThread.join();
+
+        uassert( 17370 , str::stream() << "error reading " << root.string() << ": "
+                                       << reader.error() ,
+                 reader.error().empty() );
+        return reader.count();
+    }
+
+    long long BSONTool::readFile( const boost::filesystem::path& root ,
+                                  const boost::function<void (const BSONObj&)>& gotObj ) {
+        const string fileName = root.string();
 
         unsigned long long fileLength = file_size( root );
 
         if ( fileLength == 0 ) {
-            out() << "file " << _fileName << " empty, skipping" << endl;
+            out() << "file " << fileName << " empty, skipping" << endl;
             return 0;
         }
 
 
-        FILE* file = fopen( _fileName.c_str() , "rb" );
+        FILE* file = fopen( fileName.c_str() , "rb" );
         if ( ! file ) {
-            log() << "error opening file: " << _fileName << " " << errnoWithDescription() << endl;
+            log() << "error opening file: " << fileName << " " << errnoWithDescription() << endl;
             return 0;
         }
+        // gotObj may throw, see BatchReader::abort()
+        boost::shared_ptr<FILE> fileCloser( file , fclose );
 
 #ifdef POSIX_FADV_SEQUENTIAL
         posix_fadvise(fileno(file), 0, fileLength, POSIX_FADV_SEQUENTIAL);
@@ -492,6 +629,10 @@ namespace mongo {
         boost::scoped_array<char> buf_holder(new char[BUF_SIZE]);
         char * buf = buf_holder.get();
 
+        scoped_ptr<Matcher> matcher;
+        if ( ! _filter.isEmpty() )
+            matcher.reset( new Matcher( _filter ) );
+
         ProgressMeter m( fileLength );
         m.setUnits( "bytes" );
 
@@ -523,8 +664,8 @@ namespace mongo {
                 }
             }
 
-            if ( _matcher.get() == 0 || _matcher->matches( o ) ) {
-                gotObject( o );
+            if ( ! matcher || matcher->matches( o ) ) {
+                gotObj( o );
                 processed++;
             }
 
@@ -534,11 +675,11 @@ namespace mongo {
             m.hit( o.objsize() );
         }
 
-        fclose( file );
+        fileCloser.reset();
 
         uassert( 10265 ,  "counts don't match" , m.done() == fileLength );
         (_usesstdout ? cout : cerr ) << m.hits() << " objects found" << endl;
-        if ( _matcher.get() )
+        if ( matcher )
             (_usesstdout ? cout : cerr ) << processed << " objects processed" << endl;
         return processed;
     }
@@ -20,6 +20,7 @@
 
 #include <string>
 
+#include <boost/function.hpp>
 #include <boost/program_options.hpp>
 
 #if defined(_WIN32)
@@ -106,6 +107,13 @@ namespace mongo {
 
         mongo::DBClientBase &conn( bool slaveIfPaired = false );
 
+        /**
+         * Open and authenticate another connection to the server conn() talks to, for tools
+         * that work on several threads.  Not available when using --dbpath.
+         * The caller owns the returned connection.
+         */
+        mongo::DBClientBase *newConnection();
+
         string _name;
 
         string _db;
@@ -144,11 +152,13 @@ namespace mongo {
 
     private:
         void auth();
+        void auth( DBClientBase &conn );
     };
 
     class BSONTool : public Tool {
         bool _objcheck;
-        auto_ptr<Matcher> _matcher;
+        // each file being read gets its own Matcher, as those may be read on several threads
+        BSONObj _filter;
 
     public:
         BSONTool( const char * name , DBAccess access=ALL, bool objcheck = true );
@@ -160,6 +170,29 @@ namespace mongo {
 
         long long processFile( const boost::filesystem::path& file );
 
+        /** Receives the objects of a BSON file from processFileInBatches(). */
+        class BatchHandler {
+        public:
+            virtual ~BatchHandler() {}
+            virtual void gotBatch( const vector<BSONObj>& batch ) = 0;
+        };
+
+        /**
+         * Like processFile(), but the file is read, validated and filtered on a separate thread
+         * that stays up to readAhead batches ahead of the handler.  Each batch holds owned
+         * objects totalling at most maxBatchBytes, or a single larger object.
+         * Several threads may process files at once, each with its own handler.
+         */
+        long long processFileInBatches( const boost::filesystem::path& file ,
+                                        BatchHandler& handler ,
+                                        int maxBatchBytes , int readAhead );
+
+    private:
+        class BatchReader;
+
+        long long readFile( const boost::filesystem::path& file ,
+                            const boost::function<void (const BSONObj&)>& gotObj );
+        void readBatches( const boost::filesystem::path& file , BatchReader* reader );
     };
 
 }